@@ -32,6 +32,31 @@
 
 namespace schnek {
 
+/** The dimensions of the array returned by getRawData() for grids in C ordering */
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+inline Array<int,rank> getHdfMemoryDims(const SingleArrayGridCOrderStorageBase<T, rank, AllocationPolicy> *storage)
+{
+  return storage->getDims();
+}
+
+/** */
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+inline Array<int,rank> getHdfMemoryDims(const SingleArrayGridFortranOrderStorageBase<T, rank, AllocationPolicy> *storage)
+{
+  return storage->getDims();
+}
+
+/** The rows of aligned grids are padded in memory
+ *
+ *  Grids with other storage policies do not keep their data in a single
+ *  dense array and cannot be written, so there is no overload for them.
+ */
+template<typename T, int rank>
+inline Array<int,rank> getHdfMemoryDims(const AlignedArrayGridStorage<T, rank> *storage)
+{
+  return storage->getPaddedDims();
+}
+
 
 template<typename FieldType>
 void HdfIStream::readGrid(GridContainer<FieldType> &g)
@@ -44,6 +69,7 @@ void HdfIStream::readGrid(GridContainer<FieldType> &g)
   IndexType mdims = g.grid->getDims();
   IndexType mlo = g.grid->getLo();
   IndexType mhi = g.grid->getHi();
+  IndexType adims = getHdfMemoryDims(g.grid);
 
   IndexType llo = g.local_min;
   IndexType lhi = g.local_max;
@@ -53,6 +79,8 @@ void HdfIStream::readGrid(GridContainer<FieldType> &g)
 
   hsize_t locdims[FieldType::Rank];
   hsize_t memdims[FieldType::Rank];
+  hsize_t allocdims[FieldType::Rank];
+  hsize_t zero[FieldType::Rank];
   hsize_t locstart[FieldType::Rank];
   hsize_t memstart[FieldType::Rank];
 
@@ -64,6 +92,8 @@ void HdfIStream::readGrid(GridContainer<FieldType> &g)
     locdims[i]  = lhi[i] - llo[i] + 1;
     locstart[i] = llo[i] - gmin;
     memdims[i] = mhi[i] - mlo[i] + 1;
+    allocdims[i] = adims[i];
+    zero[i] = 0;
     memstart[i] = llo[i] - mlo[i];
   }
 
@@ -89,7 +119,7 @@ void HdfIStream::readGrid(GridContainer<FieldType> &g)
   assert(ret != -1);
 
   /* create a memory dataspace independently */
-  hid_t mem_dataspace = H5Screate_simple(FieldType::Rank, memdims, NULL);
+  hid_t mem_dataspace = H5Screate_simple(FieldType::Rank, allocdims, NULL);
   assert (mem_dataspace != -1);
   ret = H5Sselect_hyperslab(mem_dataspace,  H5S_SELECT_SET,
                             memstart, NULL, locdims, NULL);
@@ -109,14 +139,23 @@ void HdfIStream::readGrid(GridContainer<FieldType> &g)
   H5Sclose(mem_dataspace);
   H5Sclose(file_dataspace);
 #else
+  /* the memory dataspace skips any padding of the grid rows */
+  hid_t mem_dataspace = H5Screate_simple(FieldType::Rank, allocdims, NULL);
+  assert (mem_dataspace != -1);
+  hid_t ret = H5Sselect_hyperslab(mem_dataspace, H5S_SELECT_SET,
+                                  zero, NULL, memdims, NULL);
+  assert(ret != -1);
+
   /* read the data on single processor */
-  hid_t ret = H5Dread(dataset,
-                      H5DataType<T>::type,
-                      H5S_ALL,
-                      H5S_ALL,
-                      H5P_DEFAULT,
-                      data);
+  ret = H5Dread(dataset,
+                H5DataType<T>::type,
+                mem_dataspace,
+                H5S_ALL,
+                H5P_DEFAULT,
+                data);
   assert(ret != -1);
+
+  H5Sclose(mem_dataspace);
 #endif
 
   /* close dataset collectively */
@@ -136,6 +175,7 @@ void HdfOStream::writeGrid(GridContainer<FieldType> &g)
   IndexType mdims = g.grid->getDims();
   IndexType mlo = g.grid->getLo();
   IndexType mhi = g.grid->getHi();
+  IndexType adims = getHdfMemoryDims(g.grid);
 
   IndexType llo = g.local_min;
   IndexType lhi = g.local_max;
@@ -145,6 +185,8 @@ void HdfOStream::writeGrid(GridContainer<FieldType> &g)
 
   hsize_t locdims[FieldType::Rank];
   hsize_t memdims[FieldType::Rank];
+  hsize_t allocdims[FieldType::Rank];
+  hsize_t zero[FieldType::Rank];
   hsize_t locstart[FieldType::Rank];
   hsize_t memstart[FieldType::Rank];
 
@@ -158,6 +200,8 @@ void HdfOStream::writeGrid(GridContainer<FieldType> &g)
     locdims[i]  = lhi[i] - llo[i] + 1;
     locstart[i] = llo[i] - gmin;
     memdims[i] = mhi[i] - mlo[i] + 1;
+    allocdims[i] = adims[i];
+    zero[i] = 0;
     memstart[i] = llo[i] - mlo[i];
 
     SCHNEK_TRACE_LOG(2,"HdfOStream::writeGrid("<<i<<") "<< gmin <<" "<< g.global_max[i]<<" " << llo[i]<<" " << lhi[i])
@@ -224,7 +268,7 @@ void HdfOStream::writeGrid(GridContainer<FieldType> &g)
   assert(ret != -1);
 
   /* create a memory dataspace independently */
-  hid_t mem_dataspace = H5Screate_simple (FieldType::Rank, memdims, NULL);
+  hid_t mem_dataspace = H5Screate_simple (FieldType::Rank, allocdims, NULL);
 
   assert(mem_dataspace > -1);
   ret = H5Sselect_hyperslab(mem_dataspace,  H5S_SELECT_SET,
@@ -246,14 +290,23 @@ void HdfOStream::writeGrid(GridContainer<FieldType> &g)
   H5Sclose(mem_dataspace);
   H5Sclose(file_dataspace);
 #else
+  /* the memory dataspace skips any padding of the grid rows */
+  hid_t mem_dataspace = H5Screate_simple (FieldType::Rank, allocdims, NULL);
+  assert(mem_dataspace > -1);
+  ret = H5Sselect_hyperslab(mem_dataspace,  H5S_SELECT_SET,
+                            zero, NULL, memdims, NULL);
+  assert(ret != -1);
+
   /* write data on single processor */
   ret = H5Dwrite(dataset,
                        H5DataType<T>::type,
-                       H5S_ALL,
+                       mem_dataspace,
                        H5S_ALL,
                        H5P_DEFAULT,
                        data);
   assert(ret != -1);
+
+  H5Sclose(mem_dataspace);
 #endif
 
   /* close dataset collectively */
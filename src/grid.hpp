@@ -32,8 +32,14 @@
 #include "grid/field.hpp"
 #include "grid/grid.hpp"
 #include "grid/gridcheck.hpp"
+#include "grid/gridexpression.hpp"
+#include "grid/gridreduction.hpp"
 #include "grid/gridstorage.hpp"
 #include "grid/gridtransform.hpp"
+#include "grid/multicomponentgrid.hpp"
+#include "grid/parallelfor.hpp"
+#include "grid/reducedprecision.hpp"
+#include "grid/stencil.hpp"
 
 #include "grid/mpisubdivision.hpp"
 
@@ -56,13 +56,17 @@ class ArrayExpression {
     /**Copy constructor*/
     ArrayExpression(const ArrayExpression &Expr) : Op(Expr.Op) {}
 
+    // The conversions construct from a const reference, otherwise the
+    // constructor call would select the conversion operator again
     operator Array<value_type, Length, ArrayNoArgCheck> () {
-      return Array<value_type, Length, ArrayNoArgCheck>(*this);
+      const ArrayExpression &expr = *this;
+      return Array<value_type, Length, ArrayNoArgCheck>(expr);
     }
 
     template<template<int> class CheckingPolicy>
     operator Array<value_type, Length, CheckingPolicy> () {
-      return Array<value_type, Length, CheckingPolicy>(*this);
+      const ArrayExpression &expr = *this;
+      return Array<value_type, Length, CheckingPolicy>(expr);
     }
 
 //    template<template<int> class CheckingPolicy>
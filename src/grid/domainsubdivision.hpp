@@ -37,10 +37,193 @@
 
 #include "boundary.hpp"
 
+#include "../util/exceptions.hpp"
+
 #include <boost/shared_ptr.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
 namespace schnek {
 
+/** A list of grids whose boundaries are exchanged together
+ *
+ *  The grids can have different value types and storage policies, but
+ *  they must all cover the local domain of the DomainSubdivision that
+ *  exchanges them. Each grid can use fewer ghost cells than the
+ *  subdivision. In that case only the ghost layers next to the inner
+ *  domain are exchanged.
+ *
+ *  DomainSubdivision::exchange() packs the boundary data of all grids
+ *  into a single message for each neighbour. The number of messages is
+ *  therefore independent of the number of grids.
+ */
+template<int rank>
+class HaloExchangeBatch
+{
+  public:
+    typedef Range<int, rank> DomainType;
+    typedef typename Boundary<rank>::bound bound;
+  private:
+    /// The segment of every grid in the message is aligned to this number of bytes
+    static const std::size_t alignment = 16;
+
+    /** The interface to a grid in the batch */
+    class Entry
+    {
+      public:
+        /// The number of ghost cells to exchange, or -1 for the full width
+        int width;
+
+        Entry(int width_) : width(width_) {}
+        virtual ~Entry() {}
+
+        /// The number of bytes needed for the cells in domain
+        virtual std::size_t getSize(const DomainType &domain) const = 0;
+        /// Copy the cells in domain into the buffer
+        virtual void pack(const DomainType &domain, unsigned char *buffer) const = 0;
+        /// Copy the cells in domain from the buffer
+        virtual void unpack(const DomainType &domain, const unsigned char *buffer) = 0;
+    };
+
+    template<class GridType>
+    class GridEntry : public Entry
+    {
+      private:
+        typedef typename GridType::value_type value_type;
+        GridType &grid;
+      public:
+        GridEntry(GridType &grid_, int width_) : Entry(width_), grid(grid_) {}
+
+        std::size_t getSize(const DomainType &domain) const
+        {
+          std::size_t count = sizeof(value_type);
+          for (int i=0; i<rank; ++i) count *= domain.getHi()[i] - domain.getLo()[i] + 1;
+          return count;
+        }
+
+        void pack(const DomainType &domain, unsigned char *buffer) const
+        {
+          grid.pack(domain, reinterpret_cast<value_type*>(buffer));
+        }
+
+        void unpack(const DomainType &domain, const unsigned char *buffer)
+        {
+          grid.unpack(domain, reinterpret_cast<const value_type*>(buffer));
+        }
+    };
+
+    /** A multi-component grid whose components are packed together
+     *
+     *  The slab of the spatial domain is extended by the component index,
+     *  so that the boundary data of all components is copied in a single
+     *  pass over the underlying grid.
+     */
+    template<class MultiGridType>
+    class ComponentGridEntry : public Entry
+    {
+      private:
+        typedef typename MultiGridType::value_type value_type;
+        typedef Range<int, rank+1> SlabType;
+        MultiGridType &grid;
+
+        static SlabType getComponentSlab(const DomainType &domain)
+        {
+          return SlabType(MultiGridType::makeIndex(0, domain.getLo()),
+                          MultiGridType::makeIndex(MultiGridType::Components-1, domain.getHi()));
+        }
+      public:
+        ComponentGridEntry(MultiGridType &grid_, int width_) : Entry(width_), grid(grid_) {}
+
+        std::size_t getSize(const DomainType &domain) const
+        {
+          std::size_t count = MultiGridType::Components*sizeof(value_type);
+          for (int i=0; i<rank; ++i) count *= domain.getHi()[i] - domain.getLo()[i] + 1;
+          return count;
+        }
+
+        void pack(const DomainType &domain, unsigned char *buffer) const
+        {
+          grid.pack(getComponentSlab(domain), reinterpret_cast<value_type*>(buffer));
+        }
+
+        void unpack(const DomainType &domain, const unsigned char *buffer)
+        {
+          grid.unpack(getComponentSlab(domain), reinterpret_cast<const value_type*>(buffer));
+        }
+    };
+
+    typedef boost::shared_ptr<Entry> pEntry;
+    std::vector<pEntry> entries;
+
+    /** The ghost cells or the source cells of width width on side b
+     *
+     *  domain is the local domain including delta ghost cells.
+     */
+    static DomainType getSlab(const DomainType &domain, int delta, int width, int dim, bound b, bool ghost);
+
+    /// The size of a segment in the message, rounded up to the alignment
+    static std::size_t align(std::size_t size) { return (size + alignment - 1)/alignment*alignment; }
+  public:
+    /** Add a grid to the batch
+     *
+     *  width is the number of ghost cells that are exchanged for this grid.
+     *  The default of -1 exchanges all ghost cells of the subdivision. The
+     *  grid is referenced and must stay valid while the batch is used.
+     */
+    template<class GridType>
+    void add(GridType &grid, int width = -1)
+    {
+      entries.push_back(pEntry(new GridEntry<GridType>(grid, width)));
+    }
+
+    /** Add all components of a MultiComponentGrid to the batch
+     *
+     *  The spatial rank of the grid must be equal to the rank of the batch.
+     *  The boundary data of all components forms a single segment of the
+     *  message.
+     */
+    template<class MultiGridType>
+    void addComponents(MultiGridType &grid, int width = -1)
+    {
+      entries.push_back(pEntry(new ComponentGridEntry<MultiGridType>(grid, width)));
+    }
+
+    /// The number of grids in the batch
+    int getCount() const { return entries.size(); }
+
+    /// Remove all grids from the batch
+    void clear() { entries.clear(); }
+
+    /** Pack the source cells on side b of all grids into a single buffer
+     *
+     *  domain is the local domain of the subdivision including its delta
+     *  ghost cells.
+     */
+    template<class BufferType>
+    void pack(const DomainType &domain, int delta, int dim, bound b, BufferType &buffer) const;
+
+    /** Copy the buffer into the ghost cells on side b of all grids */
+    template<class BufferType>
+    void unpack(const DomainType &domain, int delta, int dim, bound b, const BufferType &buffer);
+};
+
+/** The operations that combine the partial results of a reduction
+ *
+ *  The partial results are stored as entries of consecutive doubles. Each
+ *  entry holds the operation, the value and, for ReduceMinLoc and
+ *  ReduceMaxLoc, the index of the value.
+ */
+enum ReductionOp {
+  ReduceSum = 0,
+  ReduceMin = 1,
+  ReduceMax = 2,
+  ReduceMinLoc = 3,
+  ReduceMaxLoc = 4
+};
+
 /** @brief Interface for wrapping and exchanging boundaries .
  *
  *  This interface is used to exchange the boundaries of grids
@@ -66,6 +249,12 @@ class DomainSubdivision {
 
   protected:
     pBoundaryType bounds;
+
+    /// The message buffers of exchange(HaloExchangeBatch&), kept between calls
+    BufferType sendBuffer, recvBuffer;
+
+    /// Set the lower and higher ghost cells of the grid in direction dim to zero
+    void clearGhosts(GridType &grid, int dim);
   public:
 
     /// Default constructor
@@ -194,6 +383,17 @@ class DomainSubdivision {
     /// Return the minimum of a single value over all the processes
     virtual int minReduce(int) const = 0;
 
+    /** Combine the partial results of several reductions over all processes
+     *
+     *  entries holds consecutive entries of stride doubles in the format
+     *  used by GridReduction: the ReductionOp, the value and the index of
+     *  the value. On return every process holds the combined results.
+     *
+     *  The default implementation uses the reductions of single values,
+     *  with one collective operation per value and index component.
+     *  Subdivisions should override it with a single collective operation.
+     */
+    virtual void reduceEntries(std::vector<double> &entries, int stride) const;
 
     /// Return true if this is the master process and false otherwise
     virtual bool master() const = 0;
@@ -229,6 +429,155 @@ class DomainSubdivision {
       for (int i=0; i<Rank; ++i) exchange(grid,i);
     }
 
+    /** @brief Exchange the boundaries of all grids in a batch
+     *  in the direction given by dim.
+     *
+     *  The boundary data of all grids is packed into a single buffer and
+     *  sent using exchangeData(). Only one message is sent to each
+     *  neighbour, independent of the number of grids.
+     */
+    void exchange(HaloExchangeBatch<Rank> &batch, int dim);
+
+    /** @brief Exchange the boundaries of all grids in a batch */
+    void exchange(HaloExchangeBatch<Rank> &batch) {
+      for (int i=0; i<Rank; ++i) exchange(batch,i);
+    }
+
+    /** @brief Start the exchange of the boundaries in the direction given by dim
+     *
+     *  The values of the source cells are taken when this method is called.
+     *  The ghost cells are filled by finishExchange(), which must be called
+     *  with the same grid and dimension before the ghost cells are used and
+     *  before another exchange is started in this dimension. In between, the
+     *  inner cells of the grid can be updated while the data is in transit.
+     *
+     *  The default implementation exchanges the boundaries immediately.
+     */
+    virtual void beginExchange(GridType &grid, int dim) { exchange(grid, dim); }
+
+    /** @brief Complete an exchange started with beginExchange() */
+    virtual void finishExchange(GridType &, int) {}
+
+    /** @brief Start the exchange of the boundaries in all directions
+     *
+     *  Only the exchange along the first dimension is started. The other
+     *  dimensions need the ghost cells of the first to fill the corners of the
+     *  domain. They are exchanged by finishExchange(grid) without overlap.
+     *  To overlap every dimension with computation, use continueExchange().
+     *
+     *  Example, updating the inner cells while the halo is in transit:
+     *  \begin{verbatim}
+     *  subdivision.beginExchange(u);
+     *  updateInner(u);
+     *  subdivision.finishExchange(u);
+     *  updateBoundaryLayers(u);
+     *  \end{verbatim}
+     */
+    void beginExchange(GridType &grid) {
+      beginExchange(grid, 0);
+    }
+
+    /** @brief Complete an exchange started with beginExchange(grid)
+     *
+     *  The exchange along the first dimension is completed and the other
+     *  dimensions are exchanged with blocking calls.
+     */
+    void finishExchange(GridType &grid) {
+      finishExchange(grid, 0);
+      for (int i=1; i<Rank; ++i) exchange(grid,i);
+    }
+
+    /** @brief Complete the exchange in dimension dim-1 and start it in dimension dim
+     *
+     *  This pipelines the exchange of all dimensions with the computation.
+     *  Each dimension needs the ghost cells of the previous one for the
+     *  corners, so the dimensions are exchanged one after the other, but
+     *  every one of them can be overlapped with a part of the work.
+     *
+     *  Example, splitting the update of the inner cells into three parts:
+     *  \begin{verbatim}
+     *  subdivision.beginExchange(u, 0);
+     *  updateInnerPart(u, 0);
+     *  subdivision.continueExchange(u, 1);
+     *  updateInnerPart(u, 1);
+     *  subdivision.continueExchange(u, 2);
+     *  updateInnerPart(u, 2);
+     *  subdivision.finishExchange(u, 2);
+     *  updateBoundaryLayers(u);
+     *  \end{verbatim}
+     */
+    void continueExchange(GridType &grid, int dim) {
+      finishExchange(grid, dim-1);
+      beginExchange(grid, dim);
+    }
+
+    /** @brief Start adding the ghost cells to the inner cells of the neighbours
+     *  in the direction given by dim
+     *
+     *  The contributions in the ghost cells are summed into the cells of the
+     *  neighbouring processes that they overlap. finishAccumulate() must be
+     *  called with the same grid and dimension before the source cells are
+     *  used. Unlike accumulate(), the ghost cells are not updated with the
+     *  sums. They are set to zero, so that the contributions in the corners
+     *  are not added twice when the following dimensions are accumulated.
+     *
+     *  The default implementation calls accumulate() immediately and then
+     *  clears the ghost cells.
+     */
+    virtual void beginAccumulate(GridType &grid, int dim) {
+      accumulate(grid, dim);
+      clearGhosts(grid, dim);
+    }
+
+    /** @brief Complete an accumulation started with beginAccumulate() */
+    virtual void finishAccumulate(GridType &, int) {}
+
+    /** @brief Start adding the ghost cells to the inner cells in all directions
+     *
+     *  Only the first dimension is started. The contributions in the corners
+     *  of the domain are passed on along the other dimensions, which are
+     *  accumulated in finishAccumulate().
+     */
+    void beginAccumulate(GridType &grid) {
+      beginAccumulate(grid, 0);
+    }
+
+    /** @brief Complete an accumulation started with beginAccumulate(grid)
+     *
+     *  The ghost cells are zero afterwards. They can be filled with the
+     *  sums again with exchange() or beginExchange().
+     */
+    void finishAccumulate(GridType &grid) {
+      finishAccumulate(grid, 0);
+      for (int i=1; i<Rank; ++i)
+      {
+        beginAccumulate(grid, i);
+        finishAccumulate(grid, i);
+      }
+    }
+
+    /** @brief Add the ghost cells to the inner cells of the neighbours in all directions
+     *
+     *  Only the inner cells receive the sums, and the ghost cells are zero
+     *  afterwards. This needs two messages in each dimension, half as many
+     *  as accumulate(). If refresh is true, the ghost cells are filled with
+     *  the sums by an exchange() afterwards, which adds the other two
+     *  messages again.
+     *
+     *  Example, depositing the current of the particles:
+     *  \begin{verbatim}
+     *  depositCurrent(jx, jy, jz);
+     *  subdivision.accumulateGhosts(jx);
+     *  subdivision.accumulateGhosts(jy);
+     *  subdivision.accumulateGhosts(jz);
+     *  \end{verbatim}
+     */
+    void accumulateGhosts(GridType &grid, bool refresh = false) {
+      beginAccumulate(grid);
+      finishAccumulate(grid);
+      if (refresh) exchange(grid);
+    }
+
     void accumulate(GridType &grid) {
       for (int i=0; i<Rank; ++i) accumulate(grid,i);
     }
@@ -253,6 +602,7 @@ class SerialSubdivision : public DomainSubdivision<GridType>
   public:
     using DomainSubdivision<GridType>::init;
     using DomainSubdivision<GridType>::exchange;
+    using DomainSubdivision<GridType>::accumulate;
 
     SerialSubdivision();
 
@@ -307,6 +657,9 @@ class SerialSubdivision : public DomainSubdivision<GridType>
     /// The sum of a single value is the value
     int sumReduce(int val) const { return val; }
 
+    /// The partial results of a single process are the results
+    void reduceEntries(std::vector<double> &, int) const {}
+
     /// The process with the rank zero is designated master process
     bool master() const { return true; }
 
@@ -26,6 +26,142 @@
 
 namespace schnek {
 
+template<int rank>
+typename HaloExchangeBatch<rank>::DomainType HaloExchangeBatch<rank>::getSlab(
+    const DomainType &domain, int delta, int width, int dim, bound b, bool ghost)
+{
+  typename DomainType::LimitType lo = domain.getLo();
+  typename DomainType::LimitType hi = domain.getHi();
+
+  // the first cell of the slab, counted outwards from the inner domain
+  int first;
+  if (b == Boundary<rank>::Min)
+  {
+    first = ghost ? lo[dim] + delta - width : lo[dim] + delta;
+    lo[dim] = first;
+    hi[dim] = first + width - 1;
+  }
+  else
+  {
+    first = ghost ? hi[dim] - delta + width : hi[dim] - delta;
+    hi[dim] = first;
+    lo[dim] = first - width + 1;
+  }
+  return DomainType(lo, hi);
+}
+
+template<int rank>
+template<class BufferType>
+void HaloExchangeBatch<rank>::pack(const DomainType &domain, int delta, int dim, bound b, BufferType &buffer) const
+{
+  std::size_t size = 0;
+  for (std::size_t e=0; e<entries.size(); ++e)
+  {
+    int width = (entries[e]->width < 0) ? delta : entries[e]->width;
+    SCHNEK_ASSERT(width <= delta, "The ghost width of a grid in a HaloExchangeBatch exceeds the ghost width of the subdivision");
+    size += align(entries[e]->getSize(getSlab(domain, delta, width, dim, b, false)));
+  }
+  // the buffer is reused between exchanges of the same batch
+  if (std::size_t(buffer.getSize()) != size) buffer.resize(typename BufferType::IndexType(size));
+
+  unsigned char *data = buffer.getRawData();
+  for (std::size_t e=0; e<entries.size(); ++e)
+  {
+    int width = (entries[e]->width < 0) ? delta : entries[e]->width;
+    DomainType slab = getSlab(domain, delta, width, dim, b, false);
+    entries[e]->pack(slab, data);
+    data += align(entries[e]->getSize(slab));
+  }
+}
+
+template<int rank>
+template<class BufferType>
+void HaloExchangeBatch<rank>::unpack(const DomainType &domain, int delta, int dim, bound b, const BufferType &buffer)
+{
+  const unsigned char *data = buffer.getRawData();
+  for (std::size_t e=0; e<entries.size(); ++e)
+  {
+    int width = (entries[e]->width < 0) ? delta : entries[e]->width;
+    DomainType slab = getSlab(domain, delta, width, dim, b, true);
+    entries[e]->unpack(slab, data);
+    data += align(entries[e]->getSize(slab));
+  }
+}
+
+template<class GridType>
+void DomainSubdivision<GridType>::exchange(HaloExchangeBatch<Rank> &batch, int dim)
+{
+  if (batch.getCount() == 0) return;
+  const DomainType &domain = bounds->getDomain();
+  int delta = bounds->getDelta();
+
+  // fill the lower ghost cells with the values from higher source cells
+  // in the neighbouring process
+  batch.pack(domain, delta, dim, BoundaryType::Max, sendBuffer);
+  exchangeData(dim, +1, sendBuffer, recvBuffer);
+  batch.unpack(domain, delta, dim, BoundaryType::Min, recvBuffer);
+
+  // fill the upper ghost cells with the values from lower source cells
+  // in the neighbouring process
+  batch.pack(domain, delta, dim, BoundaryType::Min, sendBuffer);
+  exchangeData(dim, -1, sendBuffer, recvBuffer);
+  batch.unpack(domain, delta, dim, BoundaryType::Max, recvBuffer);
+}
+
+template<class GridType>
+void DomainSubdivision<GridType>::reduceEntries(std::vector<double> &entries, int stride) const
+{
+  for (std::size_t e=0; e+stride<=entries.size(); e+=stride)
+  {
+    double *entry = &entries[e];
+    switch (int(entry[0]))
+    {
+      case ReduceSum:
+        entry[1] = sumReduce(entry[1]);
+        break;
+      case ReduceMin:
+        entry[1] = minReduce(entry[1]);
+        break;
+      case ReduceMax:
+        entry[1] = maxReduce(entry[1]);
+        break;
+      case ReduceMinLoc:
+      case ReduceMaxLoc:
+      {
+        double value = (int(entry[0]) == ReduceMinLoc) ? minReduce(entry[1]) : maxReduce(entry[1]);
+        // the lowest index in C ordering among the processes that hold the value
+        bool candidate = (entry[1] == value);
+        for (int d=2; d<stride; ++d)
+        {
+          int coord = minReduce(candidate ? int(entry[d]) : std::numeric_limits<int>::max());
+          candidate = candidate && (int(entry[d]) == coord);
+          entry[d] = coord;
+        }
+        entry[1] = value;
+        break;
+      }
+    }
+  }
+}
+
+/** Sets a span of ghost cells to zero */
+template<typename T>
+struct GhostClearKernel
+{
+    template<class IndexType>
+    void operator()(T *data, std::ptrdiff_t length, const IndexType &)
+    {
+      std::fill(data, data + length, T(0));
+    }
+};
+
+template<class GridType>
+void DomainSubdivision<GridType>::clearGhosts(GridType &grid, int dim)
+{
+  grid.forEachSpan(bounds->getGhostDomain(dim, BoundaryType::Min), GhostClearKernel<value_type>());
+  grid.forEachSpan(bounds->getGhostDomain(dim, BoundaryType::Max), GhostClearKernel<value_type>());
+}
+
 template<class GridType>
 SerialSubdivision<GridType>::SerialSubdivision()
 {}
@@ -37,7 +173,7 @@ SerialSubdivision<GridType>::~SerialSubdivision()
 template<class GridType>
 void SerialSubdivision<GridType>::init(const LimitType &low, const LimitType &high, int delta)
 {
-  this->bounds = pBoundaryType(new BoundaryType(low, high, delta));
+  this->bounds = typename DomainSubdivision<GridType>::pBoundaryType(new BoundaryType(low, high, delta));
 }
 
 template<class GridType>
@@ -48,6 +184,9 @@ void SerialSubdivision<GridType>::exchange(GridType &grid, int dim)
   DomainType loSource = this->bounds->getGhostSourceDomain(dim, BoundaryType::Min);
   DomainType hiSource = this->bounds->getGhostSourceDomain(dim, BoundaryType::Max);
 
+  // read the source cells through a const reference so that sparse grids are not allocated
+  const GridType &source = grid;
+
   {
     typename DomainType::iterator loIt = loGhost.begin();
     typename DomainType::iterator hiIt = hiSource.begin();
@@ -55,7 +194,7 @@ void SerialSubdivision<GridType>::exchange(GridType &grid, int dim)
 
     while (loIt != loEnd)
     {
-      grid[*loIt] = grid[*hiIt];
+      grid[*loIt] = source[*hiIt];
       ++loIt; ++hiIt;
     }
   }
@@ -67,7 +206,7 @@ void SerialSubdivision<GridType>::exchange(GridType &grid, int dim)
 
     while (loIt != loEnd)
     {
-      grid[*hiIt] = grid[*loIt];
+      grid[*hiIt] = source[*loIt];
       ++loIt; ++hiIt;
     }
   }
@@ -111,7 +250,8 @@ void SerialSubdivision<GridType>::accumulate(GridType &grid, int dim)
 template<class GridType>
 void SerialSubdivision<GridType>::exchangeData(int dim, int orientation, BufferType &in, BufferType &out)
 {
-  out = in;
+  if (out.getDims(0) != in.getDims(0)) out.resize(in.getDims());
+  std::copy(in.getRawData(), in.getRawData() + in.getDims(0), out.getRawData());
 }
 
 } // namespace schnek
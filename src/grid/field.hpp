@@ -49,6 +49,9 @@ class Field : public Grid<T, rank, CheckingPolicy, StoragePolicy>
     typedef Field<T, rank, CheckingPolicy, StoragePolicy> FieldType;
     typedef GridBase<T, rank, CheckingPolicy<rank>, StoragePolicy<T,rank> > BaseType;
   private:
+    template<typename, int, template<int> class, template<typename, int> class>
+    friend class Field;
+
     RangeType range;
     Stagger stagger;
     int ghostCells;
@@ -79,6 +82,11 @@ class Field : public Grid<T, rank, CheckingPolicy, StoragePolicy>
     /** copy constructor */
     Field(const FieldType&);
 
+#if __cplusplus >= 201103L
+    /** move constructor, takes over the data of the other field */
+    Field(FieldType&&);
+#endif
+
     /** Get the lo if the inner domain */
     IndexType getInnerLo() {return this->getLo()+ghostCells;}
 
@@ -123,6 +131,21 @@ class Field : public Grid<T, rank, CheckingPolicy, StoragePolicy>
       return *this;
     }
 
+#if __cplusplus >= 201103L
+    /** move another field, the two fields exchange their data */
+    FieldType& operator=(FieldType &&field)
+    {
+      this->swap(field);
+      return *this;
+    }
+#endif
+
+    /** Exchange the contents, including range, stagger and ghost cells, with another field
+     *
+     *  The grid data itself is not copied.
+     */
+    void swap(FieldType &field);
+
     /** assign another grid */
     template<
       typename T2,
@@ -150,6 +173,14 @@ class Field : public Grid<T, rank, CheckingPolicy, StoragePolicy>
       return *this;
     }
 
+    /** assign the result of a grid expression */
+    template<class Operator>
+    FieldType& operator=(const GridExpression<Operator, rank> &expr)
+    {
+      BaseType::operator=(expr);
+      return *this;
+    }
+
     /** Constructs a grid with a given number of cells in each direction
      *
      */
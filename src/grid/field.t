@@ -114,6 +114,35 @@ Field<T, rank, CheckingPolicy, StoragePolicy>::Field(const Field<T, rank, Checki
 {
 }
 
+#if __cplusplus >= 201103L
+template<
+  typename T,
+  int rank,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+Field<T, rank, CheckingPolicy, StoragePolicy>::Field(Field<T, rank, CheckingPolicy, StoragePolicy> &&field)
+  : Grid<T, rank, CheckingPolicy, StoragePolicy>(),
+    ghostCells(0)
+{
+  this->swap(field);
+}
+#endif
+
+template<
+  typename T,
+  int rank,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+void Field<T, rank, CheckingPolicy, StoragePolicy>::swap(Field<T, rank, CheckingPolicy, StoragePolicy> &field)
+{
+  BaseType::swap(field);
+  std::swap(range, field.range);
+  std::swap(stagger, field.stagger);
+  std::swap(ghostCells, field.ghostCells);
+}
+
 template<
   typename T,
   int rank,
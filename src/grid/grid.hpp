@@ -33,6 +33,9 @@
 #include "gridstorage.hpp"
 #include "../typetools.hpp"
 
+#include <cstddef>
+#include <vector>
+
 namespace schnek {
 
 template<class GridType, typename TList>
@@ -44,6 +47,9 @@ struct IndexCast;
 template<class Operator, int Length>
 class ArrayExpression;
 
+template<class Operator, int rank>
+class GridExpression;
+
 /** An elementary grid class */
 template<
   typename T, 
@@ -177,6 +183,42 @@ class GridBase : public StoragePolicy, public CheckingPolicy
     GridBase<T, rank, CheckingPolicy, StoragePolicy>&
       operator+=(GridBase<T2, rank, CheckingPolicy2, StoragePolicy2>&);
 
+    /** assign the result of a grid expression
+     *
+     *  Grid expressions are created by combining grids and scalars with the
+     *  operators +, -, * and /. The expression is evaluated element by element
+     *  in a single sweep over the grid, without temporary grids.
+     *
+     *  Example:
+     *  \begin{verbatim}
+     *  E = E + dt*(curlB - J);
+     *  \end{verbatim}
+     *
+     *  All grids in the expression must contain the index range of this grid.
+     *  This grid itself may appear in the expression.
+     */
+    template<class Operator>
+    GridBase<T, rank, CheckingPolicy, StoragePolicy>&
+      operator=(const GridExpression<Operator, rank>&);
+
+    /** add the result of a grid expression */
+    template<class Operator>
+    GridBase<T, rank, CheckingPolicy, StoragePolicy>&
+      operator+=(const GridExpression<Operator, rank>&);
+
+    /** subtract the result of a grid expression */
+    template<class Operator>
+    GridBase<T, rank, CheckingPolicy, StoragePolicy>&
+      operator-=(const GridExpression<Operator, rank>&);
+
+    /** assign the result of a grid expression to the elements in range
+     *
+     *  Like operator=() but only the elements in range are evaluated. Use this
+     *  to update the inner region of a Field without the ghost cells.
+     */
+    template<class Operator>
+    void assign(const Range<int,rank> &range, const GridExpression<Operator, rank> &expr);
+
     /** Resize to size[0] x ... x size[rank-1]
      *
      *  Example:
@@ -213,10 +255,78 @@ class GridBase : public StoragePolicy, public CheckingPolicy
     >
     void resize(const GridBase<T2, rank, CheckingPolicy2, StoragePolicy2>& grid);
 
+    /** Exchange the contents with another grid
+     *
+     *  Only the pointers to the data and the bounds are exchanged, the grid
+     *  data itself is not copied.
+     */
+    void swap(GridBase<T, rank, CheckingPolicy, StoragePolicy> &grid);
+
+    /** Call kernel(data, length, start) for contiguous spans of the grid in range
+     *
+     *  Each span starts at the index start and runs along the dimension
+     *  d = getSpanDim() of the storage. The element start + i*e_d is found at
+     *  data[i] for 0 <= i < length. This allows the kernel to loop over a
+     *  plain pointer, which the compiler can vectorise. Storages that are not
+     *  contiguous produce shorter spans, down to single elements.
+     *
+     *  The kernel is passed by value and returned, like std::for_each.
+     *
+     *  Example:
+     *  \begin{verbatim}
+     *  struct Scale {
+     *    double f;
+     *    Scale(double f_) : f(f_) {}
+     *    void operator()(double *data, std::ptrdiff_t length, const Array<int,3> &start) {
+     *      for (std::ptrdiff_t i=0; i<length; ++i) data[i] *= f;
+     *    }
+     *  };
+     *  grid.forEachSpan(range, Scale(2.0));
+     *  \end{verbatim}
+     */
+    template<class Kernel>
+    Kernel forEachSpan(const Range<int,rank> &range, Kernel kernel);
+
+    /** Call kernel(data, length, start) for contiguous spans of the grid in range
+     *
+     *  Like the non-const version but data is a const T*.
+     */
+    template<class Kernel>
+    Kernel forEachSpan(const Range<int,rank> &range, Kernel kernel) const;
+
+    /** Call kernel(value) for every element of the grid in range
+     *
+     *  The elements are visited span by span, see forEachSpan().
+     */
+    template<class Kernel>
+    Kernel forEach(const Range<int,rank> &range, Kernel kernel);
+
+    /** Call kernel(value) for every element of the grid in range, reading */
+    template<class Kernel>
+    Kernel forEach(const Range<int,rank> &range, Kernel kernel) const;
+
+    /** Copy the elements in range into a buffer
+     *
+     *  The elements are stored in the order in which forEachSpan() visits
+     *  them. Returns the number of elements copied.
+     */
+    std::ptrdiff_t pack(const Range<int,rank> &range, T *buffer) const;
+
+    /** Copy the elements in range from a buffer that was filled by pack()
+     *
+     *  Returns the number of elements copied.
+     */
+    std::ptrdiff_t unpack(const Range<int,rank> &range, const T *buffer);
+
   protected:
-    // assumes that the sizes are already set properly
-    template<typename T2, class CheckingPolicy2>
-    void copyFromGrid(const GridBase<T2, rank, CheckingPolicy2, StoragePolicy>& grid);
+    /** Copy the elements of another grid with the same bounds
+     *
+     *  Dense grids with identical layouts are copied with a single memcpy.
+     *  Otherwise the copy runs span by span, using memcpy or a conversion
+     *  loop wherever the source is contiguous along the same dimension.
+     */
+    template<typename T2, class CheckingPolicy2, class StoragePolicy2>
+    void copyFromGrid(const GridBase<T2, rank, CheckingPolicy2, StoragePolicy2>& grid);
 
 };
 
@@ -289,6 +399,11 @@ class Grid : public GridBase<T, rank, CheckingPolicy<rank>,  StoragePolicy<T,ran
     /** copy constructor */
     Grid(const Grid<T, rank, CheckingPolicy, StoragePolicy>&);
 
+#if __cplusplus >= 201103L
+    /** move constructor, takes over the data of the other grid */
+    Grid(Grid<T, rank, CheckingPolicy, StoragePolicy>&&);
+#endif
+
 //
 //    template<typename Arg0>
 //    IndexedGrid<GridType, TYPELIST_1(Arg0) > operator()(
@@ -315,6 +430,15 @@ class Grid : public GridBase<T, rank, CheckingPolicy<rank>,  StoragePolicy<T,ran
       return *this;
     }
 
+#if __cplusplus >= 201103L
+    /** move another grid, the two grids exchange their data */
+    GridType& operator=(GridType &&grid)
+    {
+      this->swap(grid);
+      return *this;
+    }
+#endif
+
     /** assign another grid */
     template<
       typename T2,
@@ -326,6 +450,55 @@ class Grid : public GridBase<T, rank, CheckingPolicy<rank>,  StoragePolicy<T,ran
       BaseType::operator=(grid);
       return *this;
     }
+
+    /** assign the result of a grid expression */
+    template<class Operator>
+    GridType& operator=(const GridExpression<Operator, rank> &expr)
+    {
+      BaseType::operator=(expr);
+      return *this;
+    }
+};
+
+/** A ring of grids that hold successive time levels
+ *
+ *  The grids are owned by the caller and are added in order of increasing
+ *  time level. rotate() moves the data of every grid to the grid one level
+ *  below, and the data of the lowest level to the highest level. Only the
+ *  data pointers are exchanged, so no grid data is copied and references to
+ *  the grid objects stay valid.
+ *
+ *  Example for a leapfrog scheme:
+ *  \begin{verbatim}
+ *  GridRing<Field<double,3> > ring;
+ *  ring.add(E_old);
+ *  ring.add(E);
+ *  ring.add(E_new);
+ *  ...
+ *  ring.rotate(); // E_old <- E, E <- E_new, E_new <- E_old
+ *  \end{verbatim}
+ */
+template<class GridType>
+class GridRing
+{
+  private:
+    std::vector<GridType*> grids;
+  public:
+    /** Add a grid as the next higher level */
+    void add(GridType &grid) { grids.push_back(&grid); }
+
+    /** The number of levels */
+    int getSize() const { return grids.size(); }
+
+    /** The grid at level i */
+    GridType &operator[](int i) { return *grids[i]; }
+
+    /** Shift the data down by one level */
+    void rotate()
+    {
+      for (int i=1; i<int(grids.size()); ++i)
+        grids[i-1]->swap(*grids[i]);
+    }
 };
 
 } // namespace schnek
@@ -29,9 +29,267 @@
 
 #include "range.hpp"
 #include "arrayexpression.hpp"
+#include "gridexpression.hpp"
+
+#include <boost/type_traits/is_pod.hpp>
+
+#include <algorithm>
+#include <cstring>
 
 namespace schnek
 {
+//=================================================================
+//======================== Span kernels ===========================
+//=================================================================
+
+/** Splits the lines of a range into the contiguous spans of a grid */
+template<class GridType, typename Pointer, class Kernel>
+struct GridSpanVisitor
+{
+    GridType &grid;
+    int dim;
+    Kernel kernel;
+
+    GridSpanVisitor(GridType &grid_, int dim_, const Kernel &kernel_)
+      : grid(grid_), dim(dim_), kernel(kernel_) {}
+
+    template<class IndexType>
+    void operator()(const IndexType &start, int length)
+    {
+      IndexType pos(start);
+      int end = start[dim] + length;
+      while (pos[dim] < end)
+      {
+        std::ptrdiff_t n = std::min(grid.getSpanLength(pos), std::ptrdiff_t(end - pos[dim]));
+        Pointer data = &grid.get(pos);
+        kernel(data, n, pos);
+        pos[dim] += n;
+      }
+    }
+};
+
+/** Assigns the value of an expression */
+struct GridAssignOp
+{
+    template<typename T, typename V>
+    static void apply(T &x, const V &y) { x = y; }
+};
+
+/** Adds the value of an expression */
+struct GridAddAssignOp
+{
+    template<typename T, typename V>
+    static void apply(T &x, const V &y) { x += y; }
+};
+
+/** Subtracts the value of an expression */
+struct GridSubAssignOp
+{
+    template<typename T, typename V>
+    static void apply(T &x, const V &y) { x -= y; }
+};
+
+/** Evaluates a grid expression on the spans of the target grid
+ *
+ *  If all grids in the expression are contiguous along the span the
+ *  expression is evaluated through pointers, otherwise element by element.
+ */
+template<class Expression, class AssignOp>
+struct GridExpressionKernel
+{
+    const Expression &expr;
+    int dim;
+
+    GridExpressionKernel(const Expression &expr_, int dim_) : expr(expr_), dim(dim_) {}
+
+    template<typename T, class IndexType>
+    void operator()(T *data, std::ptrdiff_t length, const IndexType &start)
+    {
+      if (expr.isContiguous(start, dim, length))
+      {
+        typename Expression::SpanType span = expr.getSpan(start);
+        for (std::ptrdiff_t i=0; i<length; ++i) AssignOp::apply(data[i], span[i]);
+      }
+      else
+      {
+        IndexType pos(start);
+        for (std::ptrdiff_t i=0; i<length; ++i)
+        {
+          pos[dim] = start[dim] + int(i);
+          AssignOp::apply(data[i], expr[pos]);
+        }
+      }
+    }
+};
+
+/** Copies a span of elements of the same type
+ *
+ *  Plain old data is copied with a single memcpy.
+ */
+template<typename T>
+inline void copyGridSpan(T *dest, const T *src, std::ptrdiff_t length)
+{
+  if (boost::is_pod<T>::value)
+    std::memcpy(dest, src, length*sizeof(T));
+  else
+    std::copy(src, src + length, dest);
+}
+
+/** Copies a span of elements, converting them to the target type
+ *
+ *  The loop runs over plain pointers so that the compiler can vectorise
+ *  the conversion.
+ */
+template<typename T, typename T2>
+inline void copyGridSpan(T *dest, const T2 *src, std::ptrdiff_t length)
+{
+  for (std::ptrdiff_t i=0; i<length; ++i) dest[i] = static_cast<T>(src[i]);
+}
+
+/** Copies the data of a dense C ordered storage with a single memcpy
+ *
+ *  Both storages must have the same bounds. Returns false if the element
+ *  type is not plain old data.
+ */
+template<
+  typename T,
+  int rank,
+  template<typename, int> class AllocationPolicy,
+  template<typename, int> class AllocationPolicy2
+>
+inline bool copyGridStorage(SingleArrayGridCOrderStorageBase<T, rank, AllocationPolicy> *dest,
+                            const SingleArrayGridCOrderStorageBase<T, rank, AllocationPolicy2> *src)
+{
+  if (!boost::is_pod<T>::value || (dest->getSize() != src->getSize())) return false;
+  std::memcpy(dest->getRawData(), src->getRawData(), src->getSize()*sizeof(T));
+  return true;
+}
+
+/** Copies the data of a dense Fortran ordered storage with a single memcpy
+ *
+ *  Both storages must have the same bounds. Returns false if the element
+ *  type is not plain old data.
+ */
+template<
+  typename T,
+  int rank,
+  template<typename, int> class AllocationPolicy,
+  template<typename, int> class AllocationPolicy2
+>
+inline bool copyGridStorage(SingleArrayGridFortranOrderStorageBase<T, rank, AllocationPolicy> *dest,
+                            const SingleArrayGridFortranOrderStorageBase<T, rank, AllocationPolicy2> *src)
+{
+  if (!boost::is_pod<T>::value || (dest->getSize() != src->getSize())) return false;
+  std::memcpy(dest->getRawData(), src->getRawData(), src->getSize()*sizeof(T));
+  return true;
+}
+
+/** Storages whose layouts differ, or that are not dense, are not copied as a block */
+inline bool copyGridStorage(const void *, const void *)
+{
+  return false;
+}
+
+/** Grids that refer to an external array cannot be copy constructed
+ *
+ *  The copy would not be attached to any array. The copy constructors of the
+ *  external allocations are private, so these overloads fail to compile.
+ */
+template<typename T, int rank>
+inline void checkGridCopyConstructible(const SingleArrayExternalAllocation<T, rank> *storage)
+{
+  (void)sizeof(SingleArrayExternalAllocation<T, rank>(*storage));
+}
+
+/** */
+template<typename T, int rank>
+inline void checkGridCopyConstructible(const SingleArrayExternalFortranAllocation<T, rank> *storage)
+{
+  (void)sizeof(SingleArrayExternalFortranAllocation<T, rank>(*storage));
+}
+
+/** All other grids can be copy constructed */
+inline void checkGridCopyConstructible(const void *) {}
+
+/** Copies the elements of a source grid into the spans of the target grid
+ *
+ *  Where the source is contiguous along the same dimension the span is
+ *  copied with copyGridSpan(), otherwise element by element.
+ */
+template<class SourceGrid>
+struct GridCopyKernel
+{
+    const SourceGrid &source;
+    int dim;
+
+    GridCopyKernel(const SourceGrid &source_, int dim_) : source(source_), dim(dim_) {}
+
+    template<typename T, class IndexType>
+    void operator()(T *data, std::ptrdiff_t length, const IndexType &start)
+    {
+      if ((source.getSpanDim() == dim) && (source.getSpanLength(start) >= length))
+      {
+        copyGridSpan(data, &source.get(start), length);
+      }
+      else
+      {
+        IndexType pos(start);
+        for (std::ptrdiff_t i=0; i<length; ++i)
+        {
+          pos[dim] = start[dim] + int(i);
+          data[i] = static_cast<T>(source.get(pos));
+        }
+      }
+    }
+};
+
+/** Applies an element-wise kernel to the elements of a span */
+template<typename Pointer, class Kernel>
+struct GridElementKernel
+{
+    Kernel kernel;
+
+    GridElementKernel(const Kernel &kernel_) : kernel(kernel_) {}
+
+    template<class IndexType>
+    void operator()(Pointer data, std::ptrdiff_t length, const IndexType &)
+    {
+      for (std::ptrdiff_t i=0; i<length; ++i) kernel(data[i]);
+    }
+};
+
+/** Copies spans into a buffer */
+template<typename T>
+struct GridPackKernel
+{
+    T *buffer;
+
+    GridPackKernel(T *buffer_) : buffer(buffer_) {}
+
+    template<class IndexType>
+    void operator()(const T *data, std::ptrdiff_t length, const IndexType &)
+    {
+      for (std::ptrdiff_t i=0; i<length; ++i) buffer[i] = data[i];
+      buffer += length;
+    }
+};
+
+/** Copies spans from a buffer */
+template<typename T>
+struct GridUnpackKernel
+{
+    const T *buffer;
+
+    GridUnpackKernel(const T *buffer_) : buffer(buffer_) {}
+
+    template<class IndexType>
+    void operator()(T *data, std::ptrdiff_t length, const IndexType &)
+    {
+      for (std::ptrdiff_t i=0; i<length; ++i) data[i] = buffer[i];
+      buffer += length;
+    }
+};
+
 //=================================================================
 //============================ GridBase ===========================
 //=================================================================
@@ -537,6 +795,67 @@ GridBase<T, rank, CheckingPolicy, StoragePolicy>&
 }
 
 
+template<
+  typename T,
+  int rank,
+  class CheckingPolicy,
+  class StoragePolicy
+>
+template<class Operator>
+GridBase<T, rank, CheckingPolicy, StoragePolicy>&
+  GridBase<T, rank, CheckingPolicy, StoragePolicy>
+    ::operator=(const GridExpression<Operator, rank> &expr)
+{
+  assign(Range<int, rank>(this->getLo(), this->getHi()), expr);
+  return *this;
+}
+
+template<
+  typename T,
+  int rank,
+  class CheckingPolicy,
+  class StoragePolicy
+>
+template<class Operator>
+GridBase<T, rank, CheckingPolicy, StoragePolicy>&
+  GridBase<T, rank, CheckingPolicy, StoragePolicy>
+    ::operator+=(const GridExpression<Operator, rank> &expr)
+{
+  typedef GridExpressionKernel<GridExpression<Operator, rank>, GridAddAssignOp> Kernel;
+  forEachSpan(Range<int, rank>(this->getLo(), this->getHi()), Kernel(expr, this->getSpanDim()));
+  return *this;
+}
+
+template<
+  typename T,
+  int rank,
+  class CheckingPolicy,
+  class StoragePolicy
+>
+template<class Operator>
+GridBase<T, rank, CheckingPolicy, StoragePolicy>&
+  GridBase<T, rank, CheckingPolicy, StoragePolicy>
+    ::operator-=(const GridExpression<Operator, rank> &expr)
+{
+  typedef GridExpressionKernel<GridExpression<Operator, rank>, GridSubAssignOp> Kernel;
+  forEachSpan(Range<int, rank>(this->getLo(), this->getHi()), Kernel(expr, this->getSpanDim()));
+  return *this;
+}
+
+template<
+  typename T,
+  int rank,
+  class CheckingPolicy,
+  class StoragePolicy
+>
+template<class Operator>
+void GridBase<T, rank, CheckingPolicy, StoragePolicy>
+  ::assign(const Range<int,rank> &range, const GridExpression<Operator, rank> &expr)
+{
+  typedef GridExpressionKernel<GridExpression<Operator, rank>, GridAssignOp> Kernel;
+  forEachSpan(range, Kernel(expr, this->getSpanDim()));
+}
+
 template<
   typename T,
   int rank,
@@ -578,6 +897,95 @@ void GridBase<T, rank, CheckingPolicy, StoragePolicy>::resize(const GridBase<T2,
 }
 
 
+template<
+  typename T,
+  int rank,
+  class CheckingPolicy,
+  class StoragePolicy
+>
+void GridBase<T, rank, CheckingPolicy, StoragePolicy>::swap(GridBase<T, rank, CheckingPolicy, StoragePolicy> &grid)
+{
+  StoragePolicy::swap(grid);
+}
+
+template<
+  typename T,
+  int rank,
+  class CheckingPolicy,
+  class StoragePolicy
+>
+template<class Kernel>
+Kernel GridBase<T, rank, CheckingPolicy, StoragePolicy>
+  ::forEachSpan(const Range<int,rank> &range, Kernel kernel)
+{
+  int dim = this->getSpanDim();
+  return range.forEachLine(dim, GridSpanVisitor<GridBase, T*, Kernel>(*this, dim, kernel)).kernel;
+}
+
+template<
+  typename T,
+  int rank,
+  class CheckingPolicy,
+  class StoragePolicy
+>
+template<class Kernel>
+Kernel GridBase<T, rank, CheckingPolicy, StoragePolicy>
+  ::forEachSpan(const Range<int,rank> &range, Kernel kernel) const
+{
+  int dim = this->getSpanDim();
+  return range.forEachLine(dim, GridSpanVisitor<const GridBase, const T*, Kernel>(*this, dim, kernel)).kernel;
+}
+
+template<
+  typename T,
+  int rank,
+  class CheckingPolicy,
+  class StoragePolicy
+>
+template<class Kernel>
+Kernel GridBase<T, rank, CheckingPolicy, StoragePolicy>
+  ::forEach(const Range<int,rank> &range, Kernel kernel)
+{
+  return forEachSpan(range, GridElementKernel<T*, Kernel>(kernel)).kernel;
+}
+
+template<
+  typename T,
+  int rank,
+  class CheckingPolicy,
+  class StoragePolicy
+>
+template<class Kernel>
+Kernel GridBase<T, rank, CheckingPolicy, StoragePolicy>
+  ::forEach(const Range<int,rank> &range, Kernel kernel) const
+{
+  return forEachSpan(range, GridElementKernel<const T*, Kernel>(kernel)).kernel;
+}
+
+template<
+  typename T,
+  int rank,
+  class CheckingPolicy,
+  class StoragePolicy
+>
+std::ptrdiff_t GridBase<T, rank, CheckingPolicy, StoragePolicy>
+  ::pack(const Range<int,rank> &range, T *buffer) const
+{
+  return forEachSpan(range, GridPackKernel<T>(buffer)).buffer - buffer;
+}
+
+template<
+  typename T,
+  int rank,
+  class CheckingPolicy,
+  class StoragePolicy
+>
+std::ptrdiff_t GridBase<T, rank, CheckingPolicy, StoragePolicy>
+  ::unpack(const Range<int,rank> &range, const T *buffer)
+{
+  return forEachSpan(range, GridUnpackKernel<T>(buffer)).buffer - buffer;
+}
+
 template<
   typename T,
   int rank,
@@ -586,22 +994,15 @@ template<
 >
 template<
   typename T2,
-  class CheckingPolicy2
+  class CheckingPolicy2,
+  class StoragePolicy2
 >
 void GridBase<T, rank, CheckingPolicy, StoragePolicy>
-  ::copyFromGrid(const GridBase<T2, rank, CheckingPolicy2, StoragePolicy>& grid)
+  ::copyFromGrid(const GridBase<T2, rank, CheckingPolicy2, StoragePolicy2>& grid)
 {
-  typedef typename StoragePolicy::const_storage_iterator CIterator;
-  typedef typename StoragePolicy::storage_iterator Iterator;
-  CIterator src = grid.cbegin();
-  CIterator srcEnd = grid.cend();
-  Iterator dest = this->begin();
-  while (src != srcEnd)
-  {
-    *dest = static_cast<T2>(*src);
-    ++src;
-    ++dest;
-  }
+  if (copyGridStorage(this, &grid)) return;
+  typedef GridCopyKernel<GridBase<T2, rank, CheckingPolicy2, StoragePolicy2> > Kernel;
+  forEachSpan(Range<int, rank>(this->getLo(), this->getHi()), Kernel(grid, this->getSpanDim()));
 }
 
 //=================================================================
@@ -648,9 +1049,25 @@ Grid<T, rank, CheckingPolicy, StoragePolicy>
   ::Grid(const Grid<T, rank, CheckingPolicy, StoragePolicy>& matr)
   : GridBase<T, rank, CheckingPolicy<rank>,  StoragePolicy<T,Rank> >(matr.getLo(), matr.getHi())
 {
+  checkGridCopyConstructible(&matr);
   this->copyFromGrid(matr);
 }
 
+#if __cplusplus >= 201103L
+template<
+  typename T,
+  int rank,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+Grid<T, rank, CheckingPolicy, StoragePolicy>
+  ::Grid(Grid<T, rank, CheckingPolicy, StoragePolicy>&& matr)
+  : GridBase<T, rank, CheckingPolicy<rank>,  StoragePolicy<T,Rank> >()
+{
+  this->swap(matr);
+}
+#endif
+
 
 
 //template<
@@ -0,0 +1,585 @@
+/*
+ * gridexpression.hpp
+ *
+ * Created on: 16 Oct 2026
+ * Author: Holger Schmitz
+ * Email: holger@notjustphysics.com
+ *
+ * Copyright 2026 Holger Schmitz
+ *
+ * This file is part of Schnek.
+ *
+ * Schnek is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Schnek is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Schnek.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SCHNEK_GRIDEXPRESSION_HPP_
+#define SCHNEK_GRIDEXPRESSION_HPP_
+
+#include "array.hpp"
+#include "arrayexpression.hpp"
+#include "grid.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+namespace schnek {
+
+/** Expression template for whole grid arithmetic
+ *
+ *  A GridExpression is created when grids are combined with the arithmetic
+ *  operators. It only holds references to the grids and is evaluated when
+ *  it is assigned to a grid. The assignment runs a single sweep over the
+ *  target grid, so that
+ *  \begin{verbatim}
+ *  E = E + dt*(curlB - J);
+ *  \end{verbatim}
+ *  reads every grid and writes E once without creating temporary grids.
+ *
+ *  The operator holds the expression tree. Every operator provides
+ *  - value_type operator[](pos): the value at the index pos
+ *  - isContiguous(start, dim, length): true if all grids in the expression
+ *    store the elements start + i*e_dim, 0 <= i < length, contiguously
+ *  - getSpan(start): a SpanType that returns the element start + i*e_dim
+ *    for span[i], valid only if isContiguous() is true
+ *  - getSpanDim() and getSpanLength(start): the dimension along which the
+ *    grids of the expression are contiguous and the number of contiguous
+ *    elements from start. Expressions without grids return -1 and the
+ *    largest possible length
+ *
+ *  Spans allow the evaluation to loop over plain pointers, which the compiler
+ *  can vectorise.
+ */
+template<class Operator, int rank>
+class GridExpression {
+  private:
+    /**The operator type. The operator will hold the information about
+     * the type of operation and references to all the arguments
+     */
+    Operator Op;
+  public:
+    typedef typename Operator::value_type value_type;
+    typedef typename Operator::SpanType SpanType;
+    typedef Array<int,rank> IndexType;
+    enum {Rank = rank};
+
+    /**Construct the expression from the operator*/
+    GridExpression(const Operator &Op_) : Op(Op_) {}
+
+    /**Copy constructor*/
+    GridExpression(const GridExpression &Expr) : Op(Expr.Op) {}
+
+    /**Return the value of the expression at the index pos*/
+    value_type operator[](const IndexType &pos) const { return Op[pos]; }
+
+    /**True if the expression can be evaluated as a contiguous span*/
+    bool isContiguous(const IndexType &start, int dim, std::ptrdiff_t length) const
+    {
+      return Op.isContiguous(start, dim, length);
+    }
+
+    /**The span of the expression starting at start*/
+    SpanType getSpan(const IndexType &start) const { return Op.getSpan(start); }
+
+    /**The dimension along which the grids of the expression are contiguous*/
+    int getSpanDim() const { return Op.getSpanDim(); }
+
+    /**The number of contiguous elements starting at start*/
+    std::ptrdiff_t getSpanLength(const IndexType &start) const { return Op.getSpanLength(start); }
+};
+
+/**A leaf of the expression that reads the elements of a grid */
+template<class GridType>
+class GridLeafExp {
+  private:
+    /// The grid
+    const GridType &grid;
+  public:
+    typedef typename GridType::value_type value_type;
+    typedef const value_type *SpanType;
+
+    GridLeafExp(const GridType &grid_) : grid(grid_) {}
+
+    template<class IndexType>
+    value_type operator[](const IndexType &pos) const { return grid.get(pos); }
+
+    template<class IndexType>
+    bool isContiguous(const IndexType &start, int dim, std::ptrdiff_t length) const
+    {
+      return (grid.getSpanDim() == dim) && (grid.getSpanLength(start) >= length);
+    }
+
+    template<class IndexType>
+    SpanType getSpan(const IndexType &start) const { return &grid.get(start); }
+
+    int getSpanDim() const { return grid.getSpanDim(); }
+
+    template<class IndexType>
+    std::ptrdiff_t getSpanLength(const IndexType &start) const { return grid.getSpanLength(start); }
+};
+
+/**The span of a constant */
+template<typename T>
+struct GridConstantSpan {
+  private:
+    T val;
+  public:
+    typedef T value_type;
+    GridConstantSpan(const T &val_) : val(val_) {}
+    value_type operator[](std::ptrdiff_t) const { return val; }
+};
+
+/**A leaf of the expression that holds a scalar */
+template<typename T>
+class GridConstantExp {
+  private:
+    T val;
+  public:
+    typedef T value_type;
+    typedef GridConstantSpan<T> SpanType;
+
+    GridConstantExp(const T &val_) : val(val_) {}
+
+    template<class IndexType>
+    value_type operator[](const IndexType &) const { return val; }
+
+    template<class IndexType>
+    bool isContiguous(const IndexType &, int, std::ptrdiff_t) const { return true; }
+
+    template<class IndexType>
+    SpanType getSpan(const IndexType &) const { return SpanType(val); }
+
+    int getSpanDim() const { return -1; }
+
+    template<class IndexType>
+    std::ptrdiff_t getSpanLength(const IndexType &) const
+    {
+      return std::numeric_limits<std::ptrdiff_t>::max();
+    }
+};
+
+/**The span of a unary operator*/
+template<class Span1, class OperatorType>
+struct GridUnarySpan {
+  private:
+    Span1 A;
+  public:
+    typedef typename OperatorType::value_type value_type;
+    GridUnarySpan(const Span1 &A_) : A(A_) {}
+    value_type operator[](std::ptrdiff_t i) const { return OperatorType::apply(A[i]); }
+};
+
+/**Operator class implementing unary operators for the GridExpression.
+ * The OperatorType is one of the operator types of the ArrayExpression.
+ */
+template<class Exp1, class OperatorType>
+class GridUnaryOp {
+  private:
+    /// Expression A
+    Exp1 A;
+  public:
+    typedef typename OperatorType::value_type value_type;
+    typedef GridUnarySpan<typename Exp1::SpanType, OperatorType> SpanType;
+
+    GridUnaryOp(const Exp1 &A_) : A(A_) {}
+
+    template<class IndexType>
+    value_type operator[](const IndexType &pos) const { return OperatorType::apply(A[pos]); }
+
+    template<class IndexType>
+    bool isContiguous(const IndexType &start, int dim, std::ptrdiff_t length) const
+    {
+      return A.isContiguous(start, dim, length);
+    }
+
+    template<class IndexType>
+    SpanType getSpan(const IndexType &start) const { return SpanType(A.getSpan(start)); }
+
+    int getSpanDim() const { return A.getSpanDim(); }
+
+    template<class IndexType>
+    std::ptrdiff_t getSpanLength(const IndexType &start) const { return A.getSpanLength(start); }
+};
+
+/**The span of a binary operator*/
+template<class Span1, class Span2, class OperatorType>
+struct GridBinarySpan {
+  private:
+    Span1 A;
+    Span2 B;
+  public:
+    typedef typename OperatorType::value_type value_type;
+    GridBinarySpan(const Span1 &A_, const Span2 &B_) : A(A_), B(B_) {}
+    value_type operator[](std::ptrdiff_t i) const { return OperatorType::apply(A[i], B[i]); }
+};
+
+/**Operator class implementing binary operators for the GridExpression.
+ * The OperatorType is one of the operator types of the ArrayExpression.
+ */
+template<class Exp1, class Exp2, class OperatorType>
+class GridBinaryOp {
+  private:
+    /// Expression A
+    Exp1 A;
+    /// Expression B
+    Exp2 B;
+  public:
+    typedef typename OperatorType::value_type value_type;
+    typedef GridBinarySpan<typename Exp1::SpanType, typename Exp2::SpanType, OperatorType> SpanType;
+
+    GridBinaryOp(const Exp1 &A_, const Exp2 &B_) : A(A_), B(B_) {}
+
+    template<class IndexType>
+    value_type operator[](const IndexType &pos) const { return OperatorType::apply(A[pos], B[pos]); }
+
+    template<class IndexType>
+    bool isContiguous(const IndexType &start, int dim, std::ptrdiff_t length) const
+    {
+      return A.isContiguous(start, dim, length) && B.isContiguous(start, dim, length);
+    }
+
+    template<class IndexType>
+    SpanType getSpan(const IndexType &start) const { return SpanType(A.getSpan(start), B.getSpan(start)); }
+
+    int getSpanDim() const
+    {
+      int dim = A.getSpanDim();
+      return (dim >= 0) ? dim : B.getSpanDim();
+    }
+
+    template<class IndexType>
+    std::ptrdiff_t getSpanLength(const IndexType &start) const
+    {
+      return std::min(A.getSpanLength(start), B.getSpanLength(start));
+    }
+};
+
+//================================================================
+//======== Here we define all the operators ======================
+//================================================================
+
+/* Operator for two GridExpression objects */
+#define GEXPR_GEXPR(op, symbol)                                                 \
+template<class exp1, class exp2, int rank>                                      \
+GridExpression<                                                                 \
+  GridBinaryOp<                                                                 \
+    GridExpression<exp1, rank>,                                                 \
+    GridExpression<exp2, rank>,                                                 \
+    op<typename exp1::value_type>                                               \
+  >,                                                                            \
+  rank                                                                          \
+>                                                                               \
+operator symbol (                                                               \
+  const GridExpression<exp1, rank> &A,                                          \
+  const GridExpression<exp2, rank> &B)                                          \
+{                                                                               \
+  typedef GridBinaryOp<                                                         \
+    GridExpression<exp1, rank>,                                                 \
+    GridExpression<exp2, rank>,                                                 \
+    op<typename exp1::value_type>                                               \
+  > OperatorType;                                                               \
+                                                                                \
+  return GridExpression<OperatorType, rank>(OperatorType(A,B));                 \
+}
+
+/* Operator for two grids */
+#define GRID_GRID(op, symbol)                                                   \
+template<                                                                       \
+  typename T, int rank,                                                         \
+  class CheckingPolicy1, class StoragePolicy1,                                  \
+  class CheckingPolicy2, class StoragePolicy2                                   \
+>                                                                               \
+GridExpression<                                                                 \
+  GridBinaryOp<                                                                 \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy1, StoragePolicy1> >,          \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy2, StoragePolicy2> >,          \
+    op<T>                                                                       \
+  >,                                                                            \
+  rank                                                                          \
+>                                                                               \
+operator symbol (                                                               \
+  const GridBase<T, rank, CheckingPolicy1, StoragePolicy1> &A,                  \
+  const GridBase<T, rank, CheckingPolicy2, StoragePolicy2> &B)                  \
+{                                                                               \
+  typedef GridBinaryOp<                                                         \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy1, StoragePolicy1> >,          \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy2, StoragePolicy2> >,          \
+    op<T>                                                                       \
+  > OperatorType;                                                               \
+                                                                                \
+  return GridExpression<OperatorType, rank>(OperatorType(A,B));                 \
+}
+
+/* Operator for a GridExpression and a grid */
+#define GEXPR_GRID(op, symbol)                                                  \
+template<                                                                       \
+  class exp, typename T, int rank,                                              \
+  class CheckingPolicy, class StoragePolicy                                     \
+>                                                                               \
+GridExpression<                                                                 \
+  GridBinaryOp<                                                                 \
+    GridExpression<exp, rank>,                                                  \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy, StoragePolicy> >,            \
+    op<T>                                                                       \
+  >,                                                                            \
+  rank                                                                          \
+>                                                                               \
+operator symbol (                                                               \
+  const GridExpression<exp, rank> &A,                                           \
+  const GridBase<T, rank, CheckingPolicy, StoragePolicy> &B)                    \
+{                                                                               \
+  typedef GridBinaryOp<                                                         \
+    GridExpression<exp, rank>,                                                  \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy, StoragePolicy> >,            \
+    op<T>                                                                       \
+  > OperatorType;                                                               \
+                                                                                \
+  return GridExpression<OperatorType, rank>(OperatorType(A,B));                 \
+}
+
+/* Operator for a grid and a GridExpression */
+#define GRID_GEXPR(op, symbol)                                                  \
+template<                                                                       \
+  class exp, typename T, int rank,                                              \
+  class CheckingPolicy, class StoragePolicy                                     \
+>                                                                               \
+GridExpression<                                                                 \
+  GridBinaryOp<                                                                 \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy, StoragePolicy> >,            \
+    GridExpression<exp, rank>,                                                  \
+    op<T>                                                                       \
+  >,                                                                            \
+  rank                                                                          \
+>                                                                               \
+operator symbol (                                                               \
+  const GridBase<T, rank, CheckingPolicy, StoragePolicy> &A,                    \
+  const GridExpression<exp, rank> &B)                                           \
+{                                                                               \
+  typedef GridBinaryOp<                                                         \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy, StoragePolicy> >,            \
+    GridExpression<exp, rank>,                                                  \
+    op<T>                                                                       \
+  > OperatorType;                                                               \
+                                                                                \
+  return GridExpression<OperatorType, rank>(OperatorType(A,B));                 \
+}
+
+/* Operator for a scalar and a GridExpression
+ * The scalar is converted to the value type of the expression */
+#define SCAL_GEXPR(op, symbol)                                                  \
+template<class exp, int rank>                                                   \
+GridExpression<                                                                 \
+  GridBinaryOp<                                                                 \
+    GridConstantExp<typename exp::value_type>,                                  \
+    GridExpression<exp, rank>,                                                  \
+    op<typename exp::value_type>                                                \
+  >,                                                                            \
+  rank                                                                          \
+>                                                                               \
+operator symbol (                                                               \
+  const typename exp::value_type &A,                                            \
+  const GridExpression<exp, rank> &B)                                           \
+{                                                                               \
+  typedef GridBinaryOp<                                                         \
+    GridConstantExp<typename exp::value_type>,                                  \
+    GridExpression<exp, rank>,                                                  \
+    op<typename exp::value_type>                                                \
+  > OperatorType;                                                               \
+                                                                                \
+  return GridExpression<OperatorType, rank>(OperatorType(A,B));                 \
+}
+
+/* Operator for a GridExpression and a scalar */
+#define GEXPR_SCAL(op, symbol)                                                  \
+template<class exp, int rank>                                                   \
+GridExpression<                                                                 \
+  GridBinaryOp<                                                                 \
+    GridExpression<exp, rank>,                                                  \
+    GridConstantExp<typename exp::value_type>,                                  \
+    op<typename exp::value_type>                                                \
+  >,                                                                            \
+  rank                                                                          \
+>                                                                               \
+operator symbol (                                                               \
+  const GridExpression<exp, rank> &A,                                           \
+  const typename exp::value_type &B)                                            \
+{                                                                               \
+  typedef GridBinaryOp<                                                         \
+    GridExpression<exp, rank>,                                                  \
+    GridConstantExp<typename exp::value_type>,                                  \
+    op<typename exp::value_type>                                                \
+  > OperatorType;                                                               \
+                                                                                \
+  return GridExpression<OperatorType, rank>(OperatorType(A,B));                 \
+}
+
+/* Operator for a scalar and a grid */
+#define SCAL_GRID(op, symbol)                                                   \
+template<typename T, int rank, class CheckingPolicy, class StoragePolicy>       \
+GridExpression<                                                                 \
+  GridBinaryOp<                                                                 \
+    GridConstantExp<T>,                                                         \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy, StoragePolicy> >,            \
+    op<T>                                                                       \
+  >,                                                                            \
+  rank                                                                          \
+>                                                                               \
+operator symbol (                                                               \
+  const typename GridBase<T, rank, CheckingPolicy, StoragePolicy>::value_type &A,\
+  const GridBase<T, rank, CheckingPolicy, StoragePolicy> &B)                    \
+{                                                                               \
+  typedef GridBinaryOp<                                                         \
+    GridConstantExp<T>,                                                         \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy, StoragePolicy> >,            \
+    op<T>                                                                       \
+  > OperatorType;                                                               \
+                                                                                \
+  return GridExpression<OperatorType, rank>(OperatorType(A,B));                 \
+}
+
+/* Operator for a grid and a scalar */
+#define GRID_SCAL(op, symbol)                                                   \
+template<typename T, int rank, class CheckingPolicy, class StoragePolicy>       \
+GridExpression<                                                                 \
+  GridBinaryOp<                                                                 \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy, StoragePolicy> >,            \
+    GridConstantExp<T>,                                                         \
+    op<T>                                                                       \
+  >,                                                                            \
+  rank                                                                          \
+>                                                                               \
+operator symbol (                                                               \
+  const GridBase<T, rank, CheckingPolicy, StoragePolicy> &A,                    \
+  const typename GridBase<T, rank, CheckingPolicy, StoragePolicy>::value_type &B)\
+{                                                                               \
+  typedef GridBinaryOp<                                                         \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy, StoragePolicy> >,            \
+    GridConstantExp<T>,                                                         \
+    op<T>                                                                       \
+  > OperatorType;                                                               \
+                                                                                \
+  return GridExpression<OperatorType, rank>(OperatorType(A,B));                 \
+}
+
+/* Unary operator for grids */
+#define UNARY_GRID(op, symbol)                                                  \
+template<typename T, int rank, class CheckingPolicy, class StoragePolicy>       \
+GridExpression<                                                                 \
+  GridUnaryOp<                                                                  \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy, StoragePolicy> >,            \
+    op<T>                                                                       \
+  >,                                                                            \
+  rank                                                                          \
+>                                                                               \
+operator symbol (const GridBase<T, rank, CheckingPolicy, StoragePolicy> &A)     \
+{                                                                               \
+  typedef GridUnaryOp<                                                          \
+    GridLeafExp< GridBase<T, rank, CheckingPolicy, StoragePolicy> >,            \
+    op<T>                                                                       \
+  > OperatorType;                                                               \
+                                                                                \
+  return GridExpression<OperatorType, rank>(OperatorType(A));                   \
+}
+
+/* Unary operator for GridExpression objects */
+#define UNARY_GEXPR(op, symbol)                                                 \
+template<class exp, int rank>                                                   \
+GridExpression<                                                                 \
+  GridUnaryOp<                                                                  \
+    GridExpression<exp, rank>,                                                  \
+    op<typename exp::value_type>                                                \
+  >,                                                                            \
+  rank                                                                          \
+>                                                                               \
+operator symbol (const GridExpression<exp, rank> &A)                            \
+{                                                                               \
+  typedef GridUnaryOp<                                                          \
+    GridExpression<exp, rank>,                                                  \
+    op<typename exp::value_type>                                                \
+  > OperatorType;                                                               \
+                                                                                \
+  return GridExpression<OperatorType, rank>(OperatorType(A));                   \
+}
+
+//======== Plus ======================
+
+GEXPR_GEXPR(ArrayOpPlus,+)
+GRID_GRID(ArrayOpPlus,+)
+GEXPR_GRID(ArrayOpPlus,+)
+GRID_GEXPR(ArrayOpPlus,+)
+
+GEXPR_SCAL(ArrayOpPlus,+)
+SCAL_GEXPR(ArrayOpPlus,+)
+GRID_SCAL(ArrayOpPlus,+)
+SCAL_GRID(ArrayOpPlus,+)
+
+//======== Minus ======================
+
+GEXPR_GEXPR(ArrayOpMinus,-)
+GRID_GRID(ArrayOpMinus,-)
+GEXPR_GRID(ArrayOpMinus,-)
+GRID_GEXPR(ArrayOpMinus,-)
+
+GEXPR_SCAL(ArrayOpMinus,-)
+SCAL_GEXPR(ArrayOpMinus,-)
+GRID_SCAL(ArrayOpMinus,-)
+SCAL_GRID(ArrayOpMinus,-)
+
+//======== Multiplication ======================
+
+GEXPR_GEXPR(ArrayOpMult,*)
+GRID_GRID(ArrayOpMult,*)
+GEXPR_GRID(ArrayOpMult,*)
+GRID_GEXPR(ArrayOpMult,*)
+
+GEXPR_SCAL(ArrayOpMult,*)
+SCAL_GEXPR(ArrayOpMult,*)
+GRID_SCAL(ArrayOpMult,*)
+SCAL_GRID(ArrayOpMult,*)
+
+//======== Division ======================
+
+GEXPR_GEXPR(ArrayOpDiv,/)
+GRID_GRID(ArrayOpDiv,/)
+GEXPR_GRID(ArrayOpDiv,/)
+GRID_GEXPR(ArrayOpDiv,/)
+
+GEXPR_SCAL(ArrayOpDiv,/)
+SCAL_GEXPR(ArrayOpDiv,/)
+GRID_SCAL(ArrayOpDiv,/)
+SCAL_GRID(ArrayOpDiv,/)
+
+//======== Unary Plus and Minus ======================
+
+UNARY_GRID(ArrayOpUnaryPlus,+)
+UNARY_GEXPR(ArrayOpUnaryPlus,+)
+
+UNARY_GRID(ArrayOpUnaryMinus,-)
+UNARY_GEXPR(ArrayOpUnaryMinus,-)
+
+#undef GEXPR_GEXPR
+#undef GRID_GRID
+#undef GEXPR_GRID
+#undef GRID_GEXPR
+#undef GEXPR_SCAL
+#undef SCAL_GEXPR
+#undef GRID_SCAL
+#undef SCAL_GRID
+#undef UNARY_GRID
+#undef UNARY_GEXPR
+
+} // namespace schnek
+
+#endif // SCHNEK_GRIDEXPRESSION_HPP_
@@ -0,0 +1,572 @@
+/*
+ * gridreduction.hpp
+ *
+ * Created on: 16 Oct 2026
+ * Author: Holger Schmitz
+ * Email: holger@notjustphysics.com
+ *
+ * Copyright 2026 Holger Schmitz
+ *
+ * This file is part of Schnek.
+ *
+ * Schnek is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Schnek is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Schnek.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SCHNEK_GRIDREDUCTION_HPP_
+#define SCHNEK_GRIDREDUCTION_HPP_
+
+#include "array.hpp"
+#include "range.hpp"
+#include "grid.hpp"
+#include "gridexpression.hpp"
+#include "partition.hpp"
+#include "parallelfor.hpp"
+#include "domainsubdivision.hpp"
+#include "../util/threadpool.hpp"
+
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace schnek {
+
+/** Combine count reduction entries of length stride from in into inout
+ *
+ *  Ties in ReduceMinLoc and ReduceMaxLoc are resolved in favour of the
+ *  lower index in C ordering, so that the result does not depend on the
+ *  order in which the partial results are combined.
+ */
+inline void combineReductionEntries(const double *in, double *inout, int count, int stride)
+{
+  for (int e=0; e<count; ++e, in += stride, inout += stride)
+  {
+    switch (int(inout[0]))
+    {
+      case ReduceSum:
+        inout[1] += in[1];
+        break;
+      case ReduceMin:
+        inout[1] = std::min(inout[1], in[1]);
+        break;
+      case ReduceMax:
+        inout[1] = std::max(inout[1], in[1]);
+        break;
+      case ReduceMinLoc:
+      case ReduceMaxLoc:
+      {
+        bool better = (int(inout[0]) == ReduceMinLoc) ? (in[1] < inout[1]) : (in[1] > inout[1]);
+        if (!better && (in[1] == inout[1]))
+          better = std::lexicographical_compare(in + 2, in + stride, inout + 2, inout + stride);
+        if (better) std::copy(in + 1, in + stride, inout + 1);
+        break;
+      }
+    }
+  }
+}
+
+//=================================================================
+//====================== Reduction policies =======================
+//=================================================================
+
+/* The policies accumulate the values of a span into the entry of a
+ * reduction. The sums and extrema of spans use four independent
+ * accumulators, which allows the compiler to vectorise the loops without
+ * changing the order of floating point operations.
+ */
+
+/** Sum of the values */
+struct ReduceSumPolicy
+{
+    static ReductionOp getOp() { return ReduceSum; }
+    static double init() { return 0.0; }
+
+    template<class Span, class IndexType>
+    static void span(const Span &s, std::ptrdiff_t n, const IndexType &, int, double *entry)
+    {
+      double acc[4] = {0.0, 0.0, 0.0, 0.0};
+      std::ptrdiff_t i = 0;
+      for (; i+4<=n; i+=4)
+        for (int l=0; l<4; ++l) acc[l] += double(s[i+l]);
+      for (; i<n; ++i) acc[0] += double(s[i]);
+      entry[1] += (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    }
+
+    template<class IndexType>
+    static void element(double v, const IndexType &, double *entry) { entry[1] += v; }
+};
+
+/** Sum of the squares of the values */
+struct ReduceSumSquaresPolicy
+{
+    static ReductionOp getOp() { return ReduceSum; }
+    static double init() { return 0.0; }
+
+    template<class Span, class IndexType>
+    static void span(const Span &s, std::ptrdiff_t n, const IndexType &, int, double *entry)
+    {
+      double acc[4] = {0.0, 0.0, 0.0, 0.0};
+      std::ptrdiff_t i = 0;
+      for (; i+4<=n; i+=4)
+        for (int l=0; l<4; ++l)
+        {
+          double v = s[i+l];
+          acc[l] += v*v;
+        }
+      for (; i<n; ++i)
+      {
+        double v = s[i];
+        acc[0] += v*v;
+      }
+      entry[1] += (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    }
+
+    template<class IndexType>
+    static void element(double v, const IndexType &, double *entry) { entry[1] += v*v; }
+};
+
+/** Minimum of the values */
+struct ReduceMinPolicy
+{
+    static ReductionOp getOp() { return ReduceMin; }
+    static double init() { return std::numeric_limits<double>::infinity(); }
+
+    template<class Span, class IndexType>
+    static void span(const Span &s, std::ptrdiff_t n, const IndexType &, int, double *entry)
+    {
+      double acc[4] = {entry[1], entry[1], entry[1], entry[1]};
+      std::ptrdiff_t i = 0;
+      for (; i+4<=n; i+=4)
+        for (int l=0; l<4; ++l)
+        {
+          double v = s[i+l];
+          acc[l] = (v < acc[l]) ? v : acc[l];
+        }
+      for (; i<n; ++i)
+      {
+        double v = s[i];
+        acc[0] = (v < acc[0]) ? v : acc[0];
+      }
+      entry[1] = std::min(std::min(acc[0], acc[1]), std::min(acc[2], acc[3]));
+    }
+
+    template<class IndexType>
+    static void element(double v, const IndexType &, double *entry) { entry[1] = std::min(entry[1], v); }
+};
+
+/** Maximum of the values */
+struct ReduceMaxPolicy
+{
+    static ReductionOp getOp() { return ReduceMax; }
+    static double init() { return -std::numeric_limits<double>::infinity(); }
+
+    template<class Span, class IndexType>
+    static void span(const Span &s, std::ptrdiff_t n, const IndexType &, int, double *entry)
+    {
+      double acc[4] = {entry[1], entry[1], entry[1], entry[1]};
+      std::ptrdiff_t i = 0;
+      for (; i+4<=n; i+=4)
+        for (int l=0; l<4; ++l)
+        {
+          double v = s[i+l];
+          acc[l] = (v > acc[l]) ? v : acc[l];
+        }
+      for (; i<n; ++i)
+      {
+        double v = s[i];
+        acc[0] = (v > acc[0]) ? v : acc[0];
+      }
+      entry[1] = std::max(std::max(acc[0], acc[1]), std::max(acc[2], acc[3]));
+    }
+
+    template<class IndexType>
+    static void element(double v, const IndexType &, double *entry) { entry[1] = std::max(entry[1], v); }
+};
+
+/** Minimum or maximum of the values together with the index of the first occurrence */
+template<bool isMax>
+struct ReduceLocPolicy
+{
+    static ReductionOp getOp() { return isMax ? ReduceMaxLoc : ReduceMinLoc; }
+    static double init()
+    {
+      return isMax ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+    }
+
+    static bool better(double v, double best) { return isMax ? (v > best) : (v < best); }
+
+    template<class IndexType>
+    static void store(double v, const IndexType &pos, double *entry)
+    {
+      entry[1] = v;
+      for (int d=0; d<IndexType::Length; ++d) entry[2+d] = pos[d];
+    }
+
+    template<class Span, class IndexType>
+    static void span(const Span &s, std::ptrdiff_t n, const IndexType &start, int dim, double *entry)
+    {
+      std::ptrdiff_t found = -1;
+      double best = entry[1];
+      for (std::ptrdiff_t i=0; i<n; ++i)
+      {
+        double v = s[i];
+        if (better(v, best))
+        {
+          best = v;
+          found = i;
+        }
+      }
+      if (found < 0) return;
+      IndexType pos(start);
+      pos[dim] += int(found);
+      store(best, pos, entry);
+    }
+
+    template<class IndexType>
+    static void element(double v, const IndexType &pos, double *entry)
+    {
+      if (better(v, entry[1])) store(v, pos, entry);
+    }
+};
+
+//=================================================================
+//====================== Reduction quantities =====================
+//=================================================================
+
+/** A quantity that is computed by a GridReduction */
+template<int rank>
+class GridReductionQuantity
+{
+  public:
+    virtual ~GridReductionQuantity() {}
+
+    /** The operation that combines partial results */
+    virtual ReductionOp getOp() const = 0;
+
+    /** The value of an empty reduction */
+    virtual double init() const = 0;
+
+    /** Accumulate the values in tile into the entry */
+    virtual void accumulate(const Range<int,rank> &tile, double *entry) const = 0;
+};
+
+/** Accumulates the lines of a tile for an expression and a reduction policy */
+template<class Expression, class Policy>
+struct GridReductionLineVisitor
+{
+    const Expression &expr;
+    int dim;
+    double *entry;
+
+    GridReductionLineVisitor(const Expression &expr_, int dim_, double *entry_)
+      : expr(expr_), dim(dim_), entry(entry_) {}
+
+    template<class IndexType>
+    void operator()(const IndexType &start, int length)
+    {
+      IndexType pos(start);
+      int end = start[dim] + length;
+      while (pos[dim] < end)
+      {
+        std::ptrdiff_t n = std::min(expr.getSpanLength(pos), std::ptrdiff_t(end - pos[dim]));
+        if (n < 1) n = 1;
+        if (expr.isContiguous(pos, dim, n))
+          Policy::span(expr.getSpan(pos), n, pos, dim, entry);
+        else
+        {
+          IndexType p(pos);
+          for (std::ptrdiff_t i=0; i<n; ++i, ++p[dim])
+            Policy::element(double(expr[p]), p, entry);
+        }
+        pos[dim] += int(n);
+      }
+    }
+};
+
+/** A reduction of a grid expression with a reduction policy */
+template<int rank, class Expression, class Policy>
+class GridReductionExpressionQuantity : public GridReductionQuantity<rank>
+{
+  private:
+    Expression expr;
+  public:
+    GridReductionExpressionQuantity(const Expression &expr_) : expr(expr_) {}
+
+    ReductionOp getOp() const { return Policy::getOp(); }
+
+    double init() const { return Policy::init(); }
+
+    void accumulate(const Range<int,rank> &tile, double *entry) const
+    {
+      int dim = expr.getSpanDim();
+      if (dim < 0) dim = rank-1;
+      tile.forEachLine(dim, GridReductionLineVisitor<Expression, Policy>(expr, dim, entry));
+    }
+};
+
+/** The job that accumulates the tiles of a reduction on the thread pool */
+template<int rank>
+class GridReductionJob : public ThreadPool::Job
+{
+  private:
+    typedef boost::shared_ptr<GridReductionQuantity<rank> > pQuantity;
+    const std::vector<pQuantity> &quantities;
+    const RangeTiling<rank> &tiling;
+    std::vector<double> &partials;
+    int stride;
+  public:
+    GridReductionJob(const std::vector<pQuantity> &quantities_,
+                     const RangeTiling<rank> &tiling_,
+                     std::vector<double> &partials_,
+                     int stride_)
+      : quantities(quantities_), tiling(tiling_), partials(partials_), stride(stride_)
+    {}
+
+    void execute(int thread, int threadCount)
+    {
+      StaticPartition partition(0, int(tiling.getTileCount()) - 1, threadCount);
+      if (thread >= partition.getCount()) return;
+      double *entries = &partials[thread*quantities.size()*stride];
+      for (std::ptrdiff_t t = partition.getLo(thread); t <= partition.getHi(thread); ++t)
+      {
+        Range<int,rank> tile = tiling.getTile(t);
+        for (std::size_t q=0; q<quantities.size(); ++q)
+          quantities[q]->accumulate(tile, entries + q*stride);
+      }
+    }
+};
+
+/** Computes several reductions of grids in a single pass
+ *
+ *  Quantities are added with the add methods, which return the index under
+ *  which the result can be retrieved. Every quantity can be a grid or a grid
+ *  expression, so that for example the energy density is added as
+ *  \begin{verbatim}
+ *  GridReduction<3> reduction;
+ *  int energy = reduction.addSum(Ex*Ex + Ey*Ey + Ez*Ez);
+ *  int peak = reduction.addMaxLoc(rho);
+ *  reduction.execute(inner, subdivision);
+ *  double W = 0.5*dV*reduction.getValue(energy);
+ *  IndexType where = reduction.getPosition(peak);
+ *  \end{verbatim}
+ *
+ *  execute() splits the range into small tiles which are distributed over
+ *  the threads of the ThreadPool. All quantities are accumulated tile by
+ *  tile, so the data of a tile is still in the cache when the next quantity
+ *  reads it. The partial results of the threads are combined in a fixed
+ *  order, so the results do not change between runs with the same number of
+ *  threads. When a DomainSubdivision is passed, the results of all
+ *  processes are combined with a single call to
+ *  DomainSubdivision::reduceEntries().
+ *
+ *  The grids must outlive the GridReduction.
+ */
+template<int rank>
+class GridReduction
+{
+  public:
+    typedef Array<int,rank> IndexType;
+    typedef Range<int,rank> RangeType;
+  private:
+    typedef boost::shared_ptr<GridReductionQuantity<rank> > pQuantity;
+
+    /// The length of an entry, the operation, the value and the index
+    enum {stride = rank + 2};
+
+    std::vector<pQuantity> quantities;
+    std::vector<double> results;
+
+    template<class Policy, class Expression>
+    int add(const Expression &expr)
+    {
+      quantities.push_back(pQuantity(new GridReductionExpressionQuantity<rank, Expression, Policy>(expr)));
+      results.resize(quantities.size()*stride, 0.0);
+      initEntries(&results[0]);
+      return int(quantities.size()) - 1;
+    }
+
+    template<class Policy, typename T, class CheckingPolicy, class StoragePolicy>
+    int addGrid(const GridBase<T, rank, CheckingPolicy, StoragePolicy> &grid)
+    {
+      typedef GridLeafExp<GridBase<T, rank, CheckingPolicy, StoragePolicy> > Leaf;
+      return add<Policy>(GridExpression<Leaf, rank>(Leaf(grid)));
+    }
+
+    void initEntries(double *entries) const
+    {
+      for (std::size_t q=0; q<quantities.size(); ++q)
+      {
+        double *entry = entries + q*stride;
+        entry[0] = quantities[q]->getOp();
+        entry[1] = quantities[q]->init();
+        for (int d=0; d<rank; ++d) entry[2+d] = 0.0;
+      }
+    }
+
+    /** Split the range into tiles of up to about 4096 elements
+     *
+     *  The tiles extend over the whole range in the last dimension.
+     */
+    static IndexType getTileSize(const RangeType &range)
+    {
+      IndexType tileSize;
+      std::ptrdiff_t elements = 1;
+      for (int d=rank-1; d>=0; --d)
+      {
+        int extent = std::max(range.getHi()[d] - range.getLo()[d] + 1, 1);
+        int size = (d == rank-1) ? extent : int(std::max(std::ptrdiff_t(1), 4096/elements));
+        tileSize[d] = std::min(size, extent);
+        elements *= tileSize[d];
+      }
+      return tileSize;
+    }
+  public:
+    /** Add the sum of the values of a grid */
+    template<typename T, class CheckingPolicy, class StoragePolicy>
+    int addSum(const GridBase<T, rank, CheckingPolicy, StoragePolicy> &grid)
+    {
+      return addGrid<ReduceSumPolicy>(grid);
+    }
+
+    /** Add the sum of the values of a grid expression
+     *
+     *  Weighted sums are expressed as the sum of a product, addSum(E*weight).
+     */
+    template<class Operator>
+    int addSum(const GridExpression<Operator, rank> &expr) { return add<ReduceSumPolicy>(expr); }
+
+    /** Add the sum of the squares of the values of a grid */
+    template<typename T, class CheckingPolicy, class StoragePolicy>
+    int addSumSquares(const GridBase<T, rank, CheckingPolicy, StoragePolicy> &grid)
+    {
+      return addGrid<ReduceSumSquaresPolicy>(grid);
+    }
+
+    /** Add the sum of the squares of the values of a grid expression */
+    template<class Operator>
+    int addSumSquares(const GridExpression<Operator, rank> &expr) { return add<ReduceSumSquaresPolicy>(expr); }
+
+    /** Add the weighted sum of the values of a grid, the sum of grid*weight */
+    template<
+      typename T,
+      class CheckingPolicy, class StoragePolicy,
+      class CheckingPolicy2, class StoragePolicy2
+    >
+    int addWeightedSum(const GridBase<T, rank, CheckingPolicy, StoragePolicy> &grid,
+                       const GridBase<T, rank, CheckingPolicy2, StoragePolicy2> &weight)
+    {
+      return add<ReduceSumPolicy>(grid*weight);
+    }
+
+    /** Add the minimum of the values of a grid */
+    template<typename T, class CheckingPolicy, class StoragePolicy>
+    int addMin(const GridBase<T, rank, CheckingPolicy, StoragePolicy> &grid)
+    {
+      return addGrid<ReduceMinPolicy>(grid);
+    }
+
+    /** Add the minimum of the values of a grid expression */
+    template<class Operator>
+    int addMin(const GridExpression<Operator, rank> &expr) { return add<ReduceMinPolicy>(expr); }
+
+    /** Add the maximum of the values of a grid */
+    template<typename T, class CheckingPolicy, class StoragePolicy>
+    int addMax(const GridBase<T, rank, CheckingPolicy, StoragePolicy> &grid)
+    {
+      return addGrid<ReduceMaxPolicy>(grid);
+    }
+
+    /** Add the maximum of the values of a grid expression */
+    template<class Operator>
+    int addMax(const GridExpression<Operator, rank> &expr) { return add<ReduceMaxPolicy>(expr); }
+
+    /** Add the minimum of the values of a grid and its position */
+    template<typename T, class CheckingPolicy, class StoragePolicy>
+    int addMinLoc(const GridBase<T, rank, CheckingPolicy, StoragePolicy> &grid)
+    {
+      return addGrid<ReduceLocPolicy<false> >(grid);
+    }
+
+    /** Add the minimum of the values of a grid expression and its position */
+    template<class Operator>
+    int addMinLoc(const GridExpression<Operator, rank> &expr) { return add<ReduceLocPolicy<false> >(expr); }
+
+    /** Add the maximum of the values of a grid and its position */
+    template<typename T, class CheckingPolicy, class StoragePolicy>
+    int addMaxLoc(const GridBase<T, rank, CheckingPolicy, StoragePolicy> &grid)
+    {
+      return addGrid<ReduceLocPolicy<true> >(grid);
+    }
+
+    /** Add the maximum of the values of a grid expression and its position */
+    template<class Operator>
+    int addMaxLoc(const GridExpression<Operator, rank> &expr) { return add<ReduceLocPolicy<true> >(expr); }
+
+    /** The number of quantities */
+    int getCount() const { return int(quantities.size()); }
+
+    /** Compute all quantities over the elements in range on this process */
+    void execute(const RangeType &range)
+    {
+      if (quantities.empty()) return;
+      initEntries(&results[0]);
+
+      RangeTiling<rank> tiling(range, getTileSize(range));
+      if (tiling.getTileCount() == 0) return;
+
+      ThreadPool &pool = ThreadPool::instance();
+      int threadCount = pool.getThreadCount();
+      std::size_t size = results.size();
+      std::vector<double> partials(threadCount*size);
+      for (int t=0; t<threadCount; ++t) initEntries(&partials[t*size]);
+
+      GridReductionJob<rank> job(quantities, tiling, partials, stride);
+      pool.run(job);
+
+      std::copy(partials.begin(), partials.begin() + size, results.begin());
+      for (int t=1; t<threadCount; ++t)
+        combineReductionEntries(&partials[t*size], &results[0], int(quantities.size()), stride);
+    }
+
+    /** Compute all quantities over the elements in range on all processes
+     *
+     *  range is the local part of the domain on this process, usually the
+     *  inner domain without ghost cells. The partial results of all
+     *  processes are combined in a single collective operation.
+     */
+    template<class GridType>
+    void execute(const RangeType &range, const DomainSubdivision<GridType> &subdivision)
+    {
+      execute(range);
+      if (!quantities.empty()) subdivision.reduceEntries(results, stride);
+    }
+
+    /** The value of quantity i */
+    double getValue(int i) const { return results[i*stride + 1]; }
+
+    /** The position of the minimum or maximum for quantities added with addMinLoc() or addMaxLoc() */
+    IndexType getPosition(int i) const
+    {
+      IndexType pos;
+      for (int d=0; d<rank; ++d) pos[d] = int(results[i*stride + 2 + d]);
+      return pos;
+    }
+};
+
+} // namespace schnek
+
+#endif // SCHNEK_GRIDREDUCTION_HPP_
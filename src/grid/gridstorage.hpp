@@ -28,6 +28,18 @@
 #define SCHNEK_GRIDSTORAGE_H_
 
 #include "array.hpp"
+#include "partition.hpp"
+#include "range.hpp"
+#include "../util/memorypool.hpp"
+#include "../util/threadpool.hpp"
+
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
 
 namespace schnek {
 
@@ -40,10 +52,12 @@ class SingleArrayInstantAllocation
   protected:
     T* data;
     T* data_fast;
-    int size;
+    std::ptrdiff_t size;
     IndexType low;
     IndexType high;
     IndexType dims;
+    /// The distance between neighbouring elements along each dimension
+    Array<std::ptrdiff_t,rank> strides;
 
   public:
     SingleArrayInstantAllocation()
@@ -53,6 +67,8 @@ class SingleArrayInstantAllocation
     /** resizes to grid with lower indices low[0],...,low[rank-1]
      *  and upper indices high[0],...,high[rank-1] */
     void resize(const IndexType &low_, const IndexType &high_);
+    /** exchanges the data with another allocation without copying */
+    void swap(SingleArrayInstantAllocation &other);
   private:
     /** */
     void deleteData();
@@ -70,10 +86,12 @@ class SingleArrayInstantFortranAllocation
   protected:
     T* data;
     T* data_fast;
-    int size;
+    std::ptrdiff_t size;
     IndexType low;
     IndexType high;
     IndexType dims;
+    /// The distance between neighbouring elements along each dimension
+    Array<std::ptrdiff_t,rank> strides;
 
   public:
     SingleArrayInstantFortranAllocation()
@@ -83,6 +101,8 @@ class SingleArrayInstantFortranAllocation
     /** resizes to grid with lower indices low[0],...,low[rank-1]
      *  and upper indices high[0],...,high[rank-1] */
     void resize(const IndexType &low_, const IndexType &high_);
+    /** exchanges the data with another allocation without copying */
+    void swap(SingleArrayInstantFortranAllocation &other);
   private:
     /** */
     void deleteData();
@@ -99,13 +119,15 @@ class SingleArrayLazyAllocation
   protected:
     T* data;
     T* data_fast;
-    int size;
+    std::ptrdiff_t size;
     IndexType low;
     IndexType high;
     IndexType dims;
+    /// The distance between neighbouring elements along each dimension
+    Array<std::ptrdiff_t,rank> strides;
 
   private:
-    int bufSize;
+    std::ptrdiff_t bufSize;
     double avgSize;
     double avgVar;
     double r;
@@ -117,14 +139,568 @@ class SingleArrayLazyAllocation
     /** resizes to grid with lower indices low[0],...,low[rank-1]
      *  and upper indices high[0],...,high[rank-1] */
     void resize(const IndexType &low_, const IndexType &high_);
+    /** exchanges the data with another allocation without copying */
+    void swap(SingleArrayLazyAllocation &other);
   private:
     SingleArrayLazyAllocation(const SingleArrayLazyAllocation&);
     /** */
     void deleteData();
     /** */
-    void newData(int size);
+    void newData(std::ptrdiff_t size);
 };
 
+/** Refers to an array in C ordering that is owned by the caller
+ *
+ *  No memory is allocated or freed. An external array is attached with
+ *  adopt(). Without an attached array, resize() only records the bounds, so
+ *  that the array can be attached later with adopt(data_). With an attached
+ *  array, resize() changes the bounds of the grid and requires that the new
+ *  size does not exceed the size of the array.
+ *
+ *  Copy constructing a grid with this policy is not supported because the
+ *  copy would not be attached to any array. It fails to compile. Assigning
+ *  another grid to a grid with an attached array copies the values.
+ */
+template<typename T, int rank>
+class SingleArrayExternalAllocation
+{
+  public:
+    typedef Array<int,rank> IndexType;
+
+  protected:
+    T* data;
+    T* data_fast;
+    std::ptrdiff_t size;
+    IndexType low;
+    IndexType high;
+    IndexType dims;
+    /// The distance between neighbouring elements along each dimension
+    Array<std::ptrdiff_t,rank> strides;
+
+  private:
+    /// The number of elements of the attached array
+    std::ptrdiff_t capacity;
+
+  public:
+    SingleArrayExternalAllocation()
+      : data(NULL) , data_fast(NULL), size(0), capacity(0) {}
+
+    /** changes the bounds of the grid, no memory is allocated */
+    void resize(const IndexType &low_, const IndexType &high_);
+    /** exchanges the attached arrays with another allocation */
+    void swap(SingleArrayExternalAllocation &other);
+
+    /** attach an external array holding the grid data from low_ to high_ */
+    void adopt(T *data_, const IndexType &low_, const IndexType &high_);
+    /** attach an external array holding the grid data for the current bounds */
+    void adopt(T *data_);
+    /** detach the external array, the bounds are kept */
+    void release();
+    /** returns true if an external array is attached */
+    bool isAttached() const { return data != NULL; }
+  private:
+    SingleArrayExternalAllocation(const SingleArrayExternalAllocation&);
+    SingleArrayExternalAllocation &operator=(const SingleArrayExternalAllocation&);
+    /** */
+    void setBounds(const IndexType &low_, const IndexType &high_);
+};
+
+/** Refers to an array in FORTRAN ordering that is owned by the caller
+ *
+ *  See SingleArrayExternalAllocation.
+ */
+template<typename T, int rank>
+class SingleArrayExternalFortranAllocation
+{
+  public:
+    typedef Array<int,rank> IndexType;
+
+  protected:
+    T* data;
+    T* data_fast;
+    std::ptrdiff_t size;
+    IndexType low;
+    IndexType high;
+    IndexType dims;
+    /// The distance between neighbouring elements along each dimension
+    Array<std::ptrdiff_t,rank> strides;
+
+  private:
+    /// The number of elements of the attached array
+    std::ptrdiff_t capacity;
+
+  public:
+    SingleArrayExternalFortranAllocation()
+      : data(NULL) , data_fast(NULL), size(0), capacity(0) {}
+
+    /** changes the bounds of the grid, no memory is allocated */
+    void resize(const IndexType &low_, const IndexType &high_);
+    /** exchanges the attached arrays with another allocation */
+    void swap(SingleArrayExternalFortranAllocation &other);
+
+    /** attach an external array holding the grid data from low_ to high_ */
+    void adopt(T *data_, const IndexType &low_, const IndexType &high_);
+    /** attach an external array holding the grid data for the current bounds */
+    void adopt(T *data_);
+    /** detach the external array, the bounds are kept */
+    void release();
+    /** returns true if an external array is attached */
+    bool isAttached() const { return data != NULL; }
+  private:
+    SingleArrayExternalFortranAllocation(const SingleArrayExternalFortranAllocation&);
+    SingleArrayExternalFortranAllocation &operator=(const SingleArrayExternalFortranAllocation&);
+    /** */
+    void setBounds(const IndexType &low_, const IndexType &high_);
+};
+
+/** Allocates the grid data lazily from the process wide MemoryPool
+ *
+ *  The allocation strategy is the same as for SingleArrayLazyAllocation.
+ *  The buffers, however, are obtained from the MemoryPool and returned to it
+ *  when they are no longer needed. Many grids that are resized frequently
+ *  will then reuse each other's buffers instead of calling the system
+ *  allocator. The buffer size is rounded up to the block size of the pool.
+ */
+template<typename T, int rank>
+class SingleArrayPooledAllocation
+{
+  public:
+    typedef Array<int,rank> IndexType;
+
+  protected:
+    T* data;
+    T* data_fast;
+    std::ptrdiff_t size;
+    IndexType low;
+    IndexType high;
+    IndexType dims;
+    /// The distance between neighbouring elements along each dimension
+    Array<std::ptrdiff_t,rank> strides;
+
+  private:
+    std::ptrdiff_t bufSize;
+    /// The size in bytes of the block obtained from the pool
+    std::size_t blockSize;
+    double avgSize;
+    double avgVar;
+    double r;
+
+  public:
+    SingleArrayPooledAllocation();
+
+    ~SingleArrayPooledAllocation();
+    /** resizes to grid with lower indices low[0],...,low[rank-1]
+     *  and upper indices high[0],...,high[rank-1] */
+    void resize(const IndexType &low_, const IndexType &high_);
+    /** exchanges the data with another allocation without copying */
+    void swap(SingleArrayPooledAllocation &other);
+  private:
+    SingleArrayPooledAllocation(const SingleArrayPooledAllocation&);
+    /** */
+    void deleteData();
+    /** */
+    void newData(std::ptrdiff_t size);
+};
+
+/** Allocates the grid data in a single array and first-touches it in parallel
+ *
+ *  The memory is obtained without writing to it. The elements are then
+ *  value-initialised by the threads of the ThreadPool, each one initialising
+ *  the slabs of the outermost dimension assigned to it by a StaticPartition.
+ *  On NUMA systems the pages are therefore placed close to the worker that
+ *  will work on them in parallelFor(). This only holds for loops over the
+ *  full range of the grid, since parallelFor() partitions the range it is
+ *  given and a smaller range results in a different partition. It also
+ *  requires the threads to stay on their processors, see
+ *  ThreadPool::setThreadBinding().
+ */
+template<typename T, int rank>
+class SingleArrayFirstTouchAllocation
+{
+  public:
+    typedef Array<int,rank> IndexType;
+
+  protected:
+    T* data;
+    T* data_fast;
+    std::ptrdiff_t size;
+    IndexType low;
+    IndexType high;
+    IndexType dims;
+    /// The distance between neighbouring elements along each dimension
+    Array<std::ptrdiff_t,rank> strides;
+
+  private:
+    int numThreads;
+
+    /** The job that initialises the slabs of the partition on the thread pool
+     *
+     *  Thread t initialises the chunks t, t+threadCount, ... of the partition.
+     */
+    class TouchJob : public ThreadPool::Job
+    {
+      private:
+        T* data;
+        std::ptrdiff_t stride;
+        StaticPartition partition;
+      public:
+        TouchJob(T* data_, std::ptrdiff_t stride_, const StaticPartition &partition_)
+          : data(data_), stride(stride_), partition(partition_) {}
+
+        void execute(int thread, int threadCount);
+    };
+
+  public:
+    SingleArrayFirstTouchAllocation()
+      : data(NULL) , data_fast(NULL), size(0), numThreads(ThreadPool::instance().getThreadCount()) {}
+
+    ~SingleArrayFirstTouchAllocation();
+    /** resizes to grid with lower indices low[0],...,low[rank-1]
+     *  and upper indices high[0],...,high[rank-1] */
+    void resize(const IndexType &low_, const IndexType &high_);
+    /** exchanges the data with another allocation without copying */
+    void swap(SingleArrayFirstTouchAllocation &other);
+
+    /** Sets the number of chunks of the partition used on the next resize
+     *
+     *  The default is the number of threads of the ThreadPool when the grid
+     *  is created. Only this value matches the partition of parallelFor().
+     */
+    void setNumThreads(int numThreads_) { numThreads = numThreads_; }
+    /** */
+    int getNumThreads() const { return numThreads; }
+
+    /** The partition of the outermost dimension used for the first touch */
+    StaticPartition getPartition() const
+    {
+      return StaticPartition(low[0], high[0], numThreads);
+    }
+  private:
+    SingleArrayFirstTouchAllocation(const SingleArrayFirstTouchAllocation&);
+    /** */
+    void deleteData();
+    /** */
+    void newData(const IndexType &low_, const IndexType &high_);
+};
+
+/** Allocates the grid data in a single array backed by huge pages
+ *
+ *  The memory is mapped with explicit 2MB huge pages (MAP_HUGETLB) if the
+ *  system provides them. Otherwise a 2MB aligned anonymous mapping is created
+ *  and the kernel is asked to back it with transparent huge pages using
+ *  madvise(MADV_HUGEPAGE). The page size that was obtained can be queried
+ *  with getPageSize(). Transparent huge pages are only reported if they are
+ *  enabled in /sys/kernel/mm/transparent_hugepage/enabled, but the kernel
+ *  may still back parts of the mapping with normal pages. The mapped size is rounded up to whole huge pages, so
+ *  this policy is only useful for large grids.
+ */
+template<typename T, int rank>
+class SingleArrayHugePageAllocation
+{
+  public:
+    typedef Array<int,rank> IndexType;
+
+    /// The size of the huge pages requested
+    static const std::size_t hugePageSize = 2*1024*1024;
+
+  protected:
+    T* data;
+    T* data_fast;
+    std::ptrdiff_t size;
+    IndexType low;
+    IndexType high;
+    IndexType dims;
+    /// The distance between neighbouring elements along each dimension
+    Array<std::ptrdiff_t,rank> strides;
+
+  private:
+    /// The number of bytes mapped
+    std::size_t mapSize;
+    /// The page size backing the current mapping
+    std::size_t pageSize;
+
+  public:
+    SingleArrayHugePageAllocation()
+      : data(NULL) , data_fast(NULL), size(0), mapSize(0), pageSize(0) {}
+
+    ~SingleArrayHugePageAllocation();
+    /** resizes to grid with lower indices low[0],...,low[rank-1]
+     *  and upper indices high[0],...,high[rank-1] */
+    void resize(const IndexType &low_, const IndexType &high_);
+    /** exchanges the data with another allocation without copying */
+    void swap(SingleArrayHugePageAllocation &other);
+
+    /** The size of the pages backing the grid data
+     *
+     *  This is hugePageSize if explicit huge pages could be mapped or if the
+     *  kernel accepted the request for transparent huge pages. Transparent
+     *  huge pages are a hint, and the kernel may still use normal pages for
+     *  parts of the mapping. If neither method is available, the normal
+     *  system page size is returned.
+     */
+    std::size_t getPageSize() const { return pageSize; }
+  private:
+    SingleArrayHugePageAllocation(const SingleArrayHugePageAllocation&);
+    /** */
+    void deleteData();
+    /** */
+    void newData(const IndexType &low_, const IndexType &high_);
+};
+
+/** Maps the grid data from a file into memory
+ *
+ *  The file starts with a header that contains the rank, the element size and
+ *  the index bounds of the grid. The data follows in C ordering at the offset
+ *  given in the header. Mapping a file does not read the data. Pages are read
+ *  and written back by the operating system when they are accessed.
+ *
+ *  If no file has been mapped, resize() creates an anonymous mapping that is
+ *  not backed by a file. If a file is mapped, resize() re-creates the file
+ *  with the new bounds. In both cases the previous contents are lost.
+ *
+ *  The element type must be a POD type. No constructors or destructors are
+ *  called for the elements. Translating the grid does not change the bounds
+ *  stored in the file header.
+ */
+template<typename T, int rank>
+class SingleArrayMappedAllocation
+{
+  public:
+    typedef Array<int,rank> IndexType;
+
+  protected:
+    T* data;
+    T* data_fast;
+    std::ptrdiff_t size;
+    IndexType low;
+    IndexType high;
+    IndexType dims;
+    /// The distance between neighbouring elements along each dimension
+    Array<std::ptrdiff_t,rank> strides;
+
+  private:
+    struct FileHeader
+    {
+      char magic[8];
+      boost::int32_t gridRank;
+      boost::int32_t elementSize;
+      boost::int64_t dataOffset;
+      boost::int32_t low[rank];
+      boost::int32_t high[rank];
+    };
+
+    std::string fileName;
+    int fd;
+    char *mapBase;
+    std::size_t mapSize;
+
+  public:
+    SingleArrayMappedAllocation();
+
+    ~SingleArrayMappedAllocation();
+    /** resizes to grid with lower indices low[0],...,low[rank-1]
+     *  and upper indices high[0],...,high[rank-1] */
+    void resize(const IndexType &low_, const IndexType &high_);
+    /** exchanges the data with another allocation without copying */
+    void swap(SingleArrayMappedAllocation &other);
+
+    /** Creates the file fileName_ for a grid with the given bounds and maps it
+     *
+     *  An existing file is overwritten. The grid data is initialised to zero.
+     */
+    void mapFile(const std::string &fileName_, const IndexType &low_, const IndexType &high_);
+
+    /** Maps an existing grid file
+     *
+     *  The bounds of the grid are taken from the file header. An exception is
+     *  thrown if the rank or the element size do not match.
+     */
+    void mapFile(const std::string &fileName_);
+
+    /** Writes modified pages back to the file and waits for completion */
+    void sync();
+
+    /** Unmaps the grid data and closes the file
+     *
+     *  The grid is empty afterwards.
+     */
+    void unmap();
+
+    /** */
+    bool isMapped() const { return fd >= 0; }
+    /** */
+    const std::string &getFileName() const { return fileName; }
+  private:
+    SingleArrayMappedAllocation(const SingleArrayMappedAllocation&);
+    /** */
+    void setBounds(const IndexType &low_, const IndexType &high_);
+    /** */
+    void mapRegion(std::size_t dataOffset);
+};
+
+/** Allocates the grid data in a single array of bricks
+ *
+ *  The innermost three dimensions (or all dimensions if the rank is smaller)
+ *  are split into cubic bricks with an edge length of brickEdge. The elements
+ *  of a brick are stored contiguously in C ordering. The bricks themselves,
+ *  together with the outer dimensions, are also arranged in C ordering. The
+ *  tiled dimensions are padded to a whole number of bricks.
+ */
+template<typename T, int rank>
+class SingleArrayTiledAllocation
+{
+  public:
+    typedef Array<int,rank> IndexType;
+
+    /// The number of dimensions that are split into bricks
+    static const int tiledRank = (rank < 3) ? rank : 3;
+    /// The binary logarithm of the brick edge length
+    static const int brickBits = 3;
+    /// The edge length of a brick
+    static const int brickEdge = 1 << brickBits;
+    /// The number of elements in a brick
+    static const int brickSize = 1 << (brickBits*tiledRank);
+
+  protected:
+    T* data;
+    T* data_fast;
+    std::ptrdiff_t size;
+    IndexType low;
+    IndexType high;
+    IndexType dims;
+
+    /// The number of bricks in each tiled dimension and the extent of the other dimensions
+    IndexType bricks;
+    /// The number of elements allocated, including the padding
+    std::ptrdiff_t bufSize;
+
+  public:
+    SingleArrayTiledAllocation()
+      : data(NULL) , data_fast(NULL), size(0), bufSize(0) {}
+
+    ~SingleArrayTiledAllocation();
+    /** resizes to grid with lower indices low[0],...,low[rank-1]
+     *  and upper indices high[0],...,high[rank-1] */
+    void resize(const IndexType &low_, const IndexType &high_);
+    /** exchanges the data with another allocation without copying */
+    void swap(SingleArrayTiledAllocation &other);
+  private:
+    SingleArrayTiledAllocation(const SingleArrayTiledAllocation&);
+    /** */
+    void deleteData();
+    /** */
+    void newData(const IndexType &low_, const IndexType &high_);
+};
+
+/** Allocates the grid data in a single array that is aligned to cache lines
+ *
+ *  The start of the array is aligned to a 64 byte boundary and the innermost
+ *  dimension is padded to a whole number of cache lines. This means that every
+ *  row of the grid starts on a cache line boundary. The padding elements are
+ *  not part of the grid.
+ */
+template<typename T, int rank>
+class SingleArrayAlignedAllocation
+{
+  public:
+    typedef Array<int,rank> IndexType;
+
+    /// The alignment of the rows in bytes
+    static const std::size_t alignment = 64;
+
+  protected:
+    T* data;
+    T* data_fast;
+    std::ptrdiff_t size;
+    IndexType low;
+    IndexType high;
+    IndexType dims;
+    /// The distance between neighbouring elements along each dimension, including the padding
+    Array<std::ptrdiff_t,rank> strides;
+
+    /// The extent of the innermost dimension including the padding
+    int rowLength;
+    /// The number of elements allocated, including the padding
+    std::ptrdiff_t bufSize;
+
+  public:
+    SingleArrayAlignedAllocation()
+      : data(NULL) , data_fast(NULL), size(0), rowLength(0), bufSize(0) {}
+
+    ~SingleArrayAlignedAllocation();
+    /** resizes to grid with lower indices low[0],...,low[rank-1]
+     *  and upper indices high[0],...,high[rank-1] */
+    void resize(const IndexType &low_, const IndexType &high_);
+    /** exchanges the data with another allocation without copying */
+    void swap(SingleArrayAlignedAllocation &other);
+  private:
+    SingleArrayAlignedAllocation(const SingleArrayAlignedAllocation&);
+    /** */
+    void deleteData();
+    /** */
+    void newData(const IndexType &low_, const IndexType &high_);
+};
+
+/** Computes the strides of a dense array in C ordering
+ *
+ *  The last dimension has unit stride.
+ */
+template<int rank>
+void computeCStrides(const Array<int,rank> &dims, Array<std::ptrdiff_t,rank> &strides);
+
+/** Computes the strides of a dense array in Fortran ordering
+ *
+ *  The first dimension has unit stride.
+ */
+template<int rank>
+void computeFortranStrides(const Array<int,rank> &dims, Array<std::ptrdiff_t,rank> &strides);
+
+/** The linear offset of an index in a dense array with given strides
+ *
+ *  The sum over the dimensions dim, ..., rank-1 is expanded at compile time
+ *  into a sequence of multiplications and additions without a loop. The
+ *  dimension unitDim has unit stride and is added without a multiplication.
+ */
+template<int rank, int unitDim, int dim = 0>
+struct StridedOffset
+{
+    template<class IndexType, class StrideType>
+    static std::ptrdiff_t get(const IndexType &index, const StrideType &strides)
+    {
+      return ((dim == unitDim) ? std::ptrdiff_t(index[dim]) : index[dim]*strides[dim])
+          + StridedOffset<rank, unitDim, dim+1>::get(index, strides);
+    }
+};
+
+template<int rank, int unitDim>
+struct StridedOffset<rank, unitDim, rank>
+{
+    template<class IndexType, class StrideType>
+    static std::ptrdiff_t get(const IndexType &, const StrideType &) { return 0; }
+};
+
+/** Shifts the data of a strided array along one dimension
+ *
+ *  After the call the element at relative index r holds the value that was
+ *  at r + distance*e_dim. Elements without a source are set to T(). The
+ *  dimension rowDim must have unit stride; the data is moved row by row.
+ */
+template<typename T, int rank>
+void shiftStridedData(T *data,
+                      const Array<int,rank> &dims,
+                      const Array<std::ptrdiff_t,rank> &strides,
+                      int rowDim,
+                      int dim,
+                      int distance);
+
+/** Shifts the contents of a grid storage along one dimension
+ *
+ *  Works like shiftStridedData() but moves the elements one by one using the
+ *  get() method of the storage. This is used for layouts without rows.
+ */
+template<typename T, class StorageType>
+void shiftStorageElements(StorageType &storage, int dim, int distance);
+
 /** Stores the grid data in a single array
  *
  *  Layout of the data is in FORTRAN ordering.
@@ -188,7 +764,7 @@ class SingleArrayGridStorageBase : public AllocationPolicy<T, rank> {
     /** */
     int getDims(int k) const { return this->dims[k]; }
 
-    int getSize() const { return this->size; }
+    std::ptrdiff_t getSize() const { return this->size; }
 
     storage_iterator begin() { return storage_iterator(this->data); }
     storage_iterator end() { return storage_iterator(this->data + this->size); }
@@ -211,6 +787,53 @@ class SingleArrayGridCOrderStorageBase : public SingleArrayGridStorageBase<T, ra
 
     T &get(const IndexType &index);
     const T &get(const IndexType &index) const;
+
+    /** Access an element of a one dimensional grid without any checks */
+    T &at(int i) { BOOST_STATIC_ASSERT(rank==1); return this->data_fast[i]; }
+    /** */
+    const T &at(int i) const { BOOST_STATIC_ASSERT(rank==1); return this->data_fast[i]; }
+    /** Access an element of a two dimensional grid without any checks */
+    T &at(int i, int j) { BOOST_STATIC_ASSERT(rank==2); return this->data_fast[i*this->strides[0] + j]; }
+    /** */
+    const T &at(int i, int j) const { BOOST_STATIC_ASSERT(rank==2); return this->data_fast[i*this->strides[0] + j]; }
+    /** Access an element of a three dimensional grid without any checks */
+    T &at(int i, int j, int k)
+    {
+      BOOST_STATIC_ASSERT(rank==3);
+      return this->data_fast[i*this->strides[0] + j*this->strides[1] + k];
+    }
+    /** */
+    const T &at(int i, int j, int k) const
+    {
+      BOOST_STATIC_ASSERT(rank==3);
+      return this->data_fast[i*this->strides[0] + j*this->strides[1] + k];
+    }
+
+    /** The distance in memory between neighbouring elements along each dimension */
+    const Array<std::ptrdiff_t,rank> &getStrides() const { return this->strides; }
+
+    /** The dimension along which the elements are contiguous in memory */
+    int getSpanDim() const { return rank-1; }
+
+    /** The number of contiguous elements starting at index along getSpanDim() */
+    std::ptrdiff_t getSpanLength(const IndexType &index) const
+    {
+      return this->high[rank-1] - index[rank-1] + 1;
+    }
+
+    /** Moves the grid data by distance cells along dimension dim
+     *
+     *  Afterwards the cell at index i holds the value that was at
+     *  i + distance*e_dim. The cells that have been exposed are set to T().
+     *  The index bounds are not changed and no memory is allocated.
+     */
+    void shift(int dim, int distance);
+
+    /** Shifts the index bounds by offset without moving the data
+     *
+     *  The value that was at index i is afterwards found at i + offset.
+     */
+    void translate(const IndexType &offset);
 };
 
 template<typename T, int rank, template<typename, int> class AllocationPolicy>
@@ -226,6 +849,53 @@ class SingleArrayGridFortranOrderStorageBase : public SingleArrayGridStorageBase
 
     T &get(const IndexType &index);
     const T &get(const IndexType &index) const;
+
+    /** Access an element of a one dimensional grid without any checks */
+    T &at(int i) { BOOST_STATIC_ASSERT(rank==1); return this->data_fast[i]; }
+    /** */
+    const T &at(int i) const { BOOST_STATIC_ASSERT(rank==1); return this->data_fast[i]; }
+    /** Access an element of a two dimensional grid without any checks */
+    T &at(int i, int j) { BOOST_STATIC_ASSERT(rank==2); return this->data_fast[i + j*this->strides[1]]; }
+    /** */
+    const T &at(int i, int j) const { BOOST_STATIC_ASSERT(rank==2); return this->data_fast[i + j*this->strides[1]]; }
+    /** Access an element of a three dimensional grid without any checks */
+    T &at(int i, int j, int k)
+    {
+      BOOST_STATIC_ASSERT(rank==3);
+      return this->data_fast[i + j*this->strides[1] + k*this->strides[2]];
+    }
+    /** */
+    const T &at(int i, int j, int k) const
+    {
+      BOOST_STATIC_ASSERT(rank==3);
+      return this->data_fast[i + j*this->strides[1] + k*this->strides[2]];
+    }
+
+    /** The distance in memory between neighbouring elements along each dimension */
+    const Array<std::ptrdiff_t,rank> &getStrides() const { return this->strides; }
+
+    /** The dimension along which the elements are contiguous in memory */
+    int getSpanDim() const { return 0; }
+
+    /** The number of contiguous elements starting at index along getSpanDim() */
+    std::ptrdiff_t getSpanLength(const IndexType &index) const
+    {
+      return this->high[0] - index[0] + 1;
+    }
+
+    /** Moves the grid data by distance cells along dimension dim
+     *
+     *  Afterwards the cell at index i holds the value that was at
+     *  i + distance*e_dim. The cells that have been exposed are set to T().
+     *  The index bounds are not changed and no memory is allocated.
+     */
+    void shift(int dim, int distance);
+
+    /** Shifts the index bounds by offset without moving the data
+     *
+     *  The value that was at index i is afterwards found at i + offset.
+     */
+    void translate(const IndexType &offset);
 };
 
 template<typename T, int rank>
@@ -271,6 +941,644 @@ class LazyArrayGridStorage
         : BaseType(low_, high_) {}
 };
 
+/** Stores the grid data in an external array in C ordering
+ *
+ *  The array is owned by the caller and attached with adopt().
+ */
+template<typename T, int rank>
+class ExternalArrayGridStorage
+    : public SingleArrayGridCOrderStorageBase<T, rank, SingleArrayExternalAllocation>
+{
+  public:
+    typedef SingleArrayGridCOrderStorageBase<T, rank, SingleArrayExternalAllocation> BaseType;
+    typedef typename BaseType::IndexType IndexType;
+
+    ExternalArrayGridStorage() : BaseType() {}
+
+    ExternalArrayGridStorage(const IndexType &low_, const IndexType &high_)
+        : BaseType(low_, high_) {}
+};
+
+/** Stores the grid data in an external array in FORTRAN ordering
+ *
+ *  The array is owned by the caller and attached with adopt().
+ */
+template<typename T, int rank>
+class ExternalArrayGridStorageFortran
+    : public SingleArrayGridFortranOrderStorageBase<T, rank, SingleArrayExternalFortranAllocation>
+{
+  public:
+    typedef SingleArrayGridFortranOrderStorageBase<T, rank, SingleArrayExternalFortranAllocation> BaseType;
+    typedef typename BaseType::IndexType IndexType;
+
+    ExternalArrayGridStorageFortran() : BaseType() {}
+
+    ExternalArrayGridStorageFortran(const IndexType &low_, const IndexType &high_)
+        : BaseType(low_, high_) {}
+};
+
+/** Stores the grid data in a lazily allocated array drawn from the MemoryPool
+ *
+ *  Layout of the data is in C ordering.
+ */
+template<typename T, int rank>
+class PooledArrayGridStorage
+    : public SingleArrayGridCOrderStorageBase<T, rank, SingleArrayPooledAllocation>
+{
+  public:
+    typedef SingleArrayGridCOrderStorageBase<T, rank, SingleArrayPooledAllocation> BaseType;
+    typedef typename BaseType::IndexType IndexType;
+
+    PooledArrayGridStorage() : BaseType() {}
+
+    PooledArrayGridStorage(const IndexType &low_, const IndexType &high_)
+        : BaseType(low_, high_) {}
+};
+
+/** Stores the grid data in a single array that is first-touched in parallel
+ *
+ *  Layout of the data is in C ordering.
+ */
+template<typename T, int rank>
+class FirstTouchArrayGridStorage
+    : public SingleArrayGridCOrderStorageBase<T, rank, SingleArrayFirstTouchAllocation>
+{
+  public:
+    typedef SingleArrayGridCOrderStorageBase<T, rank, SingleArrayFirstTouchAllocation> BaseType;
+    typedef typename BaseType::IndexType IndexType;
+
+    FirstTouchArrayGridStorage() : BaseType() {}
+
+    FirstTouchArrayGridStorage(const IndexType &low_, const IndexType &high_)
+        : BaseType(low_, high_) {}
+};
+
+/** Stores the grid data in a single array that is backed by huge pages
+ *
+ *  Layout of the data is in C ordering.
+ */
+template<typename T, int rank>
+class HugePageArrayGridStorage
+    : public SingleArrayGridCOrderStorageBase<T, rank, SingleArrayHugePageAllocation>
+{
+  public:
+    typedef SingleArrayGridCOrderStorageBase<T, rank, SingleArrayHugePageAllocation> BaseType;
+    typedef typename BaseType::IndexType IndexType;
+
+    HugePageArrayGridStorage() : BaseType() {}
+
+    HugePageArrayGridStorage(const IndexType &low_, const IndexType &high_)
+        : BaseType(low_, high_) {}
+};
+
+/** Stores the grid data in a memory mapped file
+ *
+ *  Layout of the data is in C ordering.
+ */
+template<typename T, int rank>
+class MappedGridStorage
+    : public SingleArrayGridCOrderStorageBase<T, rank, SingleArrayMappedAllocation>
+{
+  public:
+    typedef SingleArrayGridCOrderStorageBase<T, rank, SingleArrayMappedAllocation> BaseType;
+    typedef typename BaseType::IndexType IndexType;
+
+    MappedGridStorage() : BaseType() {}
+
+    MappedGridStorage(const IndexType &low_, const IndexType &high_)
+        : BaseType(low_, high_) {}
+};
+
+/** Stores the grid data in a single, cache line aligned array
+ *
+ *  Layout of the data is in C ordering. The innermost dimension is padded so
+ *  that every row starts on a cache line boundary. The storage iterators skip
+ *  the padding and only visit the elements of the grid.
+ */
+template<typename T, int rank>
+class AlignedArrayGridStorage
+    : public SingleArrayGridStorageBase<T, rank, SingleArrayAlignedAllocation>
+{
+  public:
+    typedef SingleArrayGridStorageBase<T, rank, SingleArrayAlignedAllocation> BaseType;
+    typedef typename BaseType::IndexType IndexType;
+
+    class storage_iterator {
+      protected:
+        T* element;
+        int col;
+        int rowSize;
+        int padding;
+        storage_iterator(T* element_, int rowSize_, int padding_)
+          : element(element_), col(0), rowSize(rowSize_), padding(padding_) {}
+
+        friend class AlignedArrayGridStorage;
+
+      public:
+        storage_iterator(const storage_iterator &it)
+          : element(it.element), col(it.col), rowSize(it.rowSize), padding(it.padding) {}
+        T& operator*() { return *element;}
+        storage_iterator &operator++()
+        {
+          ++element;
+          if (++col == rowSize) { col = 0; element += padding; }
+          return *this;
+        }
+        bool operator==(const storage_iterator &SI)
+          { return element == SI.element; }
+        bool operator!=(const storage_iterator &SI)
+          { return element != SI.element; }
+    };
+
+    class const_storage_iterator {
+      protected:
+        const T* element;
+        int col;
+        int rowSize;
+        int padding;
+        const_storage_iterator(const T* element_, int rowSize_, int padding_)
+          : element(element_), col(0), rowSize(rowSize_), padding(padding_) {}
+
+        friend class AlignedArrayGridStorage;
+
+      public:
+        const T& operator*() { return *element;}
+        const_storage_iterator &operator++()
+        {
+          ++element;
+          if (++col == rowSize) { col = 0; element += padding; }
+          return *this;
+        }
+        bool operator==(const const_storage_iterator &SI)
+          { return element == SI.element; }
+        bool operator!=(const const_storage_iterator &SI)
+          { return element != SI.element; }
+    };
+
+    AlignedArrayGridStorage() : BaseType() {}
+
+    AlignedArrayGridStorage(const IndexType &low_, const IndexType &high_)
+        : BaseType(low_, high_) {}
+
+    T &get(const IndexType &index);
+    const T &get(const IndexType &index) const;
+
+    /** Access an element of a one dimensional grid without any checks */
+    T &at(int i) { BOOST_STATIC_ASSERT(rank==1); return this->data_fast[i]; }
+    /** */
+    const T &at(int i) const { BOOST_STATIC_ASSERT(rank==1); return this->data_fast[i]; }
+    /** Access an element of a two dimensional grid without any checks */
+    T &at(int i, int j) { BOOST_STATIC_ASSERT(rank==2); return this->data_fast[i*this->strides[0] + j]; }
+    /** */
+    const T &at(int i, int j) const { BOOST_STATIC_ASSERT(rank==2); return this->data_fast[i*this->strides[0] + j]; }
+    /** Access an element of a three dimensional grid without any checks */
+    T &at(int i, int j, int k)
+    {
+      BOOST_STATIC_ASSERT(rank==3);
+      return this->data_fast[i*this->strides[0] + j*this->strides[1] + k];
+    }
+    /** */
+    const T &at(int i, int j, int k) const
+    {
+      BOOST_STATIC_ASSERT(rank==3);
+      return this->data_fast[i*this->strides[0] + j*this->strides[1] + k];
+    }
+
+    /** The distance in memory between neighbouring elements along each dimension
+     *
+     *  The strides include the padding of the innermost dimension.
+     */
+    const Array<std::ptrdiff_t,rank> &getStrides() const { return this->strides; }
+
+    /** The dimension along which the elements are contiguous in memory */
+    int getSpanDim() const { return rank-1; }
+
+    /** The number of contiguous elements starting at index along getSpanDim() */
+    std::ptrdiff_t getSpanLength(const IndexType &index) const
+    {
+      return this->high[rank-1] - index[rank-1] + 1;
+    }
+
+    /** Moves the grid data by distance cells along dimension dim
+     *
+     *  Afterwards the cell at index i holds the value that was at
+     *  i + distance*e_dim. The cells that have been exposed are set to T().
+     *  The index bounds are not changed and no memory is allocated.
+     */
+    void shift(int dim, int distance);
+
+    /** Shifts the index bounds by offset without moving the data
+     *
+     *  The value that was at index i is afterwards found at i + offset.
+     */
+    void translate(const IndexType &offset);
+
+    /** The dimensions of the allocated array
+     *
+     *  This is the same as getDims() except for the innermost dimension, which
+     *  includes the padding.
+     */
+    IndexType getPaddedDims() const
+    {
+      IndexType padded(this->dims);
+      padded[rank-1] = this->rowLength;
+      return padded;
+    }
+
+    storage_iterator begin() { return storage_iterator(this->data, this->dims[rank-1], this->rowLength - this->dims[rank-1]); }
+    storage_iterator end() { return storage_iterator(this->data + this->bufSize, this->dims[rank-1], this->rowLength - this->dims[rank-1]); }
+
+    const_storage_iterator cbegin() const { return const_storage_iterator(this->data, this->dims[rank-1], this->rowLength - this->dims[rank-1]); }
+    const_storage_iterator cend() const { return const_storage_iterator(this->data + this->bufSize, this->dims[rank-1], this->rowLength - this->dims[rank-1]); }
+};
+
+/** Stores the grid data in bricks of brickEdge^3 elements
+ *
+ *  Neighbouring cells in all three innermost directions are likely to share
+ *  a cache line or a page. The storage iterators visit the grid brick by
+ *  brick and skip the padding.
+ *
+ *  Kernels can work on one brick at a time. getBrickRange() returns the part
+ *  of the grid covered by a brick and getBrickData() a pointer to the first
+ *  element of the brick. Inside a brick, the element with the local index
+ *  (a,b,c) relative to the lower corner of the brick range is found at
+ *  offset (a*brickEdge + b)*brickEdge + c.
+ */
+template<typename T, int rank>
+class TiledArrayGridStorage
+    : public SingleArrayGridStorageBase<T, rank, SingleArrayTiledAllocation>
+{
+  public:
+    typedef SingleArrayGridStorageBase<T, rank, SingleArrayTiledAllocation> BaseType;
+    typedef typename BaseType::IndexType IndexType;
+    typedef Range<int, rank> RangeType;
+
+    static const int tiledRank = BaseType::tiledRank;
+    static const int brickBits = BaseType::brickBits;
+    static const int brickEdge = BaseType::brickEdge;
+    static const int brickSize = BaseType::brickSize;
+
+  private:
+    /// The position of an iterator inside the brick array
+    struct Position
+    {
+      std::ptrdiff_t brick;
+      int local[tiledRank];
+      int extent[tiledRank];
+    };
+
+    void startBrick(Position &pos, std::ptrdiff_t brick) const;
+    std::ptrdiff_t advance(Position &pos) const;
+
+  public:
+    class storage_iterator {
+      protected:
+        const TiledArrayGridStorage *storage;
+        Position pos;
+        T* element;
+        storage_iterator(const TiledArrayGridStorage *storage_, std::ptrdiff_t brick)
+          : storage(storage_)
+        {
+          storage->startBrick(pos, brick);
+          element = storage->data + brick*brickSize;
+        }
+
+        friend class TiledArrayGridStorage;
+
+      public:
+        storage_iterator(const storage_iterator &it)
+          : storage(it.storage), pos(it.pos), element(it.element) {}
+        T& operator*() { return *element;}
+        storage_iterator &operator++()
+        {
+          element = storage->data + storage->advance(pos);
+          return *this;
+        }
+        bool operator==(const storage_iterator &SI)
+          { return element == SI.element; }
+        bool operator!=(const storage_iterator &SI)
+          { return element != SI.element; }
+    };
+
+    class const_storage_iterator {
+      protected:
+        const TiledArrayGridStorage *storage;
+        Position pos;
+        const T* element;
+        const_storage_iterator(const TiledArrayGridStorage *storage_, std::ptrdiff_t brick)
+          : storage(storage_)
+        {
+          storage->startBrick(pos, brick);
+          element = storage->data + brick*brickSize;
+        }
+
+        friend class TiledArrayGridStorage;
+
+      public:
+        const T& operator*() { return *element;}
+        const_storage_iterator &operator++()
+        {
+          element = storage->data + storage->advance(pos);
+          return *this;
+        }
+        bool operator==(const const_storage_iterator &SI)
+          { return element == SI.element; }
+        bool operator!=(const const_storage_iterator &SI)
+          { return element != SI.element; }
+    };
+
+    TiledArrayGridStorage() : BaseType() {}
+
+    TiledArrayGridStorage(const IndexType &low_, const IndexType &high_)
+        : BaseType(low_, high_) {}
+
+    T &get(const IndexType &index);
+    const T &get(const IndexType &index) const;
+
+    /** The dimension along which the elements are contiguous in memory */
+    int getSpanDim() const { return rank-1; }
+
+    /** The number of contiguous elements starting at index along getSpanDim()
+     *
+     *  Spans end at the boundary of a brick.
+     */
+    std::ptrdiff_t getSpanLength(const IndexType &index) const
+    {
+      int r = index[rank-1] - this->low[rank-1];
+      return std::min(brickEdge - (r & (brickEdge-1)), this->high[rank-1] - index[rank-1] + 1);
+    }
+
+    /** Moves the grid data by distance cells along dimension dim
+     *
+     *  Afterwards the cell at index i holds the value that was at
+     *  i + distance*e_dim. The cells that have been exposed are set to T().
+     *  The index bounds are not changed and no memory is allocated.
+     */
+    void shift(int dim, int distance);
+
+    /** Shifts the index bounds by offset without moving the data
+     *
+     *  The value that was at index i is afterwards found at i + offset.
+     */
+    void translate(const IndexType &offset);
+
+    /** The number of bricks, including the bricks along the outer dimensions */
+    std::ptrdiff_t getBrickCount() const { return this->bufSize / brickSize; }
+
+    /** The part of the grid covered by brick number brick */
+    RangeType getBrickRange(std::ptrdiff_t brick) const;
+
+    /** A pointer to the first element of brick number brick */
+    T* getBrickData(std::ptrdiff_t brick) const { return this->data + brick*brickSize; }
+
+    storage_iterator begin() { return storage_iterator(this, 0); }
+    storage_iterator end() { return storage_iterator(this, getBrickCount()); }
+
+    const_storage_iterator cbegin() const { return const_storage_iterator(this, 0); }
+    const_storage_iterator cend() const { return const_storage_iterator(this, getBrickCount()); }
+};
+
+
+/** Stores the grid data in tiles that are only allocated when they are written
+ *
+ *  The index space is split into tiles in the same way as the bricks of
+ *  TiledArrayGridStorage. The innermost three dimensions are split into
+ *  cubic tiles with an edge length of tileEdge, each outer index forms a
+ *  separate layer of tiles. Initially no tile is allocated and all elements
+ *  read as the fill value.
+ *
+ *  A tile is allocated by the first non-const access to one of its elements.
+ *  Const access never allocates and returns the fill value for elements in
+ *  tiles that have not been allocated. Note that the non-const grid accessors
+ *  count as a write, even if the returned reference is only read from.
+ *  Kernels that only read a grid should therefore access it through a const
+ *  reference. The const spans, pack() and the source grids of copies and
+ *  grid expressions use the const access and do not allocate tiles.
+ *
+ *  Kernels that only need to visit the active part of the grid can loop over
+ *  the tiles and skip those for which isTileAllocated() returns false. The
+ *  storage iterators visit the grid tile by tile. The non-const iterators
+ *  allocate every tile they pass, so assigning a value to the whole grid or
+ *  copying the grid allocates all tiles. Use clear() to release all tiles
+ *  and reset the grid to the fill value.
+ */
+template<typename T, int rank>
+class SparseTiledGridStorage
+{
+  public:
+    typedef Array<int,rank> IndexType;
+    typedef Range<int, rank> RangeType;
+
+    /// The number of dimensions that are split into tiles
+    static const int tiledRank = (rank < 3) ? rank : 3;
+    /// The binary logarithm of the tile edge length
+    static const int tileBits = 3;
+    /// The edge length of a tile
+    static const int tileEdge = 1 << tileBits;
+    /// The number of elements in a tile
+    static const int tileSize = 1 << (tileBits*tiledRank);
+
+  private:
+    IndexType low;
+    IndexType high;
+    IndexType dims;
+    /// The number of tiles in each tiled dimension and the extent of the other dimensions
+    IndexType tiles;
+    /// The data of each tile, NULL if the tile has not been allocated
+    std::vector<T*> tileData;
+    std::ptrdiff_t allocatedTiles;
+    /// The value of all elements in tiles that have not been allocated
+    T fillValue;
+    /// A row of fill values that const spans of unallocated tiles point into
+    std::vector<T> fillRow;
+
+    /// The position of an iterator inside the tiles
+    struct Position
+    {
+      std::ptrdiff_t tile;
+      std::ptrdiff_t offset;
+      int local[tiledRank];
+      int extent[tiledRank];
+    };
+
+    void startTile(Position &pos, std::ptrdiff_t tile) const;
+    void advance(Position &pos) const;
+    void locate(const IndexType &index, std::ptrdiff_t &tile, std::ptrdiff_t &offset) const;
+    void deleteData();
+
+    SparseTiledGridStorage(const SparseTiledGridStorage&);
+  public:
+    class storage_iterator {
+      protected:
+        SparseTiledGridStorage *storage;
+        Position pos;
+        storage_iterator(SparseTiledGridStorage *storage_, std::ptrdiff_t tile)
+          : storage(storage_)
+        {
+          storage->startTile(pos, tile);
+        }
+
+        friend class SparseTiledGridStorage;
+
+      public:
+        storage_iterator(const storage_iterator &it)
+          : storage(it.storage), pos(it.pos) {}
+        T& operator*() { return storage->allocateTile(pos.tile)[pos.offset]; }
+        storage_iterator &operator++()
+        {
+          storage->advance(pos);
+          return *this;
+        }
+        bool operator==(const storage_iterator &SI)
+          { return (pos.tile == SI.pos.tile) && (pos.offset == SI.pos.offset); }
+        bool operator!=(const storage_iterator &SI)
+          { return (pos.tile != SI.pos.tile) || (pos.offset != SI.pos.offset); }
+    };
+
+    class const_storage_iterator {
+      protected:
+        const SparseTiledGridStorage *storage;
+        Position pos;
+        const_storage_iterator(const SparseTiledGridStorage *storage_, std::ptrdiff_t tile)
+          : storage(storage_)
+        {
+          storage->startTile(pos, tile);
+        }
+
+        friend class SparseTiledGridStorage;
+
+      public:
+        const T& operator*()
+        {
+          const T *data = storage->tileData[pos.tile];
+          return (data != NULL) ? data[pos.offset] : storage->fillValue;
+        }
+        const_storage_iterator &operator++()
+        {
+          storage->advance(pos);
+          return *this;
+        }
+        bool operator==(const const_storage_iterator &SI)
+          { return (pos.tile == SI.pos.tile) && (pos.offset == SI.pos.offset); }
+        bool operator!=(const const_storage_iterator &SI)
+          { return (pos.tile != SI.pos.tile) || (pos.offset != SI.pos.offset); }
+    };
+
+    SparseTiledGridStorage();
+
+    SparseTiledGridStorage(const IndexType &low_, const IndexType &high_);
+
+    ~SparseTiledGridStorage();
+
+    /** resizes to grid with lower indices low[0],...,low[rank-1]
+     *  and upper indices high[0],...,high[rank-1]
+     *
+     *  All tiles are released.
+     */
+    void resize(const IndexType &low_, const IndexType &high_);
+
+    /** exchanges the data with another storage without copying */
+    void swap(SparseTiledGridStorage &other);
+
+    /** access an element, allocating its tile if necessary */
+    T &get(const IndexType &index)
+    {
+      std::ptrdiff_t tile, offset;
+      locate(index, tile, offset);
+      return allocateTile(tile)[offset];
+    }
+
+    /** read an element without allocating */
+    const T &get(const IndexType &index) const
+    {
+      std::ptrdiff_t tile, offset;
+      locate(index, tile, offset);
+      const T *data = tileData[tile];
+      return (data != NULL) ? data[offset] : fillRow[offset & (tileEdge-1)];
+    }
+
+    /** The dimension along which spans are formed */
+    int getSpanDim() const { return rank-1; }
+
+    /** The number of contiguous elements starting at index along getSpanDim()
+     *
+     *  Spans end at the boundary of a tile. In tiles that have not been
+     *  allocated, the const spans point into a row of fill values.
+     */
+    std::ptrdiff_t getSpanLength(const IndexType &index) const
+    {
+      int r = index[rank-1] - low[rank-1];
+      return std::min(tileEdge - (r & (tileEdge-1)), high[rank-1] - index[rank-1] + 1);
+    }
+
+    /** */
+    const IndexType& getLo() const { return low; }
+    /** */
+    const IndexType& getHi() const { return high; }
+    /** */
+    const IndexType& getDims() const { return dims; }
+
+    /** */
+    int getLo(int k) const { return low[k]; }
+    /** */
+    int getHi(int k) const { return high[k]; }
+    /** */
+    int getDims(int k) const { return dims[k]; }
+
+    std::ptrdiff_t getSize() const;
+
+    /** Set the value of elements in tiles that have not been allocated
+     *
+     *  Newly allocated tiles are initialised with this value. Tiles that
+     *  have already been allocated are not changed.
+     */
+    void setFillValue(const T &value)
+    {
+      fillValue = value;
+      std::fill(fillRow.begin(), fillRow.end(), value);
+    }
+    /** */
+    const T &getFillValue() const { return fillValue; }
+
+    /** The number of tiles, including the tiles along the outer dimensions */
+    std::ptrdiff_t getTileCount() const { return tileData.size(); }
+
+    /** The number of tiles that have been allocated */
+    std::ptrdiff_t getAllocatedTileCount() const { return allocatedTiles; }
+
+    /** Returns true if tile number tile has been allocated */
+    bool isTileAllocated(std::ptrdiff_t tile) const { return tileData[tile] != NULL; }
+
+    /** The part of the grid covered by tile number tile */
+    RangeType getTileRange(std::ptrdiff_t tile) const;
+
+    /** A pointer to the first element of a tile, or NULL if it has not been allocated
+     *
+     *  Inside a tile, the element with the local index (a,b,c) relative to
+     *  the lower corner of the tile range is found at offset
+     *  (a*tileEdge + b)*tileEdge + c.
+     */
+    T* getTileData(std::ptrdiff_t tile) const { return tileData[tile]; }
+
+    /** A pointer to the first element of a tile, allocating the tile if necessary */
+    T* allocateTile(std::ptrdiff_t tile);
+
+    /** Release a tile, its elements will read as the fill value */
+    void releaseTile(std::ptrdiff_t tile);
+
+    /** Release all tiles in which every element is equal to the fill value */
+    void releaseUniformTiles();
+
+    /** Release all tiles */
+    void clear();
+
+    storage_iterator begin() { return storage_iterator(this, 0); }
+    storage_iterator end() { return storage_iterator(this, getTileCount()); }
+
+    const_storage_iterator cbegin() const { return const_storage_iterator(this, 0); }
+    const_storage_iterator cend() const { return const_storage_iterator(this, getTileCount()); }
+};
+
 } // namespace schnek
 
 
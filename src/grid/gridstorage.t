@@ -24,10 +24,25 @@
  *
  */
 
+#include "../util/exceptions.hpp"
+
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_pod.hpp>
+
+#include <algorithm>
 #include <cstddef>
+#include <cstdlib>
 #include <cmath>
+#include <cstring>
+#include <fstream>
+#include <new>
 #include <iostream>
+#include <sstream>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <vector>
 
 namespace schnek {
 
@@ -51,6 +66,18 @@ SingleArrayInstantAllocation<T, rank>::~SingleArrayInstantAllocation()
   this->deleteData();
 }
 
+template<typename T, int rank>
+void SingleArrayInstantAllocation<T, rank>::swap(SingleArrayInstantAllocation &other)
+{
+  std::swap(data, other.data);
+  std::swap(data_fast, other.data_fast);
+  std::swap(size, other.size);
+  std::swap(low, other.low);
+  std::swap(high, other.high);
+  std::swap(dims, other.dims);
+  std::swap(strides, other.strides);
+}
+
 template<typename T, int rank>
 void SingleArrayInstantAllocation<T, rank>::deleteData()
 {
@@ -77,7 +104,8 @@ void SingleArrayInstantAllocation<T, rank>::newData(
     size *= dims[d];
   }
   data = new T[size];
-  int p = -low[0];
+  computeCStrides(dims, strides);
+  std::ptrdiff_t p = -low[0];
 
   for (d = 1; d < rank ; ++d) {
     p = p*dims[d] - low[d];
@@ -107,6 +135,18 @@ SingleArrayInstantFortranAllocation<T, rank>::~SingleArrayInstantFortranAllocati
   this->deleteData();
 }
 
+template<typename T, int rank>
+void SingleArrayInstantFortranAllocation<T, rank>::swap(SingleArrayInstantFortranAllocation &other)
+{
+  std::swap(data, other.data);
+  std::swap(data_fast, other.data_fast);
+  std::swap(size, other.size);
+  std::swap(low, other.low);
+  std::swap(high, other.high);
+  std::swap(dims, other.dims);
+  std::swap(strides, other.strides);
+}
+
 template<typename T, int rank>
 void SingleArrayInstantFortranAllocation<T, rank>::deleteData()
 {
@@ -133,7 +173,8 @@ void SingleArrayInstantFortranAllocation<T, rank>::newData(
     size *= dims[d];
   }
   data = new T[size];
-  int p = -low[rank-1];
+  computeFortranStrides(dims, strides);
+  std::ptrdiff_t p = -low[rank-1];
 
   for (d = rank-2; d >= 0 ; --d) {
     p = p*dims[d] -low[d];
@@ -156,11 +197,26 @@ SingleArrayLazyAllocation<T, rank>::~SingleArrayLazyAllocation()
   this->deleteData();
 }
 
+template<typename T, int rank>
+void SingleArrayLazyAllocation<T, rank>::swap(SingleArrayLazyAllocation &other)
+{
+  std::swap(data, other.data);
+  std::swap(data_fast, other.data_fast);
+  std::swap(size, other.size);
+  std::swap(low, other.low);
+  std::swap(high, other.high);
+  std::swap(dims, other.dims);
+  std::swap(strides, other.strides);
+  std::swap(bufSize, other.bufSize);
+  std::swap(avgSize, other.avgSize);
+  std::swap(avgVar, other.avgVar);
+  std::swap(r, other.r);
+}
+
 template<typename T, int rank>
 void SingleArrayLazyAllocation<T, rank>::resize(const IndexType &low_, const IndexType &high_)
 {
-  int oldSize = size;
-  int newSize;
+  std::ptrdiff_t newSize;
   newSize = 1;
   int d;
 
@@ -173,7 +229,7 @@ void SingleArrayLazyAllocation<T, rank>::resize(const IndexType &low_, const Ind
   }
 
   avgSize = r*newSize + (1-r)*avgSize;
-  int diff = newSize - avgSize;
+  double diff = newSize - avgSize;
   avgVar = r*diff*diff + (1-r)*avgVar;
 
   if ((newSize > bufSize) || (((newSize + 32.0*sqrt(avgVar)) < bufSize) && (bufSize>100)))
@@ -183,10 +239,11 @@ void SingleArrayLazyAllocation<T, rank>::resize(const IndexType &low_, const Ind
   }
   size = newSize;
 
-  int p = -low[rank-1];
+  computeCStrides(dims, strides);
+  std::ptrdiff_t p = -low[0];
 
-  for (d = rank-2; d >= 0 ; d--) {
-    p = p*dims[d] -low[d];
+  for (d = 1; d < rank ; ++d) {
+    p = p*dims[d] - low[d];
   }
   data_fast = data + p;
 }
@@ -204,87 +261,1411 @@ void SingleArrayLazyAllocation<T, rank>::deleteData()
 
 template<typename T, int rank>
 void SingleArrayLazyAllocation<T, rank>::newData(
-  int newSize
+  std::ptrdiff_t newSize
 )
 {
-  bufSize = newSize + (int)(4*sqrt(avgVar));
+  bufSize = newSize + (std::ptrdiff_t)(4*sqrt(avgVar));
   if (bufSize<=0) bufSize=10;
   //std::cerr << "Allocating pointer: size = " << newSize  << " " << bufSize << std::endl;
   data = new T[bufSize];
 }
 
 //=================================================================
-//================== SingleArrayGridStorageBase ===================
+//=============== SingleArrayExternalAllocation ===================
 //=================================================================
 
-template<typename T, int rank, template<typename, int> class AllocationPolicy>
-SingleArrayGridStorageBase<T, rank, AllocationPolicy>::SingleArrayGridStorageBase()
-  : AllocationPolicy<T, rank>()
-{}
+template<typename T, int rank>
+void SingleArrayExternalAllocation<T, rank>::resize(const IndexType &low_, const IndexType &high_)
+{
+  this->setBounds(low_, high_);
+  SCHNEK_ASSERT((data == NULL) || (size <= capacity),
+      "Grid of size " << size << " does not fit into an external array of size " << capacity);
+}
 
+template<typename T, int rank>
+void SingleArrayExternalAllocation<T, rank>::swap(SingleArrayExternalAllocation &other)
+{
+  std::swap(data, other.data);
+  std::swap(data_fast, other.data_fast);
+  std::swap(size, other.size);
+  std::swap(low, other.low);
+  std::swap(high, other.high);
+  std::swap(dims, other.dims);
+  std::swap(strides, other.strides);
+  std::swap(capacity, other.capacity);
+}
 
-template<typename T, int rank, template<typename, int> class AllocationPolicy>
-SingleArrayGridStorageBase<T, rank, AllocationPolicy>::SingleArrayGridStorageBase(
-    const IndexType &low_,
-    const IndexType &high_
-  )
-  : AllocationPolicy<T, rank>()
+template<typename T, int rank>
+void SingleArrayExternalAllocation<T, rank>::adopt(T *data_, const IndexType &low_, const IndexType &high_)
 {
-  this->resize(low_, high_);
+  data = data_;
+  this->setBounds(low_, high_);
+  capacity = size;
+}
+
+template<typename T, int rank>
+void SingleArrayExternalAllocation<T, rank>::adopt(T *data_)
+{
+  data = data_;
+  this->setBounds(low, high);
+  capacity = size;
+}
+
+template<typename T, int rank>
+void SingleArrayExternalAllocation<T, rank>::release()
+{
+  data = NULL;
+  data_fast = NULL;
+  capacity = 0;
+}
+
+template<typename T, int rank>
+void SingleArrayExternalAllocation<T, rank>::setBounds(
+  const IndexType &low_,
+  const IndexType &high_
+)
+{
+  size = 1;
+  int d;
+
+  low = low_;
+  high = high_;
+
+  for (d = 0; d < rank; ++d) {
+    dims[d] = high[d] - low[d] + 1;
+    size *= dims[d];
+  }
+  computeCStrides(dims, strides);
+  std::ptrdiff_t p = -low[0];
+
+  for (d = 1; d < rank ; ++d) {
+    p = p*dims[d] - low[d];
+  }
+  data_fast = (data != NULL) ? data + p : NULL;
 }
 
 //=================================================================
-//=============== SingleArrayGridCOrderStorageBase ================
+//============ SingleArrayExternalFortranAllocation ===============
 //=================================================================
 
-template<typename T, int rank, template<typename, int> class AllocationPolicy>
-inline T& SingleArrayGridCOrderStorageBase<T, rank, AllocationPolicy>::get(const IndexType &index)
+template<typename T, int rank>
+void SingleArrayExternalFortranAllocation<T, rank>::resize(const IndexType &low_, const IndexType &high_)
+{
+  this->setBounds(low_, high_);
+  SCHNEK_ASSERT((data == NULL) || (size <= capacity),
+      "Grid of size " << size << " does not fit into an external array of size " << capacity);
+}
+
+template<typename T, int rank>
+void SingleArrayExternalFortranAllocation<T, rank>::swap(SingleArrayExternalFortranAllocation &other)
+{
+  std::swap(data, other.data);
+  std::swap(data_fast, other.data_fast);
+  std::swap(size, other.size);
+  std::swap(low, other.low);
+  std::swap(high, other.high);
+  std::swap(dims, other.dims);
+  std::swap(strides, other.strides);
+  std::swap(capacity, other.capacity);
+}
+
+template<typename T, int rank>
+void SingleArrayExternalFortranAllocation<T, rank>::adopt(T *data_, const IndexType &low_, const IndexType &high_)
+{
+  data = data_;
+  this->setBounds(low_, high_);
+  capacity = size;
+}
+
+template<typename T, int rank>
+void SingleArrayExternalFortranAllocation<T, rank>::adopt(T *data_)
+{
+  data = data_;
+  this->setBounds(low, high);
+  capacity = size;
+}
+
+template<typename T, int rank>
+void SingleArrayExternalFortranAllocation<T, rank>::release()
+{
+  data = NULL;
+  data_fast = NULL;
+  capacity = 0;
+}
+
+template<typename T, int rank>
+void SingleArrayExternalFortranAllocation<T, rank>::setBounds(
+  const IndexType &low_,
+  const IndexType &high_
+)
+{
+  size = 1;
+  int d;
+
+  low = low_;
+  high = high_;
+
+  for (d = 0; d < rank; ++d) {
+    dims[d] = high[d] - low[d] + 1;
+    size *= dims[d];
+  }
+  computeFortranStrides(dims, strides);
+  std::ptrdiff_t p = -low[rank-1];
+
+  for (d = rank-2; d >= 0 ; --d) {
+    p = p*dims[d] -low[d];
+  }
+  data_fast = (data != NULL) ? data + p : NULL;
+}
+
+//=================================================================
+//=============== SingleArrayPooledAllocation =====================
+//=================================================================
+
+template<typename T, int rank>
+SingleArrayPooledAllocation<T, rank>::SingleArrayPooledAllocation()
+  : data(NULL) , data_fast(NULL), size(0), bufSize(0), blockSize(0),
+    avgSize(0.0), avgVar(0.0), r(0.05)
+{}
+
+template<typename T, int rank>
+SingleArrayPooledAllocation<T, rank>::~SingleArrayPooledAllocation()
+{
+  this->deleteData();
+}
+
+template<typename T, int rank>
+void SingleArrayPooledAllocation<T, rank>::swap(SingleArrayPooledAllocation &other)
+{
+  std::swap(data, other.data);
+  std::swap(data_fast, other.data_fast);
+  std::swap(size, other.size);
+  std::swap(low, other.low);
+  std::swap(high, other.high);
+  std::swap(dims, other.dims);
+  std::swap(strides, other.strides);
+  std::swap(bufSize, other.bufSize);
+  std::swap(blockSize, other.blockSize);
+  std::swap(avgSize, other.avgSize);
+  std::swap(avgVar, other.avgVar);
+  std::swap(r, other.r);
+}
+
+template<typename T, int rank>
+void SingleArrayPooledAllocation<T, rank>::resize(const IndexType &low_, const IndexType &high_)
 {
-  int pos = index[0];
-  for (int i=1; i<rank; ++i)
+  std::ptrdiff_t newSize;
+  newSize = 1;
+  int d;
+
+  low = low_;
+  high = high_;
+
+  for (d = 0; d < rank; d++) {
+    dims[d] = high[d] - low[d] + 1;
+    newSize *= dims[d];
+  }
+
+  avgSize = r*newSize + (1-r)*avgSize;
+  double diff = newSize - avgSize;
+  avgVar = r*diff*diff + (1-r)*avgVar;
+
+  if ((newSize > bufSize) || (((newSize + 32.0*sqrt(avgVar)) < bufSize) && (bufSize>100)))
   {
-    pos = index[i] + this->dims[i]*pos;
+    this->deleteData();
+    this->newData(newSize);
   }
-  return this->data_fast[pos];
+  size = newSize;
+
+  computeCStrides(dims, strides);
+  std::ptrdiff_t p = -low[0];
+
+  for (d = 1; d < rank ; ++d) {
+    p = p*dims[d] - low[d];
+  }
+  data_fast = data + p;
 }
 
-template<typename T, int rank, template<typename, int> class AllocationPolicy>
-inline const T& SingleArrayGridCOrderStorageBase<T, rank, AllocationPolicy>::get(const IndexType &index) const
+template<typename T, int rank>
+void SingleArrayPooledAllocation<T, rank>::deleteData()
 {
-  int pos = index[0];
-  for (int i=1; i<rank; ++i)
+  if (data)
   {
-    pos = index[i] + this->dims[i]*pos;
+    for (std::ptrdiff_t i=0; i<bufSize; ++i) data[i].~T();
+    MemoryPool::instance().release(data, blockSize);
   }
-  return this->data_fast[pos];
+  data = NULL;
+  size = 0;
+  bufSize = 0;
+  blockSize = 0;
 }
 
+template<typename T, int rank>
+void SingleArrayPooledAllocation<T, rank>::newData(
+  std::ptrdiff_t newSize
+)
+{
+  std::ptrdiff_t minSize = newSize + (std::ptrdiff_t)(4*sqrt(avgVar));
+  if (minSize<=0) minSize=10;
+  data = static_cast<T*>(MemoryPool::instance().allocate(minSize*sizeof(T), blockSize));
+  bufSize = blockSize/sizeof(T);
+  for (std::ptrdiff_t i=0; i<bufSize; ++i) new (data + i) T;
+}
 
 //=================================================================
-//============ SingleArrayGridFortranOrderStorageBase =============
+//============== SingleArrayFirstTouchAllocation ==================
 //=================================================================
 
-template<typename T, int rank, template<typename, int> class AllocationPolicy>
-inline T& SingleArrayGridFortranOrderStorageBase<T, rank, AllocationPolicy>::get(const IndexType &index)
+template<typename T, int rank>
+void SingleArrayFirstTouchAllocation<T, rank>::resize(const IndexType &low_, const IndexType &high_)
+{
+  this->deleteData();
+  this->newData(low_,high_);
+}
+
+template<typename T, int rank>
+SingleArrayFirstTouchAllocation<T, rank>::~SingleArrayFirstTouchAllocation()
+{
+  this->deleteData();
+}
+
+template<typename T, int rank>
+void SingleArrayFirstTouchAllocation<T, rank>::swap(SingleArrayFirstTouchAllocation &other)
+{
+  std::swap(data, other.data);
+  std::swap(data_fast, other.data_fast);
+  std::swap(size, other.size);
+  std::swap(low, other.low);
+  std::swap(high, other.high);
+  std::swap(dims, other.dims);
+  std::swap(strides, other.strides);
+  std::swap(numThreads, other.numThreads);
+}
+
+template<typename T, int rank>
+void SingleArrayFirstTouchAllocation<T, rank>::TouchJob::execute(int thread, int threadCount)
 {
-  int pos = index[rank-1];
-  for (int i=rank-2; i>=0; --i)
+  for (int t=thread; t<partition.getCount(); t+=threadCount)
   {
-    pos = index[i] + this->dims[i]*pos;
+    T* end = data + (partition.getHi(t) - partition.getLo(0) + 1)*stride;
+    for (T* p = data + (partition.getLo(t) - partition.getLo(0))*stride; p != end; ++p) new (p) T();
   }
-  return this->data_fast[pos];
 }
 
+template<typename T, int rank>
+void SingleArrayFirstTouchAllocation<T, rank>::deleteData()
+{
+  if (data)
+  {
+    for (std::ptrdiff_t i=0; i<size; ++i) data[i].~T();
+    ::operator delete(data);
+  }
+  data = NULL;
+  size = 0;
+}
 
-template<typename T, int rank, template<typename, int> class AllocationPolicy>
-inline const T& SingleArrayGridFortranOrderStorageBase<T, rank, AllocationPolicy>::get(const IndexType &index) const
+template<typename T, int rank>
+void SingleArrayFirstTouchAllocation<T, rank>::newData(
+  const IndexType &low_,
+  const IndexType &high_
+)
+{
+  size = 1;
+  int d;
+
+  low = low_;
+  high = high_;
+
+  for (d = 0; d < rank; ++d) {
+    dims[d] = high[d] - low[d] + 1;
+    size *= dims[d];
+  }
+
+  if (size <= 0)
+  {
+    size = 0;
+    data_fast = NULL;
+    computeCStrides(dims, strides);
+    return;
+  }
+
+  // the pages are not touched by the allocation
+  data = static_cast<T*>(::operator new(size*sizeof(T)));
+
+  TouchJob job(data, size/dims[0], this->getPartition());
+  ThreadPool::instance().run(job);
+
+  computeCStrides(dims, strides);
+  std::ptrdiff_t p = -low[0];
+
+  for (d = 1; d < rank ; ++d) {
+    p = p*dims[d] - low[d];
+  }
+  data_fast = data + p;
+}
+
+//=================================================================
+//=============== SingleArrayHugePageAllocation ===================
+//=================================================================
+
+/** Returns true if the kernel backs madvise(MADV_HUGEPAGE) regions with transparent huge pages
+ *
+ *  The active mode is the one in brackets in
+ *  /sys/kernel/mm/transparent_hugepage/enabled, for example
+ *  "always [madvise] never".
+ */
+inline bool transparentHugePagesEnabled()
 {
-  int pos = index[rank-1];
-  for (int i=rank-2; i>=0; --i)
+  std::ifstream in("/sys/kernel/mm/transparent_hugepage/enabled");
+  std::string modes;
+  if (!std::getline(in, modes)) return false;
+  return (modes.find("[always]") != std::string::npos)
+      || (modes.find("[madvise]") != std::string::npos);
+}
+
+template<typename T, int rank>
+void SingleArrayHugePageAllocation<T, rank>::resize(const IndexType &low_, const IndexType &high_)
+{
+  this->deleteData();
+  this->newData(low_,high_);
+}
+
+template<typename T, int rank>
+SingleArrayHugePageAllocation<T, rank>::~SingleArrayHugePageAllocation()
+{
+  this->deleteData();
+}
+
+template<typename T, int rank>
+void SingleArrayHugePageAllocation<T, rank>::swap(SingleArrayHugePageAllocation &other)
+{
+  std::swap(data, other.data);
+  std::swap(data_fast, other.data_fast);
+  std::swap(size, other.size);
+  std::swap(low, other.low);
+  std::swap(high, other.high);
+  std::swap(dims, other.dims);
+  std::swap(strides, other.strides);
+  std::swap(mapSize, other.mapSize);
+  std::swap(pageSize, other.pageSize);
+}
+
+template<typename T, int rank>
+void SingleArrayHugePageAllocation<T, rank>::deleteData()
+{
+  if (data)
   {
-    pos = index[i] + this->dims[i]*pos;
+    for (std::ptrdiff_t i=0; i<size; ++i) data[i].~T();
+    munmap(data, mapSize);
   }
-  return this->data_fast[pos];
+  data = NULL;
+  size = 0;
+  mapSize = 0;
+  pageSize = 0;
+}
+
+template<typename T, int rank>
+void SingleArrayHugePageAllocation<T, rank>::newData(
+  const IndexType &low_,
+  const IndexType &high_
+)
+{
+  size = 1;
+  int d;
+
+  low = low_;
+  high = high_;
+
+  for (d = 0; d < rank; ++d) {
+    dims[d] = high[d] - low[d] + 1;
+    size *= dims[d];
+  }
+
+  mapSize = hugePageSize*((size*sizeof(T) + hugePageSize - 1)/hugePageSize);
+  void *mem = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+  int hugeFlags = MAP_HUGETLB;
+  // request 2MB pages explicitly, the default huge page size may be larger
+#if defined(MAP_HUGE_2MB)
+  hugeFlags |= MAP_HUGE_2MB;
+#elif defined(MAP_HUGE_SHIFT)
+  hugeFlags |= (21 << MAP_HUGE_SHIFT);
+#endif
+  mem = mmap(NULL, mapSize, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | hugeFlags, -1, 0);
+  if (mem != MAP_FAILED) pageSize = hugePageSize;
+#endif
+
+  if (mem == MAP_FAILED)
+  {
+    // over-allocate by one huge page and trim the mapping to an aligned region
+    std::size_t extSize = mapSize + hugePageSize;
+    char *ext = static_cast<char*>(mmap(NULL, extSize, PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (ext == MAP_FAILED) throw std::bad_alloc();
+
+    std::size_t head = (hugePageSize - reinterpret_cast<std::size_t>(ext) % hugePageSize) % hugePageSize;
+    if (head > 0) munmap(ext, head);
+    if (hugePageSize > head) munmap(ext + head + mapSize, hugePageSize - head);
+    mem = ext + head;
+
+    pageSize = sysconf(_SC_PAGESIZE);
+#ifdef MADV_HUGEPAGE
+    // madvise also succeeds when transparent huge pages are disabled
+    if ((madvise(mem, mapSize, MADV_HUGEPAGE) == 0) && transparentHugePagesEnabled())
+      pageSize = hugePageSize;
+#endif
+  }
+
+  data = static_cast<T*>(mem);
+  for (std::ptrdiff_t i=0; i<size; ++i) new (data + i) T();
+
+  computeCStrides(dims, strides);
+  std::ptrdiff_t p = -low[0];
+
+  for (d = 1; d < rank ; ++d) {
+    p = p*dims[d] - low[d];
+  }
+  data_fast = data + p;
+}
+
+//=================================================================
+//================ SingleArrayMappedAllocation ====================
+//=================================================================
+
+template<typename T, int rank>
+SingleArrayMappedAllocation<T, rank>::SingleArrayMappedAllocation()
+  : data(NULL) , data_fast(NULL), size(0), fd(-1), mapBase(NULL), mapSize(0)
+{
+  BOOST_STATIC_ASSERT(boost::is_pod<T>::value);
+}
+
+template<typename T, int rank>
+SingleArrayMappedAllocation<T, rank>::~SingleArrayMappedAllocation()
+{
+  this->unmap();
+}
+
+template<typename T, int rank>
+void SingleArrayMappedAllocation<T, rank>::swap(SingleArrayMappedAllocation &other)
+{
+  std::swap(data, other.data);
+  std::swap(data_fast, other.data_fast);
+  std::swap(size, other.size);
+  std::swap(low, other.low);
+  std::swap(high, other.high);
+  std::swap(dims, other.dims);
+  std::swap(strides, other.strides);
+  std::swap(fileName, other.fileName);
+  std::swap(fd, other.fd);
+  std::swap(mapBase, other.mapBase);
+  std::swap(mapSize, other.mapSize);
+}
+
+template<typename T, int rank>
+void SingleArrayMappedAllocation<T, rank>::resize(const IndexType &low_, const IndexType &high_)
+{
+  if (fd >= 0)
+  {
+    std::string name = fileName;
+    this->mapFile(name, low_, high_);
+    return;
+  }
+
+  this->unmap();
+  this->setBounds(low_, high_);
+  this->mapRegion(0);
+}
+
+template<typename T, int rank>
+void SingleArrayMappedAllocation<T, rank>::mapFile(
+  const std::string &fileName_,
+  const IndexType &low_,
+  const IndexType &high_
+)
+{
+  this->unmap();
+  this->setBounds(low_, high_);
+
+  std::size_t dataOffset = sysconf(_SC_PAGESIZE);
+  if (dataOffset < sizeof(FileHeader)) dataOffset = sizeof(FileHeader);
+
+  int newFd = open(fileName_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  SCHNEK_ASSERT(newFd >= 0, "Could not create grid file " << fileName_);
+
+  if (ftruncate(newFd, dataOffset + size*sizeof(T)) != 0)
+  {
+    close(newFd);
+    SCHNECK_FAIL("Could not set the size of grid file " << fileName_);
+  }
+
+  fd = newFd;
+  fileName = fileName_;
+  this->mapRegion(dataOffset);
+
+  FileHeader *header = reinterpret_cast<FileHeader*>(mapBase);
+  memcpy(header->magic, "SCHNEKGR", 8);
+  header->gridRank = rank;
+  header->elementSize = sizeof(T);
+  header->dataOffset = dataOffset;
+  for (int d=0; d<rank; ++d)
+  {
+    header->low[d] = low[d];
+    header->high[d] = high[d];
+  }
+}
+
+template<typename T, int rank>
+void SingleArrayMappedAllocation<T, rank>::mapFile(const std::string &fileName_)
+{
+  this->unmap();
+
+  int newFd = open(fileName_.c_str(), O_RDWR);
+  SCHNEK_ASSERT(newFd >= 0, "Could not open grid file " << fileName_);
+
+  FileHeader header;
+  if ( (pread(newFd, &header, sizeof(FileHeader), 0) != (ssize_t)sizeof(FileHeader))
+       || (memcmp(header.magic, "SCHNEKGR", 8) != 0)
+       || (header.gridRank != rank)
+       || (header.elementSize != (boost::int32_t)sizeof(T)) )
+  {
+    close(newFd);
+    SCHNECK_FAIL("File " << fileName_ << " is not a grid file of rank " << rank
+        << " and element size " << sizeof(T));
+  }
+
+  IndexType low_, high_;
+  for (int d=0; d<rank; ++d)
+  {
+    low_[d] = header.low[d];
+    high_[d] = header.high[d];
+  }
+  this->setBounds(low_, high_);
+
+  struct stat fileStat;
+  if ( (fstat(newFd, &fileStat) != 0)
+       || ((std::size_t)fileStat.st_size < header.dataOffset + size*sizeof(T)) )
+  {
+    close(newFd);
+    size = 0;
+    SCHNECK_FAIL("Grid file " << fileName_ << " is truncated");
+  }
+
+  fd = newFd;
+  fileName = fileName_;
+  this->mapRegion(header.dataOffset);
+}
+
+template<typename T, int rank>
+void SingleArrayMappedAllocation<T, rank>::sync()
+{
+  if (mapBase && (fd >= 0))
+    msync(mapBase, mapSize, MS_SYNC);
+}
+
+template<typename T, int rank>
+void SingleArrayMappedAllocation<T, rank>::unmap()
+{
+  if (mapBase)
+    munmap(mapBase, mapSize);
+  if (fd >= 0)
+    close(fd);
+
+  fd = -1;
+  fileName.clear();
+  mapBase = NULL;
+  mapSize = 0;
+  data = NULL;
+  data_fast = NULL;
+  size = 0;
+}
+
+template<typename T, int rank>
+void SingleArrayMappedAllocation<T, rank>::setBounds(const IndexType &low_, const IndexType &high_)
+{
+  size = 1;
+
+  low = low_;
+  high = high_;
+
+  for (int d = 0; d < rank; ++d) {
+    dims[d] = high[d] - low[d] + 1;
+    size *= dims[d];
+  }
+}
+
+template<typename T, int rank>
+void SingleArrayMappedAllocation<T, rank>::mapRegion(std::size_t dataOffset)
+{
+  mapSize = dataOffset + size*sizeof(T);
+
+  void *mem;
+  if (fd >= 0)
+    mem = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  else
+    mem = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (mem == MAP_FAILED)
+  {
+    std::string name = fileName;
+    mapBase = NULL;
+    this->unmap();
+    SCHNECK_FAIL("Could not map grid data " << name);
+  }
+
+  mapBase = static_cast<char*>(mem);
+  data = reinterpret_cast<T*>(mapBase + dataOffset);
+
+  computeCStrides(dims, strides);
+  std::ptrdiff_t p = -low[0];
+
+  for (int d = 1; d < rank ; ++d) {
+    p = p*dims[d] - low[d];
+  }
+  data_fast = data + p;
+}
+
+//=================================================================
+//================= SingleArrayTiledAllocation ====================
+//=================================================================
+
+template<typename T, int rank>
+void SingleArrayTiledAllocation<T, rank>::resize(const IndexType &low_, const IndexType &high_)
+{
+  this->deleteData();
+  this->newData(low_,high_);
+}
+
+template<typename T, int rank>
+SingleArrayTiledAllocation<T, rank>::~SingleArrayTiledAllocation()
+{
+  this->deleteData();
+}
+
+template<typename T, int rank>
+void SingleArrayTiledAllocation<T, rank>::swap(SingleArrayTiledAllocation &other)
+{
+  std::swap(data, other.data);
+  std::swap(data_fast, other.data_fast);
+  std::swap(size, other.size);
+  std::swap(low, other.low);
+  std::swap(high, other.high);
+  std::swap(dims, other.dims);
+  std::swap(bricks, other.bricks);
+  std::swap(bufSize, other.bufSize);
+}
+
+template<typename T, int rank>
+void SingleArrayTiledAllocation<T, rank>::deleteData()
+{
+  if (data)
+    delete[] data;
+  data = NULL;
+  size = 0;
+  bufSize = 0;
+}
+
+template<typename T, int rank>
+void SingleArrayTiledAllocation<T, rank>::newData(
+  const IndexType &low_,
+  const IndexType &high_
+)
+{
+  size = 1;
+  bufSize = brickSize;
+
+  low = low_;
+  high = high_;
+
+  for (int d = 0; d < rank; ++d) {
+    dims[d] = high[d] - low[d] + 1;
+    size *= dims[d];
+    if (d < rank - tiledRank)
+      bricks[d] = dims[d];
+    else
+      bricks[d] = (dims[d] + brickEdge - 1) >> brickBits;
+    bufSize *= bricks[d];
+  }
+
+  data = new T[bufSize];
+  data_fast = data;
+}
+
+//=================================================================
+//=============== SingleArrayAlignedAllocation ====================
+//=================================================================
+
+template<typename T, int rank>
+void SingleArrayAlignedAllocation<T, rank>::resize(const IndexType &low_, const IndexType &high_)
+{
+  this->deleteData();
+  this->newData(low_,high_);
+}
+
+template<typename T, int rank>
+SingleArrayAlignedAllocation<T, rank>::~SingleArrayAlignedAllocation()
+{
+  this->deleteData();
+}
+
+template<typename T, int rank>
+void SingleArrayAlignedAllocation<T, rank>::swap(SingleArrayAlignedAllocation &other)
+{
+  std::swap(data, other.data);
+  std::swap(data_fast, other.data_fast);
+  std::swap(size, other.size);
+  std::swap(low, other.low);
+  std::swap(high, other.high);
+  std::swap(dims, other.dims);
+  std::swap(strides, other.strides);
+  std::swap(rowLength, other.rowLength);
+  std::swap(bufSize, other.bufSize);
+}
+
+template<typename T, int rank>
+void SingleArrayAlignedAllocation<T, rank>::deleteData()
+{
+  if (data)
+  {
+    for (std::ptrdiff_t i=0; i<bufSize; ++i) data[i].~T();
+    free(data);
+  }
+  data = NULL;
+  size = 0;
+  bufSize = 0;
+}
+
+template<typename T, int rank>
+void SingleArrayAlignedAllocation<T, rank>::newData(
+  const IndexType &low_,
+  const IndexType &high_
+)
+{
+  size = 1;
+  int d;
+
+  low = low_;
+  high = high_;
+
+  for (d = 0; d < rank; ++d) {
+    dims[d] = high[d] - low[d] + 1;
+    size *= dims[d];
+  }
+
+  // the number of elements that make up a whole number of cache lines
+  std::size_t a = alignment, b = sizeof(T);
+  while (b != 0) { std::size_t t = a % b; a = b; b = t; }
+  int unit = alignment / a;
+
+  rowLength = unit*((dims[rank-1] + unit - 1)/unit);
+
+  // the strides of the padded array
+  strides[rank-1] = 1;
+  if (rank > 1) strides[rank-2] = rowLength;
+  for (d = rank-3; d >= 0; --d)
+    strides[d] = strides[d+1]*dims[d+1];
+
+  if (size <= 0)
+  {
+    size = 0;
+    rowLength = 0;
+    bufSize = 0;
+    data_fast = NULL;
+    return;
+  }
+
+  bufSize = (size/dims[rank-1])*rowLength;
+
+  void *mem = NULL;
+  if (posix_memalign(&mem, alignment, bufSize*sizeof(T)) != 0)
+    throw std::bad_alloc();
+
+  data = static_cast<T*>(mem);
+  for (std::ptrdiff_t i=0; i<bufSize; ++i) new (data + i) T;
+
+  std::ptrdiff_t p = 0;
+  for (d = 0; d < rank; ++d) p -= low[d]*strides[d];
+
+  data_fast = data + p;
+}
+
+//=================================================================
+//========================= Stride Helpers ========================
+//=================================================================
+
+template<int rank>
+void computeCStrides(const Array<int,rank> &dims, Array<std::ptrdiff_t,rank> &strides)
+{
+  strides[rank-1] = 1;
+  for (int d=rank-2; d>=0; --d)
+    strides[d] = strides[d+1]*dims[d+1];
+}
+
+template<int rank>
+void computeFortranStrides(const Array<int,rank> &dims, Array<std::ptrdiff_t,rank> &strides)
+{
+  strides[0] = 1;
+  for (int d=1; d<rank; ++d)
+    strides[d] = strides[d-1]*dims[d-1];
+}
+
+//=================================================================
+//======================== Shift Helpers ==========================
+//=================================================================
+
+template<typename T, int rank>
+void shiftStridedData(T *data,
+                      const Array<int,rank> &dims,
+                      const Array<std::ptrdiff_t,rank> &strides,
+                      int rowDim,
+                      int dim,
+                      int distance)
+{
+  if (distance == 0) return;
+
+  int n = dims[dim];
+  int rowLength = dims[rowDim];
+
+  // loop over all dimensions except rowDim and dim
+  Array<int,rank> pos;
+  for (int d=0; d<rank; ++d) pos[d] = 0;
+
+  bool done = false;
+  while (!done)
+  {
+    std::ptrdiff_t offset = 0;
+    for (int d=0; d<rank; ++d) offset += pos[d]*strides[d];
+
+    if (dim == rowDim)
+    {
+      T *row = data + offset;
+      if (distance > 0)
+      {
+        if (distance < n) std::copy(row + distance, row + n, row);
+        std::fill(row + std::max(n - distance, 0), row + n, T());
+      }
+      else
+      {
+        if (-distance < n) std::copy_backward(row, row + n + distance, row + n);
+        std::fill(row, row + std::min(-distance, n), T());
+      }
+    }
+    else
+    {
+      // process the rows so that no source is overwritten before it is read
+      int start = (distance > 0) ? 0 : n-1;
+      int step = (distance > 0) ? 1 : -1;
+      for (int r=start; (r>=0) && (r<n); r+=step)
+      {
+        T *dest = data + offset + r*strides[dim];
+        int src = r + distance;
+        if ((src >= 0) && (src < n))
+        {
+          T *source = data + offset + src*strides[dim];
+          std::copy(source, source + rowLength, dest);
+        }
+        else
+          std::fill(dest, dest + rowLength, T());
+      }
+    }
+
+    done = true;
+    for (int d=rank-1; d>=0; --d)
+    {
+      if ((d == rowDim) || (d == dim)) continue;
+      if (++pos[d] < dims[d])
+      {
+        done = false;
+        break;
+      }
+      pos[d] = 0;
+    }
+  }
+}
+
+template<typename T, class StorageType>
+void shiftStorageElements(StorageType &storage, int dim, int distance)
+{
+  typedef typename StorageType::IndexType IndexType;
+  if (distance == 0) return;
+
+  IndexType lo = storage.getLo();
+  IndexType hi = storage.getHi();
+
+  // walk forward for positive distances and backward for negative ones,
+  // so that no source is overwritten before it is read
+  IndexType pos = (distance > 0) ? lo : hi;
+  bool done = false;
+  while (!done)
+  {
+    IndexType src(pos);
+    src[dim] += distance;
+    if ((src[dim] >= lo[dim]) && (src[dim] <= hi[dim]))
+      storage.get(pos) = storage.get(src);
+    else
+      storage.get(pos) = T();
+
+    done = true;
+    for (int d=IndexType::Length-1; d>=0; --d)
+    {
+      if (distance > 0)
+      {
+        if (++pos[d] <= hi[d]) { done = false; break; }
+        pos[d] = lo[d];
+      }
+      else
+      {
+        if (--pos[d] >= lo[d]) { done = false; break; }
+        pos[d] = hi[d];
+      }
+    }
+  }
+}
+
+//=================================================================
+//================== SingleArrayGridStorageBase ===================
+//=================================================================
+
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+SingleArrayGridStorageBase<T, rank, AllocationPolicy>::SingleArrayGridStorageBase()
+  : AllocationPolicy<T, rank>()
+{}
+
+
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+SingleArrayGridStorageBase<T, rank, AllocationPolicy>::SingleArrayGridStorageBase(
+    const IndexType &low_,
+    const IndexType &high_
+  )
+  : AllocationPolicy<T, rank>()
+{
+  this->resize(low_, high_);
+}
+
+//=================================================================
+//=============== SingleArrayGridCOrderStorageBase ================
+//=================================================================
+
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+inline T& SingleArrayGridCOrderStorageBase<T, rank, AllocationPolicy>::get(const IndexType &index)
+{
+  return this->data_fast[StridedOffset<rank, rank-1>::get(index, this->strides)];
+}
+
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+inline const T& SingleArrayGridCOrderStorageBase<T, rank, AllocationPolicy>::get(const IndexType &index) const
+{
+  return this->data_fast[StridedOffset<rank, rank-1>::get(index, this->strides)];
+}
+
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+void SingleArrayGridCOrderStorageBase<T, rank, AllocationPolicy>::shift(int dim, int distance)
+{
+  shiftStridedData(this->data, this->dims, this->strides, rank-1, dim, distance);
+}
+
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+void SingleArrayGridCOrderStorageBase<T, rank, AllocationPolicy>::translate(const IndexType &offset)
+{
+  // the first element stays where it is
+  T* first = &this->get(this->low);
+  for (int d=0; d<rank; ++d)
+  {
+    this->low[d] += offset[d];
+    this->high[d] += offset[d];
+  }
+  this->data_fast += first - &this->get(this->low);
+}
+
+//=================================================================
+//============ SingleArrayGridFortranOrderStorageBase =============
+//=================================================================
+
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+inline T& SingleArrayGridFortranOrderStorageBase<T, rank, AllocationPolicy>::get(const IndexType &index)
+{
+  return this->data_fast[StridedOffset<rank, 0>::get(index, this->strides)];
+}
+
+
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+inline const T& SingleArrayGridFortranOrderStorageBase<T, rank, AllocationPolicy>::get(const IndexType &index) const
+{
+  return this->data_fast[StridedOffset<rank, 0>::get(index, this->strides)];
+}
+
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+void SingleArrayGridFortranOrderStorageBase<T, rank, AllocationPolicy>::shift(int dim, int distance)
+{
+  shiftStridedData(this->data, this->dims, this->strides, 0, dim, distance);
+}
+
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+void SingleArrayGridFortranOrderStorageBase<T, rank, AllocationPolicy>::translate(const IndexType &offset)
+{
+  // the first element stays where it is
+  T* first = &this->get(this->low);
+  for (int d=0; d<rank; ++d)
+  {
+    this->low[d] += offset[d];
+    this->high[d] += offset[d];
+  }
+  this->data_fast += first - &this->get(this->low);
+}
+
+//=================================================================
+//==================== AlignedArrayGridStorage ====================
+//=================================================================
+
+template<typename T, int rank>
+inline T& AlignedArrayGridStorage<T, rank>::get(const IndexType &index)
+{
+  return this->data_fast[StridedOffset<rank, rank-1>::get(index, this->strides)];
+}
+
+template<typename T, int rank>
+inline const T& AlignedArrayGridStorage<T, rank>::get(const IndexType &index) const
+{
+  return this->data_fast[StridedOffset<rank, rank-1>::get(index, this->strides)];
+}
+
+template<typename T, int rank>
+void AlignedArrayGridStorage<T, rank>::shift(int dim, int distance)
+{
+  shiftStridedData(this->data, this->dims, this->strides, rank-1, dim, distance);
+}
+
+template<typename T, int rank>
+void AlignedArrayGridStorage<T, rank>::translate(const IndexType &offset)
+{
+  // the first element stays where it is
+  T* first = &this->get(this->low);
+  for (int d=0; d<rank; ++d)
+  {
+    this->low[d] += offset[d];
+    this->high[d] += offset[d];
+  }
+  this->data_fast += first - &this->get(this->low);
+}
+
+//=================================================================
+//===================== TiledArrayGridStorage =====================
+//=================================================================
+
+template<typename T, int rank>
+inline T& TiledArrayGridStorage<T, rank>::get(const IndexType &index)
+{
+  std::ptrdiff_t brick = 0;
+  std::ptrdiff_t local = 0;
+  for (int d=0; d<rank-tiledRank; ++d)
+  {
+    brick = brick*this->bricks[d] + (index[d] - this->low[d]);
+  }
+  for (int d=rank-tiledRank; d<rank; ++d)
+  {
+    int r = index[d] - this->low[d];
+    brick = brick*this->bricks[d] + (r >> brickBits);
+    local = (local << brickBits) | (r & (brickEdge-1));
+  }
+  return this->data[brick*brickSize + local];
+}
+
+template<typename T, int rank>
+inline const T& TiledArrayGridStorage<T, rank>::get(const IndexType &index) const
+{
+  std::ptrdiff_t brick = 0;
+  std::ptrdiff_t local = 0;
+  for (int d=0; d<rank-tiledRank; ++d)
+  {
+    brick = brick*this->bricks[d] + (index[d] - this->low[d]);
+  }
+  for (int d=rank-tiledRank; d<rank; ++d)
+  {
+    int r = index[d] - this->low[d];
+    brick = brick*this->bricks[d] + (r >> brickBits);
+    local = (local << brickBits) | (r & (brickEdge-1));
+  }
+  return this->data[brick*brickSize + local];
+}
+
+template<typename T, int rank>
+typename TiledArrayGridStorage<T, rank>::RangeType
+  TiledArrayGridStorage<T, rank>::getBrickRange(std::ptrdiff_t brick) const
+{
+  IndexType lo, hi;
+  for (int d=rank-1; d>=0; --d)
+  {
+    int b = brick % this->bricks[d];
+    brick /= this->bricks[d];
+    if (d < rank - tiledRank)
+    {
+      lo[d] = hi[d] = this->low[d] + b;
+    }
+    else
+    {
+      lo[d] = this->low[d] + (b << brickBits);
+      hi[d] = std::min(lo[d] + brickEdge - 1, this->high[d]);
+    }
+  }
+  return RangeType(lo, hi);
+}
+
+template<typename T, int rank>
+void TiledArrayGridStorage<T, rank>::startBrick(Position &pos, std::ptrdiff_t brick) const
+{
+  pos.brick = brick;
+  if (brick >= this->getBrickCount()) return;
+
+  std::ptrdiff_t b = brick;
+  for (int t=tiledRank-1; t>=0; --t)
+  {
+    int d = rank - tiledRank + t;
+    int start = (b % this->bricks[d]) << brickBits;
+    b /= this->bricks[d];
+    pos.local[t] = 0;
+    pos.extent[t] = std::min(int(brickEdge), this->dims[d] - start);
+  }
+}
+
+template<typename T, int rank>
+std::ptrdiff_t TiledArrayGridStorage<T, rank>::advance(Position &pos) const
+{
+  int t = tiledRank - 1;
+  while ((t >= 0) && (++pos.local[t] == pos.extent[t]))
+  {
+    pos.local[t] = 0;
+    --t;
+  }
+
+  if (t < 0)
+  {
+    this->startBrick(pos, pos.brick + 1);
+    return pos.brick*brickSize;
+  }
+
+  std::ptrdiff_t local = 0;
+  for (t=0; t<tiledRank; ++t)
+    local = (local << brickBits) | pos.local[t];
+
+  return pos.brick*brickSize + local;
+}
+
+template<typename T, int rank>
+void TiledArrayGridStorage<T, rank>::shift(int dim, int distance)
+{
+  shiftStorageElements<T>(*this, dim, distance);
+}
+
+template<typename T, int rank>
+void TiledArrayGridStorage<T, rank>::translate(const IndexType &offset)
+{
+  // get() works relative to low, so only the bounds change
+  for (int d=0; d<rank; ++d)
+  {
+    this->low[d] += offset[d];
+    this->high[d] += offset[d];
+  }
+}
+
+//=================================================================
+//==================== SparseTiledGridStorage =====================
+//=================================================================
+
+template<typename T, int rank>
+SparseTiledGridStorage<T, rank>::SparseTiledGridStorage()
+  : low(0), high(-1), dims(0), tiles(0), allocatedTiles(0), fillValue(), fillRow(tileEdge, fillValue)
+{}
+
+template<typename T, int rank>
+SparseTiledGridStorage<T, rank>::SparseTiledGridStorage(const IndexType &low_, const IndexType &high_)
+  : allocatedTiles(0), fillValue(), fillRow(tileEdge, fillValue)
+{
+  resize(low_, high_);
+}
+
+template<typename T, int rank>
+SparseTiledGridStorage<T, rank>::~SparseTiledGridStorage()
+{
+  this->deleteData();
+}
+
+template<typename T, int rank>
+void SparseTiledGridStorage<T, rank>::resize(const IndexType &low_, const IndexType &high_)
+{
+  this->deleteData();
+
+  low = low_;
+  high = high_;
+
+  std::ptrdiff_t tileCount = 1;
+  for (int d = 0; d < rank; ++d) {
+    dims[d] = high[d] - low[d] + 1;
+    if (d < rank - tiledRank)
+      tiles[d] = dims[d];
+    else
+      tiles[d] = (dims[d] + tileEdge - 1) >> tileBits;
+    tileCount *= tiles[d];
+  }
+
+  tileData.assign(tileCount, (T*)NULL);
+}
+
+template<typename T, int rank>
+void SparseTiledGridStorage<T, rank>::swap(SparseTiledGridStorage &other)
+{
+  std::swap(low, other.low);
+  std::swap(high, other.high);
+  std::swap(dims, other.dims);
+  std::swap(tiles, other.tiles);
+  tileData.swap(other.tileData);
+  std::swap(allocatedTiles, other.allocatedTiles);
+  std::swap(fillValue, other.fillValue);
+  fillRow.swap(other.fillRow);
+}
+
+template<typename T, int rank>
+void SparseTiledGridStorage<T, rank>::deleteData()
+{
+  for (std::size_t t=0; t<tileData.size(); ++t)
+    if (tileData[t]) delete[] tileData[t];
+  tileData.clear();
+  allocatedTiles = 0;
+}
+
+template<typename T, int rank>
+std::ptrdiff_t SparseTiledGridStorage<T, rank>::getSize() const
+{
+  std::ptrdiff_t size = 1;
+  for (int d = 0; d < rank; ++d) size *= dims[d];
+  return size;
+}
+
+template<typename T, int rank>
+inline void SparseTiledGridStorage<T, rank>::locate(
+    const IndexType &index,
+    std::ptrdiff_t &tile,
+    std::ptrdiff_t &offset) const
+{
+  tile = 0;
+  offset = 0;
+  for (int d=0; d<rank-tiledRank; ++d)
+  {
+    tile = tile*tiles[d] + (index[d] - low[d]);
+  }
+  for (int d=rank-tiledRank; d<rank; ++d)
+  {
+    int r = index[d] - low[d];
+    tile = tile*tiles[d] + (r >> tileBits);
+    offset = (offset << tileBits) | (r & (tileEdge-1));
+  }
+}
+
+template<typename T, int rank>
+inline T* SparseTiledGridStorage<T, rank>::allocateTile(std::ptrdiff_t tile)
+{
+  T *data = tileData[tile];
+  if (data == NULL)
+  {
+    data = new T[tileSize];
+    std::fill(data, data + tileSize, fillValue);
+    tileData[tile] = data;
+    ++allocatedTiles;
+  }
+  return data;
+}
+
+template<typename T, int rank>
+void SparseTiledGridStorage<T, rank>::releaseTile(std::ptrdiff_t tile)
+{
+  if (tileData[tile] == NULL) return;
+  delete[] tileData[tile];
+  tileData[tile] = NULL;
+  --allocatedTiles;
+}
+
+template<typename T, int rank>
+void SparseTiledGridStorage<T, rank>::releaseUniformTiles()
+{
+  for (std::ptrdiff_t t=0; t<getTileCount(); ++t)
+  {
+    const T *data = tileData[t];
+    if (data == NULL) continue;
+
+    // the padding of partial tiles still holds the fill value
+    bool uniform = true;
+    for (int i=0; uniform && (i<tileSize); ++i)
+      uniform = (data[i] == fillValue);
+
+    if (uniform) releaseTile(t);
+  }
+}
+
+template<typename T, int rank>
+void SparseTiledGridStorage<T, rank>::clear()
+{
+  for (std::ptrdiff_t t=0; t<getTileCount(); ++t) releaseTile(t);
+}
+
+template<typename T, int rank>
+typename SparseTiledGridStorage<T, rank>::RangeType
+  SparseTiledGridStorage<T, rank>::getTileRange(std::ptrdiff_t tile) const
+{
+  IndexType lo, hi;
+  for (int d=rank-1; d>=0; --d)
+  {
+    int b = tile % tiles[d];
+    tile /= tiles[d];
+    if (d < rank - tiledRank)
+    {
+      lo[d] = hi[d] = low[d] + b;
+    }
+    else
+    {
+      lo[d] = low[d] + (b << tileBits);
+      hi[d] = std::min(lo[d] + tileEdge - 1, high[d]);
+    }
+  }
+  return RangeType(lo, hi);
+}
+
+template<typename T, int rank>
+void SparseTiledGridStorage<T, rank>::startTile(Position &pos, std::ptrdiff_t tile) const
+{
+  pos.tile = tile;
+  pos.offset = 0;
+  if (tile >= this->getTileCount()) return;
+
+  std::ptrdiff_t b = tile;
+  for (int t=tiledRank-1; t>=0; --t)
+  {
+    int d = rank - tiledRank + t;
+    int start = (b % tiles[d]) << tileBits;
+    b /= tiles[d];
+    pos.local[t] = 0;
+    pos.extent[t] = std::min(int(tileEdge), dims[d] - start);
+  }
+}
+
+template<typename T, int rank>
+void SparseTiledGridStorage<T, rank>::advance(Position &pos) const
+{
+  int t = tiledRank - 1;
+  while ((t >= 0) && (++pos.local[t] == pos.extent[t]))
+  {
+    pos.local[t] = 0;
+    --t;
+  }
+
+  if (t < 0)
+  {
+    this->startTile(pos, pos.tile + 1);
+    return;
+  }
+
+  pos.offset = 0;
+  for (t=0; t<tiledRank; ++t)
+    pos.offset = (pos.offset << tileBits) | pos.local[t];
 }
 
 } // namespace schnek
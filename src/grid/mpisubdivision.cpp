@@ -25,6 +25,8 @@
  */
 
 #include "mpisubdivision.hpp"
+#include "reducedprecision.hpp"
+#include "gridreduction.hpp"
 
 using namespace schnek;
 
@@ -68,4 +70,23 @@ const MPI_Datatype MpiValueType<double>::value = MPI_DOUBLE;
 template<>
 const MPI_Datatype MpiValueType<long double>::value = MPI_LONG_DOUBLE;
 
+// The 16 bit floating point types are transferred as their bit patterns
+template<>
+const MPI_Datatype MpiValueType<Half>::value = MPI_UNSIGNED_SHORT;
+
+template<>
+const MPI_Datatype MpiValueType<BFloat16>::value = MPI_UNSIGNED_SHORT;
+
+/* **************************************************************
+ *                 Reduction entries                            *
+ ****************************************************************/
+
+void schnek::combineReductionEntriesMpi(void *in, void *inout, int *len, MPI_Datatype *datatype)
+{
+  int size;
+  MPI_Type_size(*datatype, &size);
+  combineReductionEntries(static_cast<const double*>(in), static_cast<double*>(inout),
+      *len, size/int(sizeof(double)));
+}
+
 #endif
@@ -34,8 +34,13 @@
 
 #include <mpi.h>
 
+#include <algorithm>
+
 namespace schnek {
 
+template<class GridType>
+class MPIExchangePlan;
+
 /** @brief a boundary class for multiple processor runs
  *
  * Is designed to be exchanged via the MPI protocol.
@@ -44,6 +49,7 @@ namespace schnek {
 template<class GridType>
 class MPICartSubdivision : public DomainSubdivision<GridType>
 {
+    friend class MPIExchangePlan<GridType>;
   public:
     typedef typename DomainSubdivision<GridType>::LimitType LimitType;
     typedef typename GridType::value_type value_type;
@@ -52,7 +58,33 @@ class MPICartSubdivision : public DomainSubdivision<GridType>
     typedef typename DomainSubdivision<GridType>::BufferType BufferType;
 
     enum {Rank = GridType::Rank};
+
+    /** The way the boundary data is transferred in exchange() */
+    enum ExchangeMode {
+      /// The cells are packed into buffers that are sent and unpacked
+      PackedExchange,
+      /// The cells are sent straight from and into the grid using subarray datatypes
+      SubarrayExchange
+    };
   protected:
+    /** The subarray datatypes for the ghost and source cells in one dimension
+     *
+     *  The datatypes describe the cells relative to the start of the grid
+     *  data and are valid for grids with the bounds lo, hi and the ordering
+     *  order.
+     */
+    struct SubarrayTypes
+    {
+        bool valid;
+        LimitType lo;
+        LimitType hi;
+        int order;
+        MPI_Datatype loGhost;
+        MPI_Datatype hiGhost;
+        MPI_Datatype loSource;
+        MPI_Datatype hiSource;
+    };
+
     /// The number of processes
     int ComSize;
 
@@ -62,6 +94,9 @@ class MPICartSubdivision : public DomainSubdivision<GridType>
     /// The Comm object referring to the cartesian process grid
     MPI_Comm comm;
 
+    /// The operation used by reduceEntries(), created in init()
+    MPI_Op reductionEntryOp;
+
     LimitType prevcoord; ///< The ranks of the neighbour processes towards the lower boundary
     LimitType nextcoord; ///< The ranks of the neighbour processes towards the higher boundary
 
@@ -78,6 +113,41 @@ class MPICartSubdivision : public DomainSubdivision<GridType>
     value_type *sendarr[Rank]; ///< send buffers for exchanging data
     value_type *recvarr[Rank]; ///< receive buffers for exchanging data
 
+    value_type *sendarrHi[Rank]; ///< send buffers for the upper boundary in a split-phase exchange
+    value_type *recvarrHi[Rank]; ///< receive buffers for the upper ghost cells in a split-phase exchange
+
+    /// The requests of a split-phase exchange, two receives and two sends in each dimension
+    MPI_Request exchRequests[Rank][4];
+
+    /// True while a split-phase exchange is in progress
+    bool exchPending[Rank];
+
+    /// The requests of a split-phase accumulation, two receives and two sends in each dimension
+    MPI_Request accRequests[Rank][4];
+
+    /// True while a split-phase accumulation is in progress
+    bool accPending[Rank];
+
+    /// The way exchange() transfers the data
+    ExchangeMode exchangeMode;
+
+    /// The datatypes for the grid layout that was exchanged last in each dimension
+    SubarrayTypes subarrayTypes[Rank];
+
+    /// Allocate the buffers for the packed exchange on first use
+    void allocateBuffers();
+
+    /** Returns the subarray datatypes for the layout of grid
+     *
+     *  The datatypes are created when the layout differs from the previous
+     *  call. Returns NULL if the grid data is not a dense array in C or
+     *  Fortran ordering. In that case data is set to NULL.
+     */
+    const SubarrayTypes *getSubarrayTypes(GridType &grid, int dim, void *&data);
+
+    /// Free the subarray datatypes of one dimension
+    void freeSubarrayTypes(int dim);
+
     /// The size of the scalar fields when reducing
     int scalarSize;
 
@@ -85,6 +155,11 @@ class MPICartSubdivision : public DomainSubdivision<GridType>
   public:
     using DomainSubdivision<GridType>::init;
     using DomainSubdivision<GridType>::exchange;
+    using DomainSubdivision<GridType>::beginExchange;
+    using DomainSubdivision<GridType>::finishExchange;
+    using DomainSubdivision<GridType>::accumulate;
+    using DomainSubdivision<GridType>::beginAccumulate;
+    using DomainSubdivision<GridType>::finishAccumulate;
     ///default constructor
     MPICartSubdivision();
 
@@ -97,6 +172,19 @@ class MPICartSubdivision : public DomainSubdivision<GridType>
     /// Return the global domain size excluding ghost cells
     const DomainType &getGlobalDomain() const { return globalDomain; }
 
+    /** Select the way exchange() transfers the data
+     *
+     *  With SubarrayExchange the ghost and source cells of grids with a
+     *  dense C or Fortran ordered storage are sent without packing, using
+     *  MPI subarray datatypes. The datatypes are created for the layout of
+     *  the grid and kept until a grid with a different layout is exchanged.
+     *  Other grids, and accumulate(), always use packed buffers.
+     */
+    void setExchangeMode(ExchangeMode mode) { exchangeMode = mode; }
+
+    /// The way exchange() transfers the data
+    ExchangeMode getExchangeMode() const { return exchangeMode; }
+
     /** @brief Exchanges the boundaries in direction specified by dim.
      *
      *  The outermost simulated cells are sent and the surrounding
@@ -104,11 +192,44 @@ class MPICartSubdivision : public DomainSubdivision<GridType>
      */
     void exchange(GridType &field, int dim);
 
+    /** @brief Starts the exchange of the boundaries in direction dim
+     *
+     *  The source cells are packed and sent with MPI_Isend, and the
+     *  receives for the ghost cells are posted with MPI_Irecv. Only one
+     *  split-phase exchange can be in progress in each dimension.
+     *
+     *  With SubarrayExchange the data is sent straight from the grid, so
+     *  the source cells must not be changed before finishExchange().
+     */
+    void beginExchange(GridType &grid, int dim);
+
+    /** @brief Waits for the exchange in direction dim and fills the ghost cells */
+    void finishExchange(GridType &grid, int dim);
+
     /** @brief Exchange the boundaries of a field function
      *  summing the data from ghost cells and inner cells
+     *
+     *  Both the ghost cells and the source cells hold the sums afterwards,
+     *  which takes four messages. Use beginAccumulate() when only the
+     *  source cells need the sums.
      */
     void accumulate(GridType &grid, int dim);
 
+    /** @brief Starts adding the ghost cells to the source cells of the neighbours in direction dim
+     *
+     *  The lower and higher ghost cells are packed and sent with MPI_Isend,
+     *  and the receives for the contributions of the neighbours are posted
+     *  with MPI_Irecv. Only two messages are sent, compared to four in
+     *  accumulate(). The ghost cells are set to zero after they have been
+     *  packed, so that the corners are not added twice when the following
+     *  dimensions are accumulated. An accumulation and a split-phase
+     *  exchange cannot be in progress in the same dimension at the same time.
+     */
+    void beginAccumulate(GridType &grid, int dim);
+
+    /** @brief Waits for the contributions in direction dim and adds them to the source cells */
+    void finishAccumulate(GridType &grid, int dim);
+
     /**
      * @param dim
      * @param orientation
@@ -141,6 +262,9 @@ class MPICartSubdivision : public DomainSubdivision<GridType>
     /// Use MPIALLReduce to calculate the maximum
     int sumReduce(int val) const;
 
+    /// Use a single MPI_Allreduce to combine all reduction entries
+    void reduceEntries(std::vector<double> &entries, int stride) const;
+
     /// The process with the rank zero is designated master process
     bool master() const { return ComRank==0; }
 
@@ -178,12 +302,124 @@ class MPICartSubdivision : public DomainSubdivision<GridType>
     bool isBoundHi(int dim) { return mycoord[dim]==dims[dim]-1; }
 };
 
+/** A precomputed boundary exchange for a single grid
+ *
+ *  The plan is created once for a grid and a subdivision and can then be
+ *  used in every time step. The contiguous spans of the ghost and source
+ *  cells, the buffers and persistent MPI requests created with
+ *  MPI_Send_init and MPI_Recv_init are set up in the constructor. An
+ *  exchange only copies the spans into the buffers, starts the requests
+ *  with MPI_Startall and copies the received data into the ghost cells.
+ *
+ *  The plan stores the addresses of the grid cells. It must be created
+ *  again when the grid is resized or exchanges its data with another grid,
+ *  for example with swap(). The subdivision must outlive the plan.
+ *
+ *  Example:
+ *  \begin{verbatim}
+ *  MPIExchangePlan<Field<double,3> > plan(subdivision, Ex);
+ *  for (int t=0; t<steps; ++t)
+ *  {
+ *    update(Ex);
+ *    plan.exchange();
+ *  }
+ *  \end{verbatim}
+ */
+template<class GridType>
+class MPIExchangePlan
+{
+  public:
+    typedef typename GridType::value_type value_type;
+    enum {Rank = GridType::Rank};
+  private:
+    /** A contiguous span of grid cells */
+    struct Span
+    {
+        value_type *data;
+        std::ptrdiff_t length;
+    };
+    typedef std::vector<Span> SpanList;
+
+    /** The spans, buffers and requests for one dimension */
+    struct DimensionPlan
+    {
+        SpanList loGhost;
+        SpanList hiGhost;
+        SpanList loSource;
+        SpanList hiSource;
+
+        std::vector<value_type> sendLo;
+        std::vector<value_type> sendHi;
+        std::vector<value_type> recvLo;
+        std::vector<value_type> recvHi;
+
+        /// The requests of exchange(): two receives followed by two sends
+        MPI_Request exchangeRequests[4];
+        /// The requests of accumulate(): four pairs of send and receive
+        MPI_Request accumulateRequests[8];
+    };
+
+    DimensionPlan plans[Rank];
+
+    /// Collect the spans of grid in domain
+    static void collectSpans(GridType &grid, const Range<int, Rank> &domain, SpanList &spans);
+    /// The number of cells in a list of spans
+    static std::ptrdiff_t countCells(const SpanList &spans);
+    /// The start of a buffer, or NULL if the buffer is empty
+    static value_type *bufferData(std::vector<value_type> &buffer);
+    /// Copy the cells of the spans into a buffer
+    static void pack(const SpanList &spans, value_type *buffer);
+    /// Copy a buffer into the cells of the spans
+    static void unpack(const SpanList &spans, const value_type *buffer);
+    /// Add a buffer to the cells of the spans and copy the sums into sums
+    static void add(const SpanList &spans, const value_type *buffer, value_type *sums);
+
+    MPIExchangePlan(const MPIExchangePlan&);
+    MPIExchangePlan &operator=(const MPIExchangePlan&);
+  public:
+    /** Set up the exchange of the boundaries of grid */
+    MPIExchangePlan(MPICartSubdivision<GridType> &subdivision, GridType &grid);
+
+    /** Frees the persistent requests */
+    ~MPIExchangePlan();
+
+    /** Exchange the boundaries in the direction given by dim
+     *
+     *  Has the same effect as MPICartSubdivision::exchange()
+     */
+    void exchange(int dim);
+
+    /** Exchange the boundaries in all directions */
+    void exchange()
+    {
+      for (int i=0; i<Rank; ++i) exchange(i);
+    }
+
+    /** Add the ghost cells to the inner cells of the neighbours in the direction given by dim
+     *
+     *  Has the same effect as MPICartSubdivision::accumulate()
+     */
+    void accumulate(int dim);
+
+    /** Accumulate the boundaries in all directions */
+    void accumulate()
+    {
+      for (int i=0; i<Rank; ++i) accumulate(i);
+    }
+};
+
 template<typename value_type>
 struct MpiValueType
 {
     static const MPI_Datatype value;
 };
 
+/** Combines the entries of a GridReduction, used to create an MPI_Op
+ *
+ *  The length of an entry is taken from the size of the MPI datatype.
+ */
+void combineReductionEntriesMpi(void *in, void *inout, int *len, MPI_Datatype *datatype);
+
 } // namespace schnek
 
 
@@ -42,17 +42,83 @@
 
 namespace schnek {
 
+/** The start of the data of a dense C ordered grid */
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+void *getDenseGridData(SingleArrayGridCOrderStorageBase<T, rank, AllocationPolicy> *storage, int &order)
+{
+  order = MPI_ORDER_C;
+  return storage->getRawData();
+}
+
+/** The start of the data of a dense Fortran ordered grid */
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+void *getDenseGridData(SingleArrayGridFortranOrderStorageBase<T, rank, AllocationPolicy> *storage, int &order)
+{
+  order = MPI_ORDER_FORTRAN;
+  return storage->getRawData();
+}
+
+/** Other layouts cannot be described by a subarray datatype */
+inline void *getDenseGridData(const void *, int &)
+{
+  return NULL;
+}
+
+/** Adds received values to a span of ghost cells and stores the sums in the send buffer */
+template<typename T>
+struct MpiAccumulateKernel
+{
+    const T *recv;
+    T *send;
+
+    MpiAccumulateKernel(const T *recv_, T *send_) : recv(recv_), send(send_) {}
+
+    template<class IndexType>
+    void operator()(T *data, std::ptrdiff_t length, const IndexType &)
+    {
+      for (std::ptrdiff_t i=0; i<length; ++i)
+      {
+        data[i] = data[i] + recv[i];
+        send[i] = data[i];
+      }
+      recv += length;
+      send += length;
+    }
+};
+
+/** Adds received values to a span of source cells */
+template<typename T>
+struct MpiAddKernel
+{
+    const T *recv;
+
+    MpiAddKernel(const T *recv_) : recv(recv_) {}
+
+    template<class IndexType>
+    void operator()(T *data, std::ptrdiff_t length, const IndexType &)
+    {
+      for (std::ptrdiff_t i=0; i<length; ++i) data[i] = data[i] + recv[i];
+      recv += length;
+    }
+};
+
 /* **************************************************************
  *                 MPICartSubdivision                    *
  ****************************************************************/
 
 template<class GridType>
-MPICartSubdivision<GridType>::MPICartSubdivision() : comm(0), prevcoord(0), nextcoord(0)
+MPICartSubdivision<GridType>::MPICartSubdivision()
+  : comm(0), reductionEntryOp(MPI_OP_NULL), prevcoord(0), nextcoord(0), exchangeMode(PackedExchange)
 {
   for (int i=0; i<Rank; ++i)
   {
     sendarr[i] = 0;
     recvarr[i] = 0;
+    sendarrHi[i] = 0;
+    recvarrHi[i] = 0;
+    exchPending[i] = false;
+    accPending[i] = false;
+    subarrayTypes[i].valid = false;
   }
 }
 
@@ -65,6 +131,8 @@ void MPICartSubdivision<GridType>::init(const LimitType &lo, const LimitType &hi
 
   MPI_Comm_size(MPI_COMM_WORLD, &ComSize);
 
+  if (reductionEntryOp == MPI_OP_NULL) MPI_Op_create(combineReductionEntriesMpi, 1, &reductionEntryOp);
+
   int periodic[Rank];
 
   std::vector<int> box(Rank);
@@ -118,19 +186,96 @@ void MPICartSubdivision<GridType>::init(const LimitType &lo, const LimitType &hi
   {
     exchSize[i] = exchangeSizeProduct/(High[i]-Low[i]+1);
     //std::cout << "Calculating exchange size "<<i<<": " << exchSize[i] << std::endl;
+  }
+
+  this->bounds = typename DomainSubdivision<GridType>::pBoundaryType(new BoundaryType(Low, High, delta));
+
+  DiagnosticManager::instance().setMaster(this->master());
+  DiagnosticManager::instance().setRank(this->procnum());
+}
+
+template<class GridType>
+void MPICartSubdivision<GridType>::allocateBuffers()
+{
+  if (sendarr[0]!=0) return;
+  for (int i=0; i<Rank; ++i)
+  {
     sendarr[i] = new value_type[exchSize[i]];
     recvarr[i] = new value_type[exchSize[i]];
+    sendarrHi[i] = new value_type[exchSize[i]];
+    recvarrHi[i] = new value_type[exchSize[i]];
     for (int k=0; k<exchSize[i]; ++k)
     {
       sendarr[i][k] = value_type();
       recvarr[i][k] = value_type();
+      sendarrHi[i][k] = value_type();
+      recvarrHi[i][k] = value_type();
     }
   }
+}
 
-  this->bounds = typename DomainSubdivision<GridType>::pBoundaryType(new BoundaryType(Low, High, delta));
+template<class GridType>
+void MPICartSubdivision<GridType>::freeSubarrayTypes(int dim)
+{
+  SubarrayTypes &types = subarrayTypes[dim];
+  if (!types.valid) return;
+  MPI_Type_free(&types.loGhost);
+  MPI_Type_free(&types.hiGhost);
+  MPI_Type_free(&types.loSource);
+  MPI_Type_free(&types.hiSource);
+  types.valid = false;
+}
 
-  DiagnosticManager::instance().setMaster(this->master());
-  DiagnosticManager::instance().setRank(this->procnum());
+/// Create and commit the subarray datatype for domain inside a grid with the bounds lo and hi
+template<class DomainType, class LimitType>
+MPI_Datatype createSubarrayType(const DomainType &domain,
+                                const LimitType &lo,
+                                const LimitType &hi,
+                                int order,
+                                MPI_Datatype mpiType)
+{
+  const int rank = LimitType::Length;
+  int sizes[rank], subsizes[rank], starts[rank];
+  for (int i=0; i<rank; ++i)
+  {
+    sizes[i] = hi[i] - lo[i] + 1;
+    subsizes[i] = domain.getHi()[i] - domain.getLo()[i] + 1;
+    starts[i] = domain.getLo()[i] - lo[i];
+  }
+  MPI_Datatype type;
+  MPI_Type_create_subarray(rank, sizes, subsizes, starts, order, mpiType, &type);
+  MPI_Type_commit(&type);
+  return type;
+}
+
+template<class GridType>
+const typename MPICartSubdivision<GridType>::SubarrayTypes *
+  MPICartSubdivision<GridType>::getSubarrayTypes(GridType &grid, int dim, void *&data)
+{
+  int order;
+  data = getDenseGridData(&grid, order);
+  if (data == NULL) return NULL;
+
+  SubarrayTypes &types = subarrayTypes[dim];
+  if (types.valid && (types.order == order) && (types.lo == grid.getLo()) && (types.hi == grid.getHi()))
+    return &types;
+
+  freeSubarrayTypes(dim);
+
+  MPI_Datatype mpiType = MpiValueType<value_type>::value;
+  types.lo = grid.getLo();
+  types.hi = grid.getHi();
+  types.order = order;
+  types.loGhost = createSubarrayType(this->bounds->getGhostDomain(dim, BoundaryType::Min),
+                                     types.lo, types.hi, order, mpiType);
+  types.hiGhost = createSubarrayType(this->bounds->getGhostDomain(dim, BoundaryType::Max),
+                                     types.lo, types.hi, order, mpiType);
+  types.loSource = createSubarrayType(this->bounds->getGhostSourceDomain(dim, BoundaryType::Min),
+                                      types.lo, types.hi, order, mpiType);
+  types.hiSource = createSubarrayType(this->bounds->getGhostSourceDomain(dim, BoundaryType::Max),
+                                      types.lo, types.hi, order, mpiType);
+  types.valid = true;
+  return &types;
 }
 
 template<class GridType>
@@ -138,9 +283,13 @@ MPICartSubdivision<GridType>::~MPICartSubdivision()
 {
   for (int i=0; i<Rank; ++i)
   {
+    freeSubarrayTypes(i);
     if (sendarr[i]!=0) delete[] sendarr[i];
     if (recvarr[i]!=0) delete[] recvarr[i];
+    if (sendarrHi[i]!=0) delete[] sendarrHi[i];
+    if (recvarrHi[i]!=0) delete[] recvarrHi[i];
   }
+  if (reductionEntryOp != MPI_OP_NULL) MPI_Op_free(&reductionEntryOp);
   if (comm!=0) MPI_Comm_free(&comm);
 }
 
@@ -150,13 +299,31 @@ void MPICartSubdivision<GridType>::exchange(GridType &grid, int dim)
   // nothing to be done
   //if (dims[dim]==1) return;
 
+  MPI_Status stat;
+
+  if (exchangeMode == SubarrayExchange)
+  {
+    void *data;
+    const SubarrayTypes *types = getSubarrayTypes(grid, dim, data);
+    if (types != NULL)
+    {
+      // the ghost and source cells are disjoint parts of the same array
+      MPI_Sendrecv(data, 1, types->hiSource, nextcoord[dim], 0,
+                   data, 1, types->loGhost, prevcoord[dim], 0,
+                   comm, &stat);
+      MPI_Sendrecv(data, 1, types->loSource, prevcoord[dim], 0,
+                   data, 1, types->hiGhost, nextcoord[dim], 0,
+                   comm, &stat);
+      return;
+    }
+  }
+
   DomainType loGhost = this->bounds->getGhostDomain(dim, BoundaryType::Min);
   DomainType hiGhost = this->bounds->getGhostDomain(dim, BoundaryType::Max);
   DomainType loSource = this->bounds->getGhostSourceDomain(dim, BoundaryType::Min);
   DomainType hiSource = this->bounds->getGhostSourceDomain(dim, BoundaryType::Max);
 
-  MPI_Status stat;
-
+  allocateBuffers();
   value_type *send = sendarr[dim];
   value_type *recv = recvarr[dim];
 
@@ -165,16 +332,7 @@ void MPICartSubdivision<GridType>::exchange(GridType &grid, int dim)
   // fill the lower ghost cells with the vales from higher source cells
   // in the neighbouring process
   {
-    int arr_ind = 0;
-    typename DomainType::iterator domIt  = hiSource.begin();
-    typename DomainType::iterator domEnd = hiSource.end();
-
-    while (domIt != domEnd)
-    {
-      send[arr_ind] = grid[*domIt];
-      ++arr_ind;
-      ++domIt;
-    }
+    int arr_ind = grid.pack(hiSource, send);
     if (arr_ind!=exchSize[dim]) {
       std::cerr << "Error "<< dim << "-min: "<< arr_ind << " vs " << exchSize[dim] << std::endl;
     }
@@ -183,32 +341,12 @@ void MPICartSubdivision<GridType>::exchange(GridType &grid, int dim)
   MPI_Sendrecv(send, exchSize[dim], mpiType, nextcoord[dim], 0,
                recv, exchSize[dim], mpiType, prevcoord[dim], 0,
                comm, &stat);
-  {
-    int arr_ind = 0;
-    typename DomainType::iterator domIt  = loGhost.begin();
-    typename DomainType::iterator domEnd = loGhost.end();
-
-    while (domIt != domEnd)
-    {
-      grid[*domIt] = recv[arr_ind];
-      ++arr_ind;
-      ++domIt;
-    }
-  }
+  grid.unpack(loGhost, recv);
 
   // fill the upper ghost cells with the values from lower source cells
   // in the neighbouring process
   {
-    int arr_ind = 0;
-    typename DomainType::iterator domIt  = loSource.begin();
-    typename DomainType::iterator domEnd = loSource.end();
-
-    while (domIt != domEnd)
-    {
-      send[arr_ind] = grid[*domIt];
-      ++arr_ind;
-      ++domIt;
-    }
+    int arr_ind = grid.pack(loSource, send);
     if (arr_ind!=exchSize[dim]) {
       std::cerr << "Error "<< dim << "-max: "<< arr_ind << " vs " << exchSize[dim] << std::endl;
     }
@@ -217,27 +355,90 @@ void MPICartSubdivision<GridType>::exchange(GridType &grid, int dim)
   MPI_Sendrecv(send, exchSize[dim], mpiType, prevcoord[dim], 0,
                recv, exchSize[dim], mpiType, nextcoord[dim], 0,
                comm, &stat);
-  {
-    int arr_ind = 0;
-    typename DomainType::iterator domIt  = hiGhost.begin();
-    typename DomainType::iterator domEnd = hiGhost.end();
+  grid.unpack(hiGhost, recv);
+}
+
+
+template<class GridType>
+void MPICartSubdivision<GridType>::beginExchange(GridType &grid, int dim)
+{
+  SCHNEK_ASSERT(!exchPending[dim], "An exchange is already in progress in dimension "
+      +boost::lexical_cast<std::string>(dim));
+  SCHNEK_ASSERT(!accPending[dim], "An accumulation is in progress in dimension "
+      +boost::lexical_cast<std::string>(dim));
+
+  MPI_Request *req = exchRequests[dim];
+  exchPending[dim] = true;
 
-    while (domIt != domEnd)
+  if (exchangeMode == SubarrayExchange)
+  {
+    void *data;
+    const SubarrayTypes *types = getSubarrayTypes(grid, dim, data);
+    if (types != NULL)
     {
-      grid[*domIt] = recv[arr_ind];
-      ++arr_ind;
-      ++domIt;
+      MPI_Irecv(data, 1, types->loGhost, prevcoord[dim], 1, comm, &req[0]);
+      MPI_Irecv(data, 1, types->hiGhost, nextcoord[dim], 2, comm, &req[1]);
+      MPI_Isend(data, 1, types->hiSource, nextcoord[dim], 1, comm, &req[2]);
+      MPI_Isend(data, 1, types->loSource, prevcoord[dim], 2, comm, &req[3]);
+      return;
     }
   }
+
+  DomainType loSource = this->bounds->getGhostSourceDomain(dim, BoundaryType::Min);
+  DomainType hiSource = this->bounds->getGhostSourceDomain(dim, BoundaryType::Max);
+
+  allocateBuffers();
+  MPI_Datatype mpiType = MpiValueType<value_type>::value;
+
+  // Post the receives first. The tags differ from the blocking exchange and
+  // distinguish the two directions when both neighbours are the same process
+  MPI_Irecv(recvarr[dim], exchSize[dim], mpiType, prevcoord[dim], 1, comm, &req[0]);
+  MPI_Irecv(recvarrHi[dim], exchSize[dim], mpiType, nextcoord[dim], 2, comm, &req[1]);
+
+  // the higher source cells fill the lower ghost cells of the next process
+  {
+    int arr_ind = grid.pack(hiSource, sendarr[dim]);
+    SCHNEK_ASSERT(arr_ind == exchSize[dim], "beginExchange: packed " << arr_ind << " values for dimension "
+        << dim << "-min instead of " << exchSize[dim]);
+  }
+  MPI_Isend(sendarr[dim], exchSize[dim], mpiType, nextcoord[dim], 1, comm, &req[2]);
+
+  // the lower source cells fill the upper ghost cells of the previous process
+  {
+    int arr_ind = grid.pack(loSource, sendarrHi[dim]);
+    SCHNEK_ASSERT(arr_ind == exchSize[dim], "beginExchange: packed " << arr_ind << " values for dimension "
+        << dim << "-max instead of " << exchSize[dim]);
+  }
+  MPI_Isend(sendarrHi[dim], exchSize[dim], mpiType, prevcoord[dim], 2, comm, &req[3]);
 }
 
+template<class GridType>
+void MPICartSubdivision<GridType>::finishExchange(GridType &grid, int dim)
+{
+  SCHNEK_ASSERT(exchPending[dim], "No exchange has been started in dimension "
+      +boost::lexical_cast<std::string>(dim));
+
+  MPI_Status stat[4];
+  MPI_Waitall(4, exchRequests[dim], stat);
+  exchPending[dim] = false;
+
+  // with subarray datatypes the data has been received into the grid
+  void *data;
+  if ((exchangeMode == SubarrayExchange) && (getSubarrayTypes(grid, dim, data) != NULL)) return;
+
+  DomainType loGhost = this->bounds->getGhostDomain(dim, BoundaryType::Min);
+  DomainType hiGhost = this->bounds->getGhostDomain(dim, BoundaryType::Max);
+
+  grid.unpack(loGhost, recvarr[dim]);
+  grid.unpack(hiGhost, recvarrHi[dim]);
+}
 
 template<class GridType>
 void MPICartSubdivision<GridType>::accumulate(GridType &grid, int dim)
 {
-  // This algorithm uses four MPI communication calls.
-  // For the usual bounds class this could be reduced to two calls but we will only do this
-  // when we find that the latency overhead becomes important.
+  // This algorithm uses four MPI communication calls and leaves the sums in
+  // both the ghost cells and the source cells.
+  // beginAccumulate() and finishAccumulate() only need two.
 
   // nothing to be done
   //if (dims[dim]==1) return;
@@ -249,6 +450,7 @@ void MPICartSubdivision<GridType>::accumulate(GridType &grid, int dim)
 
   MPI_Status stat;
 
+  allocateBuffers();
   value_type *send = sendarr[dim];
   value_type *recv = recvarr[dim];
 
@@ -260,16 +462,7 @@ void MPICartSubdivision<GridType>::accumulate(GridType &grid, int dim)
 
   // fill send buffer with values from inner cells
   {
-    int arr_ind = 0;
-    typename DomainType::iterator domIt  = hiSource.begin();
-    typename DomainType::iterator domEnd = hiSource.end();
-
-    while (domIt != domEnd)
-    {
-      send[arr_ind] = grid[*domIt];
-      ++arr_ind;
-      ++domIt;
-    }
+    int arr_ind = grid.pack(hiSource, send);
     if (arr_ind!=exchSize[dim]) {
       std::cerr << "Error "<< dim << "-min: "<< arr_ind << " vs " << exchSize[dim] << std::endl;
     }
@@ -279,37 +472,14 @@ void MPICartSubdivision<GridType>::accumulate(GridType &grid, int dim)
                recv, exchSize[dim], mpiType, prevcoord[dim], 0,
                comm, &stat);
   // add to the ghost cells and fill send array with the result
-  {
-    int arr_ind = 0;
-    typename DomainType::iterator domIt  = loGhost.begin();
-    typename DomainType::iterator domEnd = loGhost.end();
-
-    while (domIt != domEnd)
-    {
-      value_type &v = grid[*domIt];
-      v = v + recv[arr_ind];
-      // grid[*domIt] = v;
-      send[arr_ind] = v;
-      ++arr_ind;
-      ++domIt;
-    }
-  }
+  grid.forEachSpan(loGhost, MpiAccumulateKernel<value_type>(recv, send));
   // send back to neighbour
   MPI_Sendrecv(send, exchSize[dim], mpiType, prevcoord[dim], 0,
                recv, exchSize[dim], mpiType, nextcoord[dim], 0,
                comm, &stat);
   // save result back to inner cells
   {
-    int arr_ind = 0;
-    typename DomainType::iterator domIt  = hiSource.begin();
-    typename DomainType::iterator domEnd = hiSource.end();
-
-    while (domIt != domEnd)
-    {
-      grid[*domIt] = recv[arr_ind];
-      ++arr_ind;
-      ++domIt;
-    }
+    int arr_ind = grid.unpack(hiSource, recv);
     if (arr_ind!=exchSize[dim]) {
       std::cerr << "Error "<< dim << "-min: "<< arr_ind << " vs " << exchSize[dim] << std::endl;
     }
@@ -321,16 +491,7 @@ void MPICartSubdivision<GridType>::accumulate(GridType &grid, int dim)
 
   // fill send buffer with values from inner cells
   {
-    int arr_ind = 0;
-    typename DomainType::iterator domIt  = loSource.begin();
-    typename DomainType::iterator domEnd = loSource.end();
-
-    while (domIt != domEnd)
-    {
-      send[arr_ind] = grid[*domIt];
-      ++arr_ind;
-      ++domIt;
-    }
+    int arr_ind = grid.pack(loSource, send);
     if (arr_ind!=exchSize[dim]) {
       std::cerr << "Error "<< dim << "-max: "<< arr_ind << " vs " << exchSize[dim] << std::endl;
     }
@@ -340,43 +501,78 @@ void MPICartSubdivision<GridType>::accumulate(GridType &grid, int dim)
                recv, exchSize[dim], mpiType, nextcoord[dim], 0,
                comm, &stat);
   // add to the ghost cells and fill send array with the result
-  {
-    int arr_ind = 0;
-    typename DomainType::iterator domIt  = hiGhost.begin();
-    typename DomainType::iterator domEnd = hiGhost.end();
-
-    while (domIt != domEnd)
-    {
-      value_type &v = grid[*domIt];
-      v = v + recv[arr_ind];
-      // grid[*domIt] = v;
-      send[arr_ind] = v;
-      ++arr_ind;
-      ++domIt;
-    }
-  }
+  grid.forEachSpan(hiGhost, MpiAccumulateKernel<value_type>(recv, send));
   // send result back to neighbour
   MPI_Sendrecv(send, exchSize[dim], mpiType, nextcoord[dim], 0,
                recv, exchSize[dim], mpiType, prevcoord[dim], 0,
                comm, &stat);
   // save result back to inner cells
   {
-    int arr_ind = 0;
-    typename DomainType::iterator domIt  = loSource.begin();
-    typename DomainType::iterator domEnd = loSource.end();
-
-    while (domIt != domEnd)
-    {
-      grid[*domIt] = recv[arr_ind];
-      ++arr_ind;
-      ++domIt;
-    }
+    int arr_ind = grid.unpack(loSource, recv);
     if (arr_ind!=exchSize[dim]) {
       std::cerr << "Error "<< dim << "-max: "<< arr_ind << " vs " << exchSize[dim] << std::endl;
     }
   }
 }
 
+template<class GridType>
+void MPICartSubdivision<GridType>::beginAccumulate(GridType &grid, int dim)
+{
+  SCHNEK_ASSERT(!accPending[dim], "An accumulation is already in progress in dimension "
+      +boost::lexical_cast<std::string>(dim));
+  SCHNEK_ASSERT(!exchPending[dim], "An exchange is in progress in dimension "
+      +boost::lexical_cast<std::string>(dim));
+
+  DomainType loGhost = this->bounds->getGhostDomain(dim, BoundaryType::Min);
+  DomainType hiGhost = this->bounds->getGhostDomain(dim, BoundaryType::Max);
+
+  MPI_Request *req = accRequests[dim];
+  accPending[dim] = true;
+
+  allocateBuffers();
+  MPI_Datatype mpiType = MpiValueType<value_type>::value;
+
+  // The tags differ from the other exchange methods and distinguish the two
+  // directions when both neighbours are the same process
+  MPI_Irecv(recvarr[dim], exchSize[dim], mpiType, prevcoord[dim], 11, comm, &req[0]);
+  MPI_Irecv(recvarrHi[dim], exchSize[dim], mpiType, nextcoord[dim], 10, comm, &req[1]);
+
+  // the lower ghost cells are added to the higher source cells of the previous process
+  {
+    int arr_ind = grid.pack(loGhost, sendarr[dim]);
+    SCHNEK_ASSERT(arr_ind == exchSize[dim], "beginAccumulate: packed " << arr_ind << " values for dimension "
+        << dim << "-min instead of " << exchSize[dim]);
+  }
+  MPI_Isend(sendarr[dim], exchSize[dim], mpiType, prevcoord[dim], 10, comm, &req[2]);
+
+  // the higher ghost cells are added to the lower source cells of the next process
+  {
+    int arr_ind = grid.pack(hiGhost, sendarrHi[dim]);
+    SCHNEK_ASSERT(arr_ind == exchSize[dim], "beginAccumulate: packed " << arr_ind << " values for dimension "
+        << dim << "-max instead of " << exchSize[dim]);
+  }
+  MPI_Isend(sendarrHi[dim], exchSize[dim], mpiType, nextcoord[dim], 11, comm, &req[3]);
+
+  this->clearGhosts(grid, dim);
+}
+
+template<class GridType>
+void MPICartSubdivision<GridType>::finishAccumulate(GridType &grid, int dim)
+{
+  SCHNEK_ASSERT(accPending[dim], "No accumulation has been started in dimension "
+      +boost::lexical_cast<std::string>(dim));
+
+  MPI_Status stat[4];
+  MPI_Waitall(4, accRequests[dim], stat);
+  accPending[dim] = false;
+
+  DomainType loSource = this->bounds->getGhostSourceDomain(dim, BoundaryType::Min);
+  DomainType hiSource = this->bounds->getGhostSourceDomain(dim, BoundaryType::Max);
+
+  grid.forEachSpan(loSource, MpiAddKernel<value_type>(recvarr[dim]));
+  grid.forEachSpan(hiSource, MpiAddKernel<value_type>(recvarrHi[dim]));
+}
+
 template<class GridType>
 void MPICartSubdivision<GridType>::exchangeData(
         int dim,
@@ -392,21 +588,19 @@ void MPICartSubdivision<GridType>::exchangeData(
   int recvCoord = (orientation>0)?prevcoord[dim]:nextcoord[dim];
 
   MPI_Status stat;
+  MPI_Request request;
 
-  MPI_Sendrecv(
-      &sendSize, 1, MPI_INT, sendCoord, 0,
-      &recvSize, 1, MPI_INT, recvCoord, 0,
-      comm, &stat);
+  // A single message in each direction, the size of the incoming message
+  // is found by probing
+  MPI_Isend(in.getRawData(), sendSize, MPI_UNSIGNED_CHAR, sendCoord, 0, comm, &request);
 
+  MPI_Probe(recvCoord, 0, comm, &stat);
+  MPI_Get_count(&stat, MPI_UNSIGNED_CHAR, &recvSize);
 
-  out.resize(Index(recvSize));
+  if (out.getDims(0) != recvSize) out.resize(Index(recvSize));
 
-  // memcpy(out.getRawData(), in.getRawData(), sendSize*sizeof(value_type));
-
-  MPI_Sendrecv(
-      in.getRawData() , sendSize, MPI_UNSIGNED_CHAR, sendCoord, 0,
-      out.getRawData(), recvSize, MPI_UNSIGNED_CHAR, recvCoord, 0,
-      comm, &stat);
+  MPI_Recv(out.getRawData(), recvSize, MPI_UNSIGNED_CHAR, recvCoord, 0, comm, &stat);
+  MPI_Wait(&request, &stat);
 }
 
 template<class GridType>
@@ -467,6 +661,205 @@ int MPICartSubdivision<GridType>::sumReduce(int val) const
   return result;
 }
 
+template<class GridType>
+void MPICartSubdivision<GridType>::reduceEntries(std::vector<double> &entries, int stride) const
+{
+  if (entries.empty()) return;
+  int count = entries.size()/stride;
+
+  MPI_Datatype entryType;
+  MPI_Type_contiguous(stride, MPI_DOUBLE, &entryType);
+  MPI_Type_commit(&entryType);
+
+  std::vector<double> result(entries.size());
+  MPI_Allreduce(&entries[0], &result[0], count, entryType, reductionEntryOp, comm);
+  MPI_Type_free(&entryType);
+
+  entries.swap(result);
+}
+
+/* **************************************************************
+ *                 MPIExchangePlan                              *
+ ****************************************************************/
+
+/** Collects the spans visited by GridBase::forEachSpan() */
+template<class SpanList>
+struct MpiSpanCollector
+{
+    SpanList &spans;
+
+    MpiSpanCollector(SpanList &spans_) : spans(spans_) {}
+
+    template<typename T, class IndexType>
+    void operator()(T *data, std::ptrdiff_t length, const IndexType &)
+    {
+      typename SpanList::value_type span;
+      span.data = data;
+      span.length = length;
+      spans.push_back(span);
+    }
+};
+
+template<class GridType>
+void MPIExchangePlan<GridType>::collectSpans(GridType &grid, const Range<int, Rank> &domain, SpanList &spans)
+{
+  spans.clear();
+  grid.forEachSpan(domain, MpiSpanCollector<SpanList>(spans));
+}
+
+template<class GridType>
+std::ptrdiff_t MPIExchangePlan<GridType>::countCells(const SpanList &spans)
+{
+  std::ptrdiff_t count = 0;
+  for (std::size_t s=0; s<spans.size(); ++s) count += spans[s].length;
+  return count;
+}
+
+template<class GridType>
+typename MPIExchangePlan<GridType>::value_type *MPIExchangePlan<GridType>::bufferData(std::vector<value_type> &buffer)
+{
+  return buffer.empty() ? NULL : &buffer[0];
+}
+
+template<class GridType>
+void MPIExchangePlan<GridType>::pack(const SpanList &spans, value_type *buffer)
+{
+  for (std::size_t s=0; s<spans.size(); ++s)
+  {
+    copyGridSpan(buffer, spans[s].data, spans[s].length);
+    buffer += spans[s].length;
+  }
+}
+
+template<class GridType>
+void MPIExchangePlan<GridType>::unpack(const SpanList &spans, const value_type *buffer)
+{
+  for (std::size_t s=0; s<spans.size(); ++s)
+  {
+    copyGridSpan(spans[s].data, buffer, spans[s].length);
+    buffer += spans[s].length;
+  }
+}
+
+template<class GridType>
+void MPIExchangePlan<GridType>::add(const SpanList &spans, const value_type *buffer, value_type *sums)
+{
+  for (std::size_t s=0; s<spans.size(); ++s)
+  {
+    value_type *data = spans[s].data;
+    for (std::ptrdiff_t i=0; i<spans[s].length; ++i)
+    {
+      data[i] = data[i] + buffer[i];
+      sums[i] = data[i];
+    }
+    buffer += spans[s].length;
+    sums += spans[s].length;
+  }
+}
+
+template<class GridType>
+MPIExchangePlan<GridType>::MPIExchangePlan(MPICartSubdivision<GridType> &subdivision, GridType &grid)
+{
+  typedef typename MPICartSubdivision<GridType>::BoundaryType BoundaryType;
+  MPI_Datatype mpiType = MpiValueType<value_type>::value;
+  MPI_Comm comm = subdivision.comm;
+
+  // The tags are not used by the other exchange methods of MPICartSubdivision
+  for (int dim=0; dim<Rank; ++dim)
+  {
+    DimensionPlan &plan = plans[dim];
+    collectSpans(grid, subdivision.bounds->getGhostDomain(dim, BoundaryType::Min), plan.loGhost);
+    collectSpans(grid, subdivision.bounds->getGhostDomain(dim, BoundaryType::Max), plan.hiGhost);
+    collectSpans(grid, subdivision.bounds->getGhostSourceDomain(dim, BoundaryType::Min), plan.loSource);
+    collectSpans(grid, subdivision.bounds->getGhostSourceDomain(dim, BoundaryType::Max), plan.hiSource);
+
+    int count = countCells(plan.hiSource);
+    SCHNEK_ASSERT((countCells(plan.loGhost) == count) && (countCells(plan.hiGhost) == count)
+        && (countCells(plan.loSource) == count), "The ghost domains of an exchange plan differ in size");
+
+    plan.sendLo.resize(count);
+    plan.sendHi.resize(count);
+    plan.recvLo.resize(count);
+    plan.recvHi.resize(count);
+
+    int prev = subdivision.prevcoord[dim];
+    int next = subdivision.nextcoord[dim];
+    value_type *sendLo = bufferData(plan.sendLo);
+    value_type *sendHi = bufferData(plan.sendHi);
+    value_type *recvLo = bufferData(plan.recvLo);
+    value_type *recvHi = bufferData(plan.recvHi);
+
+    // exchange: the higher source cells fill the lower ghost cells of the next process
+    // and the lower source cells fill the higher ghost cells of the previous process
+    MPI_Request *req = plan.exchangeRequests;
+    MPI_Recv_init(recvLo, count, mpiType, prev, 4, comm, &req[0]);
+    MPI_Recv_init(recvHi, count, mpiType, next, 5, comm, &req[1]);
+    MPI_Send_init(sendHi, count, mpiType, next, 4, comm, &req[2]);
+    MPI_Send_init(sendLo, count, mpiType, prev, 5, comm, &req[3]);
+
+    // accumulate: the two round trips of MPICartSubdivision::accumulate()
+    req = plan.accumulateRequests;
+    MPI_Send_init(sendHi, count, mpiType, next, 6, comm, &req[0]);
+    MPI_Recv_init(recvLo, count, mpiType, prev, 6, comm, &req[1]);
+    MPI_Send_init(sendLo, count, mpiType, prev, 7, comm, &req[2]);
+    MPI_Recv_init(recvHi, count, mpiType, next, 7, comm, &req[3]);
+    MPI_Send_init(sendLo, count, mpiType, prev, 8, comm, &req[4]);
+    MPI_Recv_init(recvHi, count, mpiType, next, 8, comm, &req[5]);
+    MPI_Send_init(sendHi, count, mpiType, next, 9, comm, &req[6]);
+    MPI_Recv_init(recvLo, count, mpiType, prev, 9, comm, &req[7]);
+  }
+}
+
+template<class GridType>
+MPIExchangePlan<GridType>::~MPIExchangePlan()
+{
+  for (int dim=0; dim<Rank; ++dim)
+  {
+    for (int r=0; r<4; ++r) MPI_Request_free(&plans[dim].exchangeRequests[r]);
+    for (int r=0; r<8; ++r) MPI_Request_free(&plans[dim].accumulateRequests[r]);
+  }
+}
+
+template<class GridType>
+void MPIExchangePlan<GridType>::exchange(int dim)
+{
+  DimensionPlan &plan = plans[dim];
+  MPI_Status stat[4];
+
+  pack(plan.hiSource, bufferData(plan.sendHi));
+  pack(plan.loSource, bufferData(plan.sendLo));
+  MPI_Startall(4, plan.exchangeRequests);
+  MPI_Waitall(4, plan.exchangeRequests, stat);
+  unpack(plan.loGhost, bufferData(plan.recvLo));
+  unpack(plan.hiGhost, bufferData(plan.recvHi));
+}
+
+template<class GridType>
+void MPIExchangePlan<GridType>::accumulate(int dim)
+{
+  DimensionPlan &plan = plans[dim];
+  MPI_Request *req = plan.accumulateRequests;
+  MPI_Status stat[2];
+
+  // add the lower ghost cells to the higher source cells of the previous process
+  pack(plan.hiSource, bufferData(plan.sendHi));
+  MPI_Startall(2, req);
+  MPI_Waitall(2, req, stat);
+  add(plan.loGhost, bufferData(plan.recvLo), bufferData(plan.sendLo));
+  MPI_Startall(2, req + 2);
+  MPI_Waitall(2, req + 2, stat);
+  unpack(plan.hiSource, bufferData(plan.recvHi));
+
+  // add the higher ghost cells to the lower source cells of the next process
+  pack(plan.loSource, bufferData(plan.sendLo));
+  MPI_Startall(2, req + 4);
+  MPI_Waitall(2, req + 4, stat);
+  add(plan.hiGhost, bufferData(plan.recvHi), bufferData(plan.sendHi));
+  MPI_Startall(2, req + 6);
+  MPI_Waitall(2, req + 6, stat);
+  unpack(plan.loSource, bufferData(plan.recvLo));
+}
+
 ///returns an ID, which consists of the Dimensions and coordinates
 template<class GridType>
 int MPICartSubdivision<GridType>::getUniqueId() const
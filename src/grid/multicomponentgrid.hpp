@@ -0,0 +1,320 @@
+/*
+ * multicomponentgrid.hpp
+ *
+ * Created on: 16 Oct 2026
+ * Author: Holger Schmitz
+ * Email: holger@notjustphysics.com
+ *
+ * Copyright 2026 Holger Schmitz
+ *
+ * This file is part of Schnek.
+ *
+ * Schnek is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Schnek is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Schnek.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SCHNEK_MULTICOMPONENTGRID_HPP_
+#define SCHNEK_MULTICOMPONENTGRID_HPP_
+
+#include "grid.hpp"
+#include "range.hpp"
+
+#include <cstddef>
+
+namespace schnek {
+
+/** The memory layout of the components of a MultiComponentGrid */
+enum ComponentLayout {
+  /// Each component is stored in its own contiguous block
+  ComponentMajor,
+  /// The components of one grid point are adjacent in memory
+  ComponentInterleaved
+};
+
+/** A storage that refers to strided data owned by another grid
+ *
+ *  No memory is allocated. resize() only changes the index bounds, the
+ *  location of the data is set with setView().
+ */
+template<typename T, int rank>
+class ComponentViewStorage {
+  public:
+    typedef Array<int,rank> IndexType;
+    typedef Array<std::ptrdiff_t,rank> StrideType;
+    typedef Range<int, rank> DomainType;
+  protected:
+    /// The address of the element with index zero
+    T *origin;
+    StrideType strides;
+    DomainType domain;
+    IndexType dims;
+
+  public:
+
+    class storage_iterator {
+      protected:
+        typename DomainType::iterator it;
+        ComponentViewStorage *storage;
+        storage_iterator(typename DomainType::iterator it_, ComponentViewStorage *storage_)
+          : it(it_), storage(storage_) {}
+
+        friend class ComponentViewStorage;
+
+      public:
+        T& operator*() { return storage->get(*it); }
+        storage_iterator &operator++() { ++it; return *this; }
+        bool operator==(const storage_iterator &SI) { return it==SI.it; }
+        bool operator!=(const storage_iterator &SI) { return it!=SI.it; }
+    };
+
+    class const_storage_iterator {
+      protected:
+        typename DomainType::iterator it;
+        const ComponentViewStorage *storage;
+        const_storage_iterator(typename DomainType::iterator it_, const ComponentViewStorage *storage_)
+          : it(it_), storage(storage_) {}
+
+        friend class ComponentViewStorage;
+
+      public:
+        const T& operator*() { return storage->get(*it); }
+        const_storage_iterator &operator++() { ++it; return *this; }
+        bool operator==(const const_storage_iterator &SI) { return it==SI.it; }
+        bool operator!=(const const_storage_iterator &SI) { return it!=SI.it; }
+    };
+
+    ComponentViewStorage();
+
+    ComponentViewStorage(const IndexType &low_, const IndexType &high_);
+
+    /** sets the index bounds, the data is not touched */
+    void resize(const IndexType &low_, const IndexType &high_);
+
+    /** exchanges the view with another storage */
+    void swap(ComponentViewStorage &other);
+
+    /** sets the location of the data
+     *
+     *  The element at index i is found at origin_[sum_d i[d]*strides_[d]].
+     */
+    void setView(T *origin_, const StrideType &strides_);
+
+    T &get(const IndexType &index)
+    {
+      std::ptrdiff_t pos = 0;
+      for (int d=0; d<rank; ++d) pos += index[d]*strides[d];
+      return origin[pos];
+    }
+
+    const T &get(const IndexType &index) const
+    {
+      std::ptrdiff_t pos = 0;
+      for (int d=0; d<rank; ++d) pos += index[d]*strides[d];
+      return origin[pos];
+    }
+
+    /** The dimension along which spans are formed */
+    int getSpanDim() const { return rank-1; }
+
+    /** The number of contiguous elements starting at index along getSpanDim()
+     *
+     *  Spans contain a single element if the components are interleaved.
+     */
+    std::ptrdiff_t getSpanLength(const IndexType &index) const
+    {
+      return (strides[rank-1] == 1) ? (domain.getHi()[rank-1] - index[rank-1] + 1) : 1;
+    }
+
+    /** */
+    const IndexType& getLo() const { return domain.getLo(); }
+    /** */
+    const IndexType& getHi() const { return domain.getHi(); }
+    /** */
+    const IndexType& getDims() const { return dims; }
+
+    /** */
+    int getLo(int k) const { return domain.getLo()[k]; }
+    /** */
+    int getHi(int k) const { return domain.getHi()[k]; }
+    /** */
+    int getDims(int k) const { return dims[k]; }
+
+    /** The distances between neighbouring elements in each dimension */
+    const StrideType &getStrides() const { return strides; }
+
+    std::ptrdiff_t getSize() const;
+
+    storage_iterator begin() { return storage_iterator(domain.begin(), this); }
+    storage_iterator end() { return storage_iterator(domain.end(), this); }
+
+    const_storage_iterator cbegin() const { return const_storage_iterator(domain.cbegin(), this); }
+    const_storage_iterator cend() const { return const_storage_iterator(domain.cend(), this); }
+};
+
+/** A single component of a MultiComponentGrid
+ *
+ *  The component grid does not own any data, it refers to the memory of the
+ *  multi-component grid. It can be used wherever a grid of the given rank is
+ *  expected. Assigning values or grids to it changes the data of the
+ *  multi-component grid.
+ */
+template<
+  typename T,
+  int rank,
+  template<int> class CheckingPolicy = GridNoArgCheck
+>
+class ComponentGrid
+  : public GridBase<T, rank, CheckingPolicy<rank>, ComponentViewStorage<T, rank> >
+{
+  public:
+    typedef T value_type;
+    typedef Array<int,rank> IndexType;
+    typedef Range<int,rank> RangeType;
+    typedef ComponentGrid<T, rank, CheckingPolicy> GridType;
+    typedef GridBase<T, rank, CheckingPolicy<rank>, ComponentViewStorage<T, rank> > BaseType;
+    enum {Rank = rank};
+
+    /** default constructor creates an empty view */
+    ComponentGrid() : BaseType() {}
+
+    /** assign a value to all elements of the component */
+    GridType& operator=(const T &val)
+    {
+      BaseType::operator=(val);
+      return *this;
+    }
+
+    /** copy the values of another component */
+    GridType& operator=(const GridType &grid)
+    {
+      BaseType::operator=(grid);
+      return *this;
+    }
+
+    /** copy the values of another grid */
+    template<
+      typename T2,
+      class CheckingPolicy2,
+      class StoragePolicy2
+    >
+    GridType& operator=(const GridBase<T2, rank, CheckingPolicy2, StoragePolicy2> &grid)
+    {
+      BaseType::operator=(grid);
+      return *this;
+    }
+};
+
+/** A grid holding several components, such as the components of a vector field
+ *
+ *  All components are stored in a single allocation. The data is held in a
+ *  grid of rank rank+1 where one dimension enumerates the components. With
+ *  ComponentMajor layout the component index is the first index, so every
+ *  component occupies a contiguous block of memory. With ComponentInterleaved
+ *  layout the component index is the last index, and the components of a grid
+ *  point are adjacent in memory.
+ *
+ *  The grid of rank rank+1 is accessible through the base class. This allows
+ *  all components to be written to an HDF file in one data set. Each component
+ *  can be accessed as a grid of rank rank using component().
+ *
+ *  The storage policy must keep the data in a single strided array and
+ *  provide getStrides(), like the C and Fortran ordered and the aligned
+ *  storages. The component views use the strides of the storage, so the
+ *  layout names refer to the order of the indices. With Fortran ordering
+ *  ComponentMajor places the components of a grid point next to each other.
+ */
+template<
+  typename T,
+  int rank,
+  int components,
+  ComponentLayout layout = ComponentMajor,
+  template<int> class CheckingPolicy = GridNoArgCheck,
+  template<typename, int> class StoragePolicy = SingleArrayGridStorage
+>
+class MultiComponentGrid : public Grid<T, rank+1, CheckingPolicy, StoragePolicy>
+{
+  public:
+    typedef T value_type;
+    typedef Grid<T, rank+1, CheckingPolicy, StoragePolicy> BaseType;
+    typedef typename BaseType::IndexType IndexType;
+    typedef Array<int,rank> SpatialIndexType;
+    typedef Range<int,rank> SpatialRangeType;
+    typedef ComponentGrid<T, rank, CheckingPolicy> ComponentType;
+    typedef MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy> GridType;
+    enum {
+      Components = components,
+      SpatialRank = rank,
+      ComponentDim = (layout == ComponentMajor) ? 0 : rank
+    };
+  private:
+    ComponentType views[components];
+
+    /** points the component views to the current data */
+    void updateViews();
+  public:
+    /** default constructor creates an empty grid */
+    MultiComponentGrid();
+
+    /** constructs a grid whose components extend from low[i] to high[i] */
+    MultiComponentGrid(const SpatialIndexType &low, const SpatialIndexType &high);
+
+    /** copy constructor */
+    MultiComponentGrid(const GridType &grid);
+
+    /** assign another grid */
+    GridType& operator=(const GridType &grid);
+
+    /** assign a value to all components */
+    GridType& operator=(const T &val)
+    {
+      BaseType::operator=(val);
+      return *this;
+    }
+
+    /** resizes all components to extend from low[i] to high[i] */
+    void resize(const SpatialIndexType &low, const SpatialIndexType &high);
+
+    /** Exchange the contents with another grid
+     *
+     *  Only the pointers to the data and the bounds are exchanged. The
+     *  component views of both grids are updated.
+     */
+    void swap(GridType &grid);
+
+    /** The index into the grid of rank rank+1 for a component at a spatial position */
+    static IndexType makeIndex(int c, const SpatialIndexType &pos);
+
+    /** The lower spatial bound of the components */
+    SpatialIndexType getSpatialLo() const;
+    /** The upper spatial bound of the components */
+    SpatialIndexType getSpatialHi() const;
+
+    /** access a component at a spatial position, writing */
+    T &operator()(int c, const SpatialIndexType &pos) { return (*this)[makeIndex(c, pos)]; }
+    /** access a component at a spatial position, reading */
+    T operator()(int c, const SpatialIndexType &pos) const { return (*this)[makeIndex(c, pos)]; }
+
+    using BaseType::operator();
+
+    /** The grid view of component c */
+    ComponentType &component(int c) { return views[c]; }
+    /** The grid view of component c */
+    const ComponentType &component(int c) const { return views[c]; }
+};
+
+} // namespace schnek
+
+#include "multicomponentgrid.t"
+
+#endif // SCHNEK_MULTICOMPONENTGRID_HPP_
@@ -0,0 +1,254 @@
+/*
+ * multicomponentgrid.t
+ *
+ * Created on: 16 Oct 2026
+ * Author: Holger Schmitz
+ * Email: holger@notjustphysics.com
+ *
+ * Copyright 2026 Holger Schmitz
+ *
+ * This file is part of Schnek.
+ *
+ * Schnek is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Schnek is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Schnek.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <algorithm>
+
+namespace schnek
+{
+
+//=================================================================
+//=================== ComponentViewStorage ========================
+//=================================================================
+
+template<typename T, int rank>
+ComponentViewStorage<T, rank>::ComponentViewStorage()
+  : origin(NULL), strides(0), domain(IndexType(0), IndexType(-1)), dims(0)
+{}
+
+template<typename T, int rank>
+ComponentViewStorage<T, rank>::ComponentViewStorage(const IndexType &low_, const IndexType &high_)
+  : origin(NULL), strides(0)
+{
+  resize(low_, high_);
+}
+
+template<typename T, int rank>
+void ComponentViewStorage<T, rank>::resize(const IndexType &low_, const IndexType &high_)
+{
+  domain = DomainType(low_, high_);
+  for (int d = 0; d < rank; d++)
+    dims[d] = high_[d] - low_[d] + 1;
+}
+
+template<typename T, int rank>
+void ComponentViewStorage<T, rank>::swap(ComponentViewStorage &other)
+{
+  std::swap(origin, other.origin);
+  std::swap(strides, other.strides);
+  std::swap(domain, other.domain);
+  std::swap(dims, other.dims);
+}
+
+template<typename T, int rank>
+void ComponentViewStorage<T, rank>::setView(T *origin_, const StrideType &strides_)
+{
+  origin = origin_;
+  strides = strides_;
+}
+
+template<typename T, int rank>
+std::ptrdiff_t ComponentViewStorage<T, rank>::getSize() const
+{
+  std::ptrdiff_t size = 1;
+  for (int d = 0; d < rank; d++) size *= dims[d];
+  return size;
+}
+
+//=================================================================
+//==================== MultiComponentGrid =========================
+//=================================================================
+
+template<
+  typename T,
+  int rank,
+  int components,
+  ComponentLayout layout,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::MultiComponentGrid()
+  : BaseType()
+{}
+
+template<
+  typename T,
+  int rank,
+  int components,
+  ComponentLayout layout,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::MultiComponentGrid(
+    const SpatialIndexType &low, const SpatialIndexType &high)
+  : BaseType(makeIndex(0, low), makeIndex(components-1, high))
+{
+  updateViews();
+}
+
+template<
+  typename T,
+  int rank,
+  int components,
+  ComponentLayout layout,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::MultiComponentGrid(
+    const GridType &grid)
+  : BaseType(grid)
+{
+  updateViews();
+}
+
+template<
+  typename T,
+  int rank,
+  int components,
+  ComponentLayout layout,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>&
+  MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::operator=(
+    const GridType &grid)
+{
+  BaseType::operator=(grid);
+  updateViews();
+  return *this;
+}
+
+template<
+  typename T,
+  int rank,
+  int components,
+  ComponentLayout layout,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+void MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::resize(
+    const SpatialIndexType &low, const SpatialIndexType &high)
+{
+  BaseType::resize(makeIndex(0, low), makeIndex(components-1, high));
+  updateViews();
+}
+
+template<
+  typename T,
+  int rank,
+  int components,
+  ComponentLayout layout,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+void MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::swap(GridType &grid)
+{
+  BaseType::swap(grid);
+  updateViews();
+  grid.updateViews();
+}
+
+template<
+  typename T,
+  int rank,
+  int components,
+  ComponentLayout layout,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+typename MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::IndexType
+  MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::makeIndex(
+    int c, const SpatialIndexType &pos)
+{
+  IndexType index;
+  int offset = (layout == ComponentMajor) ? 1 : 0;
+  for (int d=0; d<rank; ++d) index[d+offset] = pos[d];
+  index[ComponentDim] = c;
+  return index;
+}
+
+template<
+  typename T,
+  int rank,
+  int components,
+  ComponentLayout layout,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+typename MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::SpatialIndexType
+  MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::getSpatialLo() const
+{
+  return this->getLo().projectDim(ComponentDim);
+}
+
+template<
+  typename T,
+  int rank,
+  int components,
+  ComponentLayout layout,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+typename MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::SpatialIndexType
+  MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::getSpatialHi() const
+{
+  return this->getHi().projectDim(ComponentDim);
+}
+
+template<
+  typename T,
+  int rank,
+  int components,
+  ComponentLayout layout,
+  template<int> class CheckingPolicy,
+  template<typename, int> class StoragePolicy
+>
+void MultiComponentGrid<T, rank, components, layout, CheckingPolicy, StoragePolicy>::updateViews()
+{
+  // the strides of the base storage, including any padding or Fortran ordering
+  const Array<std::ptrdiff_t, rank+1> &fullStrides = this->getStrides();
+
+  typename ComponentType::StoragePolicyType::StrideType strides;
+  int offset = (layout == ComponentMajor) ? 1 : 0;
+  for (int d=0; d<rank; ++d) strides[d] = fullStrides[d+offset];
+
+  SpatialIndexType spatialLo = getSpatialLo();
+  SpatialIndexType spatialHi = getSpatialHi();
+
+  std::ptrdiff_t loOffset = 0;
+  for (int d=0; d<rank; ++d) loOffset += spatialLo[d]*strides[d];
+
+  const BaseType &base = *this;
+  bool empty = (this->getSize() == 0);
+  for (int c=0; c<components; ++c)
+  {
+    // the address of the spatial index zero, derived from the lowest element of the component
+    T *origin = empty ? NULL : const_cast<T*>(&base.get(makeIndex(c, spatialLo))) - loOffset;
+    views[c].resize(spatialLo, spatialHi);
+    views[c].setView(origin, strides);
+  }
+}
+
+} // namespace schnek
@@ -0,0 +1,326 @@
+/*
+ * parallelfor.hpp
+ *
+ * Created on: 16 Oct 2026
+ * Author: Holger Schmitz
+ * Email: holger@notjustphysics.com
+ *
+ * Copyright 2026 Holger Schmitz
+ *
+ * This file is part of Schnek.
+ *
+ * Schnek is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Schnek is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Schnek.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SCHNEK_PARALLELFOR_HPP_
+#define SCHNEK_PARALLELFOR_HPP_
+
+#include "array.hpp"
+#include "range.hpp"
+#include "partition.hpp"
+#include "../util/threadpool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <pthread.h>
+
+namespace schnek {
+
+/** The way the tiles of a parallel loop are distributed over the threads */
+enum Schedule {
+  /// Every thread processes a fixed block of consecutive tiles
+  StaticSchedule,
+  /// The threads take the next unprocessed tile from a shared counter
+  DynamicSchedule,
+  /// Every thread starts with a block of tiles and steals from the others when it runs out
+  WorkStealingSchedule
+};
+
+/** Splits a range into rectangular tiles
+ *
+ *  The tiles have the size tileSize, except at the upper end of the range
+ *  where they are truncated. Tiles are numbered in C ordering, so
+ *  consecutive tiles are neighbours along the last dimension.
+ */
+template<int rank>
+class RangeTiling
+{
+  public:
+    typedef Array<int,rank> IndexType;
+    typedef Range<int,rank> RangeType;
+  private:
+    RangeType range;
+    IndexType tileSize;
+    IndexType tiles;
+    std::ptrdiff_t count;
+  public:
+    RangeTiling(const RangeType &range_, const IndexType &tileSize_)
+      : range(range_), tileSize(tileSize_)
+    {
+      count = 1;
+      for (int d=0; d<rank; ++d)
+      {
+        int extent = range.getHi()[d] - range.getLo()[d] + 1;
+        if (tileSize[d] < 1) tileSize[d] = 1;
+        tiles[d] = (extent > 0) ? (extent + tileSize[d] - 1)/tileSize[d] : 0;
+        count *= tiles[d];
+      }
+    }
+
+    /** The number of tiles */
+    std::ptrdiff_t getTileCount() const { return count; }
+
+    /** The index range of tile t */
+    RangeType getTile(std::ptrdiff_t t) const
+    {
+      IndexType lo, hi;
+      for (int d=rank-1; d>=0; --d)
+      {
+        int i = t % tiles[d];
+        t /= tiles[d];
+        lo[d] = range.getLo()[d] + i*tileSize[d];
+        hi[d] = std::min(lo[d] + tileSize[d] - 1, range.getHi()[d]);
+      }
+      return RangeType(lo, hi);
+    }
+};
+
+/** The job that executes the tiles of a parallel loop on the thread pool */
+template<int rank, class Kernel>
+class ParallelForJob : public ThreadPool::Job
+{
+  private:
+    /** A block of tiles owned by one thread */
+    struct TileQueue
+    {
+        std::ptrdiff_t begin;
+        std::ptrdiff_t end;
+        pthread_mutex_t mutex;
+    };
+
+    const RangeTiling<rank> &tiling;
+    Kernel &kernel;
+    Schedule schedule;
+
+    /// The next tile for the dynamic schedule
+    std::ptrdiff_t next;
+    pthread_mutex_t mutex;
+
+    /// The tile queues for the work stealing schedule
+    TileQueue *queues;
+    int queueCount;
+
+    void executeStatic(int thread, int threadCount)
+    {
+      StaticPartition partition(0, int(tiling.getTileCount()) - 1, threadCount);
+      if (thread >= partition.getCount()) return;
+      for (std::ptrdiff_t t = partition.getLo(thread); t <= partition.getHi(thread); ++t)
+        kernel(tiling.getTile(t));
+    }
+
+    void executeDynamic()
+    {
+      while (true)
+      {
+        std::ptrdiff_t t;
+        pthread_mutex_lock(&mutex);
+        t = next++;
+        pthread_mutex_unlock(&mutex);
+        if (t >= tiling.getTileCount()) return;
+        kernel(tiling.getTile(t));
+      }
+    }
+
+    /** Take a tile from the front of the queue */
+    bool pop(TileQueue &queue, std::ptrdiff_t &t)
+    {
+      pthread_mutex_lock(&queue.mutex);
+      bool found = (queue.begin < queue.end);
+      if (found) t = queue.begin++;
+      pthread_mutex_unlock(&queue.mutex);
+      return found;
+    }
+
+    /** Take the upper half of the tiles of another queue */
+    bool steal(TileQueue &victim, std::ptrdiff_t &begin, std::ptrdiff_t &end)
+    {
+      pthread_mutex_lock(&victim.mutex);
+      std::ptrdiff_t remaining = victim.end - victim.begin;
+      bool found = (remaining > 0);
+      if (found)
+      {
+        end = victim.end;
+        begin = victim.end - (remaining + 1)/2;
+        victim.end = begin;
+      }
+      pthread_mutex_unlock(&victim.mutex);
+      return found;
+    }
+
+    void executeWorkStealing(int thread)
+    {
+      TileQueue &own = queues[thread % queueCount];
+      while (true)
+      {
+        std::ptrdiff_t t;
+        if (pop(own, t))
+        {
+          kernel(tiling.getTile(t));
+          continue;
+        }
+
+        bool stolen = false;
+        for (int v=1; v<queueCount && !stolen; ++v)
+        {
+          std::ptrdiff_t begin, end;
+          if (steal(queues[(thread + v) % queueCount], begin, end))
+          {
+            pthread_mutex_lock(&own.mutex);
+            own.begin = begin;
+            own.end = end;
+            pthread_mutex_unlock(&own.mutex);
+            stolen = true;
+          }
+        }
+        if (!stolen) return;
+      }
+    }
+  public:
+    ParallelForJob(const RangeTiling<rank> &tiling_, Kernel &kernel_, Schedule schedule_, int threadCount)
+      : tiling(tiling_), kernel(kernel_), schedule(schedule_), next(0),
+        queues(NULL), queueCount(threadCount)
+    {
+      pthread_mutex_init(&mutex, NULL);
+      if (schedule == WorkStealingSchedule)
+      {
+        queues = new TileQueue[queueCount];
+        StaticPartition partition(0, int(tiling.getTileCount()) - 1, queueCount);
+        for (int q=0; q<queueCount; ++q)
+        {
+          queues[q].begin = (q < partition.getCount()) ? partition.getLo(q) : 0;
+          queues[q].end = (q < partition.getCount()) ? partition.getHi(q) + 1 : 0;
+          pthread_mutex_init(&queues[q].mutex, NULL);
+        }
+      }
+    }
+
+    ~ParallelForJob()
+    {
+      if (queues != NULL)
+      {
+        for (int q=0; q<queueCount; ++q) pthread_mutex_destroy(&queues[q].mutex);
+        delete[] queues;
+      }
+      pthread_mutex_destroy(&mutex);
+    }
+
+    void execute(int thread, int threadCount)
+    {
+      switch (schedule)
+      {
+        case StaticSchedule: executeStatic(thread, threadCount); break;
+        case DynamicSchedule: executeDynamic(); break;
+        case WorkStealingSchedule: executeWorkStealing(thread); break;
+      }
+    }
+};
+
+/** Execute a kernel on the tiles of a range using all threads of the ThreadPool
+ *
+ *  The range is split into tiles of size tileSize and kernel(tile) is called
+ *  once for every tile, where tile is a Range<int,rank>. The calls are made
+ *  concurrently from several threads on the same kernel object, so the
+ *  kernel must not modify shared state without synchronisation. The kernel
+ *  can access any grid, independent of its storage policy. An exception is
+ *  SparseTiledGridStorage, whose tiles must not be allocated concurrently.
+ *
+ *  Example:
+ *  \begin{verbatim}
+ *  struct Update {
+ *    Grid<double,3> &grid;
+ *    Update(Grid<double,3> &grid_) : grid(grid_) {}
+ *    void operator()(const Range<int,3> &tile) const {
+ *      grid.forEachSpan(tile, Scale(2.0));
+ *    }
+ *  };
+ *  parallelFor(range, IndexType(1,16,64), Update(grid), DynamicSchedule);
+ *  \end{verbatim}
+ */
+template<int rank, class Kernel>
+void parallelFor(const Range<int,rank> &range,
+                 const Array<int,rank> &tileSize,
+                 Kernel kernel,
+                 Schedule schedule = StaticSchedule)
+{
+  RangeTiling<rank> tiling(range, tileSize);
+  if (tiling.getTileCount() == 0) return;
+  ThreadPool &pool = ThreadPool::instance();
+  ParallelForJob<rank, Kernel> job(tiling, kernel, schedule, pool.getThreadCount());
+  pool.run(job);
+}
+
+/** Execute a kernel on the slabs of a range using all threads of the ThreadPool
+ *
+ *  Every tile is a single slab of the range along the first dimension. With
+ *  the static schedule each thread processes the slabs of the StaticPartition
+ *  that FirstTouchArrayGridStorage uses to place the memory.
+ */
+template<int rank, class Kernel>
+void parallelFor(const Range<int,rank> &range,
+                 Kernel kernel,
+                 Schedule schedule = StaticSchedule)
+{
+  Array<int,rank> tileSize;
+  tileSize[0] = 1;
+  for (int d=1; d<rank; ++d) tileSize[d] = range.getHi()[d] - range.getLo()[d] + 1;
+  parallelFor(range, tileSize, kernel, schedule);
+}
+
+/** Calls grid.forEachSpan(tile, kernel) for every tile of a parallel loop */
+template<class GridType, class Kernel>
+struct ParallelSpanKernel
+{
+    GridType &grid;
+    const Kernel &kernel;
+
+    ParallelSpanKernel(GridType &grid_, const Kernel &kernel_) : grid(grid_), kernel(kernel_) {}
+
+    void operator()(const Range<int, GridType::Rank> &tile) const
+    {
+      // every tile works on its own copy of the shared kernel
+      Kernel tileKernel(kernel);
+      grid.forEachSpan(tile, tileKernel);
+    }
+};
+
+/** Call kernel(data, length, start) for the spans of a grid in range, using all threads
+ *
+ *  Combines parallelFor() with GridBase::forEachSpan(). The kernel passed
+ *  to this function is shared by all threads and is only read. Every tile
+ *  copies it and calls the copy, so changes to the state of the kernel are
+ *  local to the tile and are not returned to the caller.
+ */
+template<class GridType, class Kernel>
+void parallelForEachSpan(GridType &grid,
+                         const Range<int, GridType::Rank> &range,
+                         const Kernel &kernel,
+                         Schedule schedule = StaticSchedule)
+{
+  parallelFor(range, ParallelSpanKernel<GridType, Kernel>(grid, kernel), schedule);
+}
+
+} // namespace schnek
+
+#endif // SCHNEK_PARALLELFOR_HPP_
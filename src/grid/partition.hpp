@@ -0,0 +1,72 @@
+/*
+ * partition.hpp
+ *
+ * Created on: 15 Oct 2026
+ * Author: Holger Schmitz
+ * Email: holger@notjustphysics.com
+ *
+ * Copyright 2026 Holger Schmitz
+ *
+ * This file is part of Schnek.
+ *
+ * Schnek is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Schnek is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Schnek.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SCHNEK_PARTITION_HPP_
+#define SCHNEK_PARTITION_HPP_
+
+#include <algorithm>
+
+namespace schnek {
+
+/** A static partition of an index interval into contiguous chunks
+ *
+ *  The interval lo...hi is split into a number of chunks whose lengths
+ *  differ by at most one. Chunk t is intended to be processed by thread t.
+ *  The first-touch allocation uses this partition over the outermost grid
+ *  dimension. Threaded loops that use the same partition will then access
+ *  memory that is local to the thread.
+ */
+class StaticPartition
+{
+  private:
+    int lo;
+    int length;
+    int count;
+  public:
+    /** Split lo...hi into at most count_ chunks */
+    StaticPartition(int lo_, int hi_, int count_)
+      : lo(lo_), length(hi_ - lo_ + 1), count(count_)
+    {
+      if (count > length) count = length;
+      if (count < 1) count = 1;
+    }
+
+    /** The number of chunks */
+    int getCount() const { return count; }
+
+    /** The lowest index of chunk t */
+    int getLo(int t) const
+    {
+      return lo + t*(length/count) + std::min(t, length%count);
+    }
+
+    /** The highest index of chunk t */
+    int getHi(int t) const { return getLo(t+1) - 1; }
+};
+
+} // namespace schnek
+
+#endif // SCHNEK_PARTITION_HPP_
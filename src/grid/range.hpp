@@ -270,6 +270,36 @@ class Range {
       hi[9] += d9;
     }
 
+    /** Calls func(start, length) for every line of the range along dimension dim
+     *
+     *  A line consists of the positions start, start + e_dim, ...,
+     *  start + (length-1)*e_dim. The lines are visited with the remaining
+     *  dimensions in C ordering. Visiting a line only costs one carry
+     *  propagation instead of one per position. The functor is passed by
+     *  value and returned, like std::for_each.
+     */
+    template<class Functor>
+    Functor forEachLine(int dim, Functor func) const
+    {
+      for (int d=0; d<rank; ++d)
+        if (hi[d] < lo[d]) return func;
+
+      LimitType pos(lo);
+      T length = hi[dim] - lo[dim] + 1;
+      while (true)
+      {
+        func(pos, length);
+        int d = rank-1;
+        for (; d>=0; --d)
+        {
+          if (d == dim) continue;
+          if (++pos[d] <= hi[d]) break;
+          pos[d] = lo[d];
+        }
+        if (d < 0) return func;
+      }
+    }
+
     /** Forward iterator over the rectangular domain
      *  Implements operator* and getPos which both return the current iterator position
      */
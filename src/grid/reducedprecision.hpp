@@ -0,0 +1,454 @@
+/*
+ * reducedprecision.hpp
+ *
+ * Created on: 16 Oct 2026
+ * Author: Holger Schmitz
+ * Email: holger@notjustphysics.com
+ *
+ * Copyright 2026 Holger Schmitz
+ *
+ * This file is part of Schnek.
+ *
+ * Schnek is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Schnek is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Schnek.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SCHNEK_REDUCEDPRECISION_HPP_
+#define SCHNEK_REDUCEDPRECISION_HPP_
+
+#include <boost/cstdint.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+#include "../util/exceptions.hpp"
+
+#ifdef __F16C__
+#include <immintrin.h>
+#endif
+
+namespace schnek {
+
+/** Conversion between single precision and the 16 bit floating point formats
+ *
+ *  All conversions round to nearest, ties to even. Infinities and NaNs are
+ *  preserved. Double precision values are first rounded to odd in single
+ *  precision with doubleToFloatOdd(), so that they are rounded to nearest
+ *  only once.
+ */
+namespace precision {
+
+inline boost::uint32_t floatBits(float f)
+{
+  boost::uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  return x;
+}
+
+inline float bitsFloat(boost::uint32_t x)
+{
+  float f;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+/** Double to single precision, rounded to odd
+ *
+ *  An inexact result is truncated towards zero and its last bit is set.
+ *  Rounding the result to nearest, ties to even, into a format with at least
+ *  two fewer significand bits gives the same value as rounding d directly.
+ */
+inline float doubleToFloatOdd(double d)
+{
+  float f = float(d);
+  if ((double(f) == d) || (d != d)) return f;
+  boost::uint32_t x = floatBits(f);
+  if (std::fabs(double(f)) > std::fabs(d)) --x;
+  return bitsFloat(x | 1u);
+}
+
+/** IEEE 754 single precision to binary16 */
+inline boost::uint16_t floatToHalf(float f)
+{
+  boost::uint32_t x = floatBits(f);
+  boost::uint32_t sign = (x >> 16) & 0x8000u;
+  boost::uint32_t absx = x & 0x7fffffffu;
+
+  // infinity and NaN, NaNs stay quiet NaNs
+  if (absx >= 0x7f800000u)
+    return sign | 0x7c00u | ((absx > 0x7f800000u) ? (0x0200u | ((absx >> 13) & 0x3ffu)) : 0u);
+
+  // values that round to infinity, 65520 and above
+  if (absx >= 0x477ff000u) return sign | 0x7c00u;
+
+  // subnormal results, below 2^-14
+  if (absx < 0x38800000u)
+  {
+    if (absx < 0x33000000u) return sign;
+    boost::uint32_t mant = (absx & 0x7fffffu) | 0x800000u;
+    int shift = 126 - int(absx >> 23);
+    boost::uint32_t h = mant >> shift;
+    boost::uint32_t rem = mant & ((1u << shift) - 1u);
+    boost::uint32_t halfway = 1u << (shift - 1);
+    if ((rem > halfway) || ((rem == halfway) && (h & 1u))) ++h;
+    return sign | h;
+  }
+
+  // normal results, a carry out of the mantissa increments the exponent
+  boost::uint32_t h = (absx - 0x38000000u) >> 13;
+  boost::uint32_t rem = absx & 0x1fffu;
+  if ((rem > 0x1000u) || ((rem == 0x1000u) && (h & 1u))) ++h;
+  return sign | h;
+}
+
+/** IEEE 754 binary16 to single precision, the conversion is exact */
+inline float halfToFloat(boost::uint16_t h)
+{
+  boost::uint32_t sign = boost::uint32_t(h & 0x8000u) << 16;
+  boost::uint32_t exponent = (h >> 10) & 0x1fu;
+  boost::uint32_t mant = h & 0x3ffu;
+
+  if (exponent == 0)
+  {
+    if (mant == 0) return bitsFloat(sign);
+    // subnormal, normalise the mantissa
+    exponent = 113;
+    while ((mant & 0x400u) == 0)
+    {
+      mant <<= 1;
+      --exponent;
+    }
+    return bitsFloat(sign | (exponent << 23) | ((mant & 0x3ffu) << 13));
+  }
+  if (exponent == 0x1f) return bitsFloat(sign | 0x7f800000u | (mant << 13));
+  return bitsFloat(sign | ((exponent + 112) << 23) | (mant << 13));
+}
+
+/** IEEE 754 single precision to bfloat16 */
+inline boost::uint16_t floatToBFloat16(float f)
+{
+  boost::uint32_t x = floatBits(f);
+  if ((x & 0x7fffffffu) > 0x7f800000u) return (x >> 16) | 0x0040u;
+  return (x + 0x7fffu + ((x >> 16) & 1u)) >> 16;
+}
+
+/** bfloat16 to IEEE 754 single precision, the conversion is exact */
+inline float bfloat16ToFloat(boost::uint16_t b)
+{
+  return bitsFloat(boost::uint32_t(b) << 16);
+}
+
+} // namespace precision
+
+/** A 16 bit IEEE 754 floating point number (binary16)
+ *
+ *  Half stores values with an 11 bit significand and a range up to 65504.
+ *  It is intended as the element type of grids that hold large amounts of
+ *  data at reduced precision. Grid<Half, rank> uses a quarter of the memory
+ *  of Grid<double, rank>, and exchanging the ghost cells of the grid sends
+ *  a quarter of the data.
+ *
+ *  Half converts implicitly to and from float, so that grid elements can be
+ *  read into and written from float or double variables. Arithmetic is
+ *  carried out in the compute type. Conversions from double and int are
+ *  rounded only once.
+ */
+class Half
+{
+  private:
+    boost::uint16_t bits;
+  public:
+    /** The value zero */
+    Half() : bits(0) {}
+    Half(float f) : bits(precision::floatToHalf(f)) {}
+    Half(double d) : bits(precision::floatToHalf(precision::doubleToFloatOdd(d))) {}
+    Half(int i) : bits(precision::floatToHalf(precision::doubleToFloatOdd(i))) {}
+
+    operator float() const { return precision::halfToFloat(bits); }
+
+    Half &operator+=(float f) { return *this = float(*this) + f; }
+    Half &operator-=(float f) { return *this = float(*this) - f; }
+    Half &operator*=(float f) { return *this = float(*this) * f; }
+    Half &operator/=(float f) { return *this = float(*this) / f; }
+
+    /** The bit pattern of the number */
+    boost::uint16_t getBits() const { return bits; }
+
+    /** Create a number from its bit pattern */
+    static Half fromBits(boost::uint16_t bits_)
+    {
+      Half h;
+      h.bits = bits_;
+      return h;
+    }
+};
+
+/** A 16 bit floating point number with the exponent range of float
+ *
+ *  BFloat16 keeps the upper 16 bits of an IEEE 754 single precision number.
+ *  The significand has only 8 bits but the range is the same as that of float,
+ *  so values do not overflow where float does not. Like Half, BFloat16
+ *  converts implicitly to and from float.
+ */
+class BFloat16
+{
+  private:
+    boost::uint16_t bits;
+  public:
+    /** The value zero */
+    BFloat16() : bits(0) {}
+    BFloat16(float f) : bits(precision::floatToBFloat16(f)) {}
+    BFloat16(double d) : bits(precision::floatToBFloat16(precision::doubleToFloatOdd(d))) {}
+    BFloat16(int i) : bits(precision::floatToBFloat16(precision::doubleToFloatOdd(i))) {}
+
+    operator float() const { return precision::bfloat16ToFloat(bits); }
+
+    BFloat16 &operator+=(float f) { return *this = float(*this) + f; }
+    BFloat16 &operator-=(float f) { return *this = float(*this) - f; }
+    BFloat16 &operator*=(float f) { return *this = float(*this) * f; }
+    BFloat16 &operator/=(float f) { return *this = float(*this) / f; }
+
+    /** The bit pattern of the number */
+    boost::uint16_t getBits() const { return bits; }
+
+    /** Create a number from its bit pattern */
+    static BFloat16 fromBits(boost::uint16_t bits_)
+    {
+      BFloat16 b;
+      b.bits = bits_;
+      return b;
+    }
+};
+
+//=================================================================
+//===================== Bulk conversion ===========================
+//=================================================================
+
+/** Convert n values of a compact type into a compute type
+ *
+ *  Use this to expand a block of reduced precision data into a work buffer
+ *  before running a kernel over the whole block.
+ */
+template<typename Compact, typename T>
+void loadCompact(const Compact *src, T *dest, std::ptrdiff_t n)
+{
+  for (std::ptrdiff_t i=0; i<n; ++i) dest[i] = T(float(src[i]));
+}
+
+/** Convert n values of a compute type into a compact type
+ *
+ *  Use this to write the results of a kernel back into reduced precision
+ *  storage.
+ */
+template<typename Compact, typename T>
+void storeCompact(const T *src, Compact *dest, std::ptrdiff_t n)
+{
+  for (std::ptrdiff_t i=0; i<n; ++i) dest[i] = Compact(src[i]);
+}
+
+#ifdef __F16C__
+
+/* When the F16C instructions are available, the conversions between Half
+ * and float or double are carried out eight values at a time.
+ */
+
+namespace precision {
+
+/** Two doubles rounded to odd at single precision, see doubleToFloatOdd()
+ *
+ *  The 29 significand bits that do not fit into a float are cleared and the
+ *  lowest remaining bit is set if any of them was set. The conversion to
+ *  float is then exact for results in the normal range of float. Smaller
+ *  results round to zero in binary16 in any case.
+ */
+inline __m128d roundToOddPd(__m128d d)
+{
+  const __m128i low = _mm_set1_epi64x(0x1fffffffLL);
+  const __m128i odd = _mm_set1_epi64x(0x20000000LL);
+  __m128i x = _mm_castpd_si128(d);
+  __m128i exact = _mm_cmpeq_epi64(_mm_and_si128(x, low), _mm_setzero_si128());
+  x = _mm_or_si128(_mm_andnot_si128(low, x), _mm_andnot_si128(exact, odd));
+  return _mm_castsi128_pd(x);
+}
+
+/** Four doubles to floats, rounded to odd */
+inline __m128 cvtpdOddPs(__m256d d)
+{
+  __m256d odd = _mm256_insertf128_pd(
+      _mm256_castpd128_pd256(roundToOddPd(_mm256_castpd256_pd128(d))),
+      roundToOddPd(_mm256_extractf128_pd(d, 1)), 1);
+  return _mm256_cvtpd_ps(odd);
+}
+
+} // namespace precision
+
+template<>
+inline void loadCompact<Half, float>(const Half *src, float *dest, std::ptrdiff_t n)
+{
+  std::ptrdiff_t i = 0;
+  for (; i+8<=n; i+=8)
+  {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_ps(dest + i, _mm256_cvtph_ps(h));
+  }
+  for (; i<n; ++i) dest[i] = float(src[i]);
+}
+
+template<>
+inline void loadCompact<Half, double>(const Half *src, double *dest, std::ptrdiff_t n)
+{
+  std::ptrdiff_t i = 0;
+  for (; i+8<=n; i+=8)
+  {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m256 f = _mm256_cvtph_ps(h);
+    _mm256_storeu_pd(dest + i, _mm256_cvtps_pd(_mm256_castps256_ps128(f)));
+    _mm256_storeu_pd(dest + i + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(f, 1)));
+  }
+  for (; i<n; ++i) dest[i] = float(src[i]);
+}
+
+template<>
+inline void storeCompact<Half, float>(const float *src, Half *dest, std::ptrdiff_t n)
+{
+  std::ptrdiff_t i = 0;
+  for (; i+8<=n; i+=8)
+  {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), h);
+  }
+  for (; i<n; ++i) dest[i] = Half(src[i]);
+}
+
+template<>
+inline void storeCompact<Half, double>(const double *src, Half *dest, std::ptrdiff_t n)
+{
+  std::ptrdiff_t i = 0;
+  for (; i+8<=n; i+=8)
+  {
+    __m128 lo = precision::cvtpdOddPs(_mm256_loadu_pd(src + i));
+    __m128 hi = precision::cvtpdOddPs(_mm256_loadu_pd(src + i + 4));
+    __m256 f = _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+    __m128i h = _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), h);
+  }
+  for (; i<n; ++i) dest[i] = Half(src[i]);
+}
+
+#endif // __F16C__
+
+/** Converts the elements of a compact source grid into the spans of a grid
+ *
+ *  Where the source is contiguous along the same dimension the span is
+ *  converted with loadCompact(), otherwise element by element.
+ */
+template<class SourceGrid>
+struct LoadCompactKernel
+{
+    const SourceGrid &source;
+    int dim;
+
+    LoadCompactKernel(const SourceGrid &source_, int dim_) : source(source_), dim(dim_) {}
+
+    template<typename T, class IndexType>
+    void operator()(T *data, std::ptrdiff_t length, const IndexType &start)
+    {
+      if ((source.getSpanDim() == dim) && (source.getSpanLength(start) >= length))
+      {
+        loadCompact(&source.get(start), data, length);
+      }
+      else
+      {
+        IndexType pos(start);
+        for (std::ptrdiff_t i=0; i<length; ++i)
+        {
+          pos[dim] = start[dim] + int(i);
+          data[i] = T(float(source.get(pos)));
+        }
+      }
+    }
+};
+
+/** Converts the elements of a source grid into the spans of a compact grid
+ *
+ *  Where the source is contiguous along the same dimension the span is
+ *  converted with storeCompact(), otherwise element by element.
+ */
+template<class SourceGrid>
+struct StoreCompactKernel
+{
+    const SourceGrid &source;
+    int dim;
+
+    StoreCompactKernel(const SourceGrid &source_, int dim_) : source(source_), dim(dim_) {}
+
+    template<typename Compact, class IndexType>
+    void operator()(Compact *data, std::ptrdiff_t length, const IndexType &start)
+    {
+      if ((source.getSpanDim() == dim) && (source.getSpanLength(start) >= length))
+      {
+        storeCompact(&source.get(start), data, length);
+      }
+      else
+      {
+        IndexType pos(start);
+        for (std::ptrdiff_t i=0; i<length; ++i)
+        {
+          pos[dim] = start[dim] + int(i);
+          data[i] = Compact(source.get(pos));
+        }
+      }
+    }
+};
+
+/** Convert a whole grid of a compact type into a grid of a compute type
+ *
+ *  Both grids must have the same bounds but can use different storage
+ *  policies. The target grid is traversed with forEachSpan() and each span
+ *  is converted with loadCompact() where the source is contiguous along the
+ *  same dimension.
+ */
+template<class ComputeGrid, class CompactGrid>
+void loadCompact(const CompactGrid &src, ComputeGrid &dest)
+{
+  SCHNEK_ASSERT((src.getLo() == dest.getLo()) && (src.getHi() == dest.getHi()),
+      "loadCompact: the grids must have the same bounds");
+  typedef typename ComputeGrid::RangeType RangeType;
+  dest.forEachSpan(RangeType(dest.getLo(), dest.getHi()),
+                   LoadCompactKernel<CompactGrid>(src, dest.getSpanDim()));
+}
+
+/** Convert a whole grid of a compute type into a grid of a compact type
+ *
+ *  Both grids must have the same bounds but can use different storage
+ *  policies. The target grid is traversed with forEachSpan() and each span
+ *  is converted with storeCompact() where the source is contiguous along the
+ *  same dimension.
+ */
+template<class ComputeGrid, class CompactGrid>
+void storeCompact(const ComputeGrid &src, CompactGrid &dest)
+{
+  SCHNEK_ASSERT((src.getLo() == dest.getLo()) && (src.getHi() == dest.getHi()),
+      "storeCompact: the grids must have the same bounds");
+  typedef typename CompactGrid::RangeType RangeType;
+  dest.forEachSpan(RangeType(dest.getLo(), dest.getHi()),
+                   StoreCompactKernel<ComputeGrid>(src, dest.getSpanDim()));
+}
+
+} // namespace schnek
+
+#endif // SCHNEK_REDUCEDPRECISION_HPP_
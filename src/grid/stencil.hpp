@@ -0,0 +1,210 @@
+/*
+ * stencil.hpp
+ *
+ * Created on: 16 Oct 2026
+ * Author: Holger Schmitz
+ * Email: holger@notjustphysics.com
+ *
+ * Copyright 2026 Holger Schmitz
+ *
+ * This file is part of Schnek.
+ *
+ * Schnek is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Schnek is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Schnek.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SCHNEK_STENCIL_HPP_
+#define SCHNEK_STENCIL_HPP_
+
+#include "array.hpp"
+#include "grid.hpp"
+#include "gridexpression.hpp"
+
+#include <cstddef>
+
+namespace schnek {
+
+/** The strides of storages that keep their data in a single strided array
+ *
+ *  Returns true and sets strides if the element at pos + e_i is found
+ *  strides[i] elements after the element at pos.
+ */
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+inline bool getShiftStrides(const SingleArrayGridCOrderStorageBase<T, rank, AllocationPolicy> *storage,
+                            Array<std::ptrdiff_t, rank> &strides)
+{
+  strides = storage->getStrides();
+  return true;
+}
+
+/** */
+template<typename T, int rank, template<typename, int> class AllocationPolicy>
+inline bool getShiftStrides(const SingleArrayGridFortranOrderStorageBase<T, rank, AllocationPolicy> *storage,
+                            Array<std::ptrdiff_t, rank> &strides)
+{
+  strides = storage->getStrides();
+  return true;
+}
+
+/** */
+template<typename T, int rank>
+inline bool getShiftStrides(const AlignedArrayGridStorage<T, rank> *storage,
+                            Array<std::ptrdiff_t, rank> &strides)
+{
+  strides = storage->getStrides();
+  return true;
+}
+
+/** Tiled and sparse storages have no fixed strides */
+template<class StrideType>
+inline bool getShiftStrides(const void *, StrideType &)
+{
+  return false;
+}
+
+/** A leaf of a grid expression that reads a grid at a fixed offset
+ *
+ *  The value at the index pos is grid[pos + offset], where the components
+ *  of the offset are the template parameters d0, d1, d2. Only the first rank
+ *  components are used. Objects are created with shift().
+ *
+ *  For storages with fixed strides the offset is turned into a distance in
+ *  memory when the leaf is created. A shifted element is then found by
+ *  adding this distance to the address of the element at pos.
+ */
+template<class GridType, int d0, int d1, int d2>
+class GridShiftExp {
+  private:
+    enum {Rank = GridType::Rank};
+
+    /// The grid
+    const GridType &grid;
+    /// True if the storage has fixed strides and delta is valid
+    bool strided;
+    /// The distance in memory between the element at pos and the element at pos + offset
+    std::ptrdiff_t delta;
+    /// The component of the offset along the span dimension of the grid
+    int spanShift;
+
+    /// The component i of the offset
+    static int getShift(int i) { return (i == 0) ? d0 : ((i == 1) ? d1 : d2); }
+
+    template<class IndexType>
+    IndexType shifted(const IndexType &pos) const
+    {
+      IndexType result;
+      for (int i=0; i<Rank; ++i) result[i] = pos[i] + getShift(i);
+      return result;
+    }
+  public:
+    typedef typename GridType::value_type value_type;
+    typedef const value_type *SpanType;
+
+    GridShiftExp(const GridType &grid_) : grid(grid_), delta(0)
+    {
+      Array<std::ptrdiff_t, Rank> strides;
+      strided = getShiftStrides(&grid, strides);
+      if (strided)
+        for (int i=0; i<Rank; ++i) delta += getShift(i)*strides[i];
+      spanShift = getShift(grid.getSpanDim());
+    }
+
+    template<class IndexType>
+    value_type operator[](const IndexType &pos) const
+    {
+      return strided ? (&grid.get(pos))[delta] : grid.get(shifted(pos));
+    }
+
+    template<class IndexType>
+    bool isContiguous(const IndexType &start, int dim, std::ptrdiff_t length) const
+    {
+      return (grid.getSpanDim() == dim) && (getSpanLength(start) >= length);
+    }
+
+    template<class IndexType>
+    SpanType getSpan(const IndexType &start) const
+    {
+      return strided ? &grid.get(start) + delta : &grid.get(shifted(start));
+    }
+
+    int getSpanDim() const { return grid.getSpanDim(); }
+
+    /** The span of a strided storage ends at the same place for every start
+     *  index along the span dimension, so the length is that at start less
+     *  the shift.
+     */
+    template<class IndexType>
+    std::ptrdiff_t getSpanLength(const IndexType &start) const
+    {
+      return strided ? grid.getSpanLength(start) - spanShift : grid.getSpanLength(shifted(start));
+    }
+};
+
+/** The values of a one dimensional grid shifted by d0
+ *
+ *  shift<d0>(grid) is a grid expression whose value at i is grid(i+d0).
+ */
+template<int d0, typename T, class CheckingPolicy, class StoragePolicy>
+GridExpression<GridShiftExp<GridBase<T, 1, CheckingPolicy, StoragePolicy>, d0, 0, 0>, 1>
+  shift(const GridBase<T, 1, CheckingPolicy, StoragePolicy> &grid)
+{
+  typedef GridShiftExp<GridBase<T, 1, CheckingPolicy, StoragePolicy>, d0, 0, 0> OperatorType;
+  return GridExpression<OperatorType, 1>(OperatorType(grid));
+}
+
+/** The values of a two dimensional grid shifted by (d0, d1)
+ *
+ *  shift<d0,d1>(grid) is a grid expression whose value at (i,j) is
+ *  grid(i+d0, j+d1).
+ */
+template<int d0, int d1, typename T, class CheckingPolicy, class StoragePolicy>
+GridExpression<GridShiftExp<GridBase<T, 2, CheckingPolicy, StoragePolicy>, d0, d1, 0>, 2>
+  shift(const GridBase<T, 2, CheckingPolicy, StoragePolicy> &grid)
+{
+  typedef GridShiftExp<GridBase<T, 2, CheckingPolicy, StoragePolicy>, d0, d1, 0> OperatorType;
+  return GridExpression<OperatorType, 2>(OperatorType(grid));
+}
+
+/** The values of a three dimensional grid shifted by (d0, d1, d2)
+ *
+ *  shift<d0,d1,d2>(grid) is a grid expression whose value at (i,j,k) is
+ *  grid(i+d0, j+d1, k+d2). Shifted grids combine with other grids and
+ *  scalars into stencils that are evaluated by assigning them to a range
+ *  of the target grid.
+ *
+ *  Example, the Laplacian of u:
+ *  \begin{verbatim}
+ *  Range<int,3> inner(u.getInnerLo(), u.getInnerHi());
+ *  lap.assign(inner, (shift<1,0,0>(u) + shift<-1,0,0>(u)
+ *                   + shift<0,1,0>(u) + shift<0,-1,0>(u)
+ *                   + shift<0,0,1>(u) + shift<0,0,-1>(u) - 6.0*u)/(dx*dx));
+ *  \end{verbatim}
+ *
+ *  The expression is evaluated span by span. For each span the position
+ *  of every shifted grid is computed once, and the inner loop runs over
+ *  plain pointers along the contiguous dimension. The target grid must not
+ *  appear in the expression with a non-zero shift, because elements would
+ *  then be read after they have been overwritten.
+ */
+template<int d0, int d1, int d2, typename T, class CheckingPolicy, class StoragePolicy>
+GridExpression<GridShiftExp<GridBase<T, 3, CheckingPolicy, StoragePolicy>, d0, d1, d2>, 3>
+  shift(const GridBase<T, 3, CheckingPolicy, StoragePolicy> &grid)
+{
+  typedef GridShiftExp<GridBase<T, 3, CheckingPolicy, StoragePolicy>, d0, d1, d2> OperatorType;
+  return GridExpression<OperatorType, 3>(OperatorType(grid));
+}
+
+} // namespace schnek
+
+#endif // SCHNEK_STENCIL_HPP_
@@ -30,6 +30,9 @@
 #include "grid.hpp"
 #include "range.hpp"
 
+#include <algorithm>
+#include <cstddef>
+
 namespace schnek {
 
 template<
@@ -104,6 +107,9 @@ class SubGridStorage {
 
     void resize(const IndexType &low_, const IndexType &high_);
 
+    /** exchanges the base grid and the domain with another storage */
+    void swap(SubGridStorage &other);
+
     T &get(const IndexType &index)
     {
       //typename BaseGrid::CheckingPolicy<rank>::check(index, domain.getLo(), domain.getHi());
@@ -116,6 +122,17 @@ class SubGridStorage {
       return baseGrid->get(baseGrid->check(index, domain.getLo(), domain.getHi()));
     }
 
+    /** The dimension along which the elements of the base grid are contiguous */
+    int getSpanDim() const { return baseGrid->getSpanDim(); }
+
+    /** The number of contiguous elements starting at index along getSpanDim() */
+    std::ptrdiff_t getSpanLength(const IndexType &index) const
+    {
+      int dim = baseGrid->getSpanDim();
+      return std::min(baseGrid->getSpanLength(index),
+                      std::ptrdiff_t(domain.getHi()[dim] - index[dim] + 1));
+    }
+
     /** */
     const IndexType& getLo() const { return domain.getLo(); }
     /** */
@@ -219,6 +236,48 @@ class SubGrid
      */
     SubGrid(const RangeType &range, BaseGridType &baseGrid_);
 
+    /** assign a value to all elements of the sub grid */
+    SubGrid& operator=(const value_type &val)
+    {
+      ParentType::operator=(val);
+      return *this;
+    }
+
+    /** copy the elements of another sub grid into the base grid
+     *
+     *  The sub grid takes the bounds of grid, which must lie inside the
+     *  base grid. The elements are copied span by span along the
+     *  contiguous dimension of the base grid.
+     */
+    SubGrid& operator=(const SubGrid &grid)
+    {
+      ParentType::operator=(grid);
+      return *this;
+    }
+
+    /** copy the elements of a grid into the base grid
+     *
+     *  The sub grid takes the bounds of grid, which must lie inside the
+     *  base grid.
+     */
+    template<
+      typename T2,
+      class CheckingPolicy2,
+      class StoragePolicy2
+    >
+    SubGrid& operator=(const GridBase<T2, Rank, CheckingPolicy2, StoragePolicy2> &grid)
+    {
+      ParentType::operator=(grid);
+      return *this;
+    }
+
+    /** assign the result of a grid expression */
+    template<class Operator>
+    SubGrid& operator=(const GridExpression<Operator, Rank> &expr)
+    {
+      ParentType::operator=(expr);
+      return *this;
+    }
 };
 
 
@@ -55,7 +55,21 @@ template<
 >
 void SubGridStorage<T, rank, BaseGrid>::resize(const IndexType &low_, const IndexType &high_)
 {
-    domain = DomainType(low_, high_);
+  domain = DomainType(low_, high_);
+  for (int d = 0; d < rank; d++)
+    dims[d] = high_[d] - low_[d] + 1;
+}
+
+template<
+  typename T,
+  int rank,
+  class BaseGrid
+>
+void SubGridStorage<T, rank, BaseGrid>::swap(SubGridStorage &other)
+{
+  std::swap(baseGrid, other.baseGrid);
+  std::swap(domain, other.domain);
+  std::swap(dims, other.dims);
 }
 
 template<
@@ -24,5 +24,7 @@
  *
  */
 
+#include "util/memorypool.hpp"
 #include "util/singleton.hpp"
+#include "util/threadpool.hpp"
 #include "util/unique.hpp"
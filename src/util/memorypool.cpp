@@ -0,0 +1,203 @@
+/*
+ * memorypool.cpp
+ *
+ * Created on: 16 Oct 2026
+ * Author: Holger Schmitz
+ * Email: holger@notjustphysics.com
+ *
+ * Copyright 2026 Holger Schmitz
+ *
+ * This file is part of Schnek.
+ *
+ * Schnek is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Schnek is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Schnek.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "memorypool.hpp"
+
+#include <new>
+#include <cstdlib>
+
+using namespace schnek;
+
+const std::size_t MemoryPool::alignment;
+const std::size_t MemoryPool::minBlockSize;
+const int MemoryPool::fineClassBits;
+const std::size_t MemoryPool::fineClassThreshold;
+const int MemoryPool::fineClassCount;
+const std::size_t MemoryPool::defaultCacheLimit;
+
+namespace {
+
+/** Locks a mutex for the lifetime of the object */
+class PoolLock
+{
+  private:
+    pthread_mutex_t &mutex;
+  public:
+    PoolLock(pthread_mutex_t &mutex_) : mutex(mutex_)
+    {
+      pthread_mutex_lock(&mutex);
+    }
+    ~PoolLock()
+    {
+      pthread_mutex_unlock(&mutex);
+    }
+};
+
+} // namespace
+
+MemoryPool::MemoryPool()
+  : freeLists(fineClassBits + 1 + fineClassCount*(8*sizeof(std::size_t) - fineClassBits)),
+    cacheLimit(defaultCacheLimit)
+{
+  stats.requests = 0;
+  stats.hits = 0;
+  stats.bytesInUse = 0;
+  stats.peakBytesInUse = 0;
+  stats.bytesCached = 0;
+  pthread_mutex_init(&mutex, NULL);
+}
+
+MemoryPool::~MemoryPool()
+{
+  trim();
+  pthread_mutex_destroy(&mutex);
+}
+
+int MemoryPool::getSizeClass(std::size_t bytes)
+{
+  int log2 = 0;
+  while ((std::size_t(1) << log2) < minBlockSize) ++log2;
+  while ((std::size_t(1) << log2) < bytes) ++log2;
+  if (log2 <= fineClassBits) return log2;
+
+  // bytes lies in the interval (base, 2*base], which is split into fineClassCount steps
+  std::size_t base = std::size_t(1) << (log2 - 1);
+  std::size_t step = base/fineClassCount;
+  int sub = int((bytes - base + step - 1)/step);
+  return fineClassBits + (log2 - 1 - fineClassBits)*fineClassCount + sub;
+}
+
+std::size_t MemoryPool::getClassSize(int sizeClass)
+{
+  if (sizeClass <= fineClassBits) return std::size_t(1) << sizeClass;
+
+  int fine = sizeClass - fineClassBits - 1;
+  std::size_t base = std::size_t(1) << (fineClassBits + fine/fineClassCount);
+  return base + (fine%fineClassCount + 1)*(base/fineClassCount);
+}
+
+std::size_t MemoryPool::getBlockSize(std::size_t bytes)
+{
+  return getClassSize(getSizeClass(bytes));
+}
+
+void *MemoryPool::allocate(std::size_t bytes, std::size_t &blockSize)
+{
+  int sizeClass = getSizeClass(bytes);
+  blockSize = getClassSize(sizeClass);
+  void *block = NULL;
+
+  {
+    PoolLock lock(mutex);
+    ++stats.requests;
+    std::vector<void*> &freeList = freeLists[sizeClass];
+    if (!freeList.empty())
+    {
+      block = freeList.back();
+      freeList.pop_back();
+      ++stats.hits;
+      stats.bytesCached -= blockSize;
+    }
+    stats.bytesInUse += blockSize;
+    if (stats.bytesInUse > stats.peakBytesInUse)
+      stats.peakBytesInUse = stats.bytesInUse;
+  }
+
+  if ((block == NULL) && (posix_memalign(&block, alignment, blockSize) != 0))
+  {
+    PoolLock lock(mutex);
+    stats.bytesInUse -= blockSize;
+    throw std::bad_alloc();
+  }
+  return block;
+}
+
+void MemoryPool::release(void *block, std::size_t blockSize)
+{
+  if (block == NULL) return;
+  {
+    PoolLock lock(mutex);
+    stats.bytesInUse -= blockSize;
+    if (stats.bytesCached + blockSize <= cacheLimit)
+    {
+      freeLists[getSizeClass(blockSize)].push_back(block);
+      stats.bytesCached += blockSize;
+      return;
+    }
+  }
+  free(block);
+}
+
+std::size_t MemoryPool::getCacheLimit()
+{
+  PoolLock lock(mutex);
+  return cacheLimit;
+}
+
+void MemoryPool::setCacheLimit(std::size_t limit)
+{
+  PoolLock lock(mutex);
+  cacheLimit = limit;
+
+  // free the largest blocks first
+  for (std::size_t i=freeLists.size(); (i>0) && (stats.bytesCached > cacheLimit); --i)
+  {
+    std::vector<void*> &freeList = freeLists[i-1];
+    std::size_t blockSize = getClassSize(int(i-1));
+    while (!freeList.empty() && (stats.bytesCached > cacheLimit))
+    {
+      free(freeList.back());
+      freeList.pop_back();
+      stats.bytesCached -= blockSize;
+    }
+  }
+}
+
+void MemoryPool::trim()
+{
+  PoolLock lock(mutex);
+  for (std::size_t i=0; i<freeLists.size(); ++i)
+  {
+    std::vector<void*> &freeList = freeLists[i];
+    for (std::size_t j=0; j<freeList.size(); ++j) free(freeList[j]);
+    freeList.clear();
+  }
+  stats.bytesCached = 0;
+}
+
+MemoryPool::Statistics MemoryPool::getStatistics()
+{
+  PoolLock lock(mutex);
+  return stats;
+}
+
+void MemoryPool::resetStatistics()
+{
+  PoolLock lock(mutex);
+  stats.requests = 0;
+  stats.hits = 0;
+  stats.peakBytesInUse = stats.bytesInUse;
+}
@@ -0,0 +1,144 @@
+/*
+ * memorypool.hpp
+ *
+ * Created on: 16 Oct 2026
+ * Author: Holger Schmitz
+ * Email: holger@notjustphysics.com
+ *
+ * Copyright 2026 Holger Schmitz
+ *
+ * This file is part of Schnek.
+ *
+ * Schnek is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Schnek is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Schnek.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SCHNEK_MEMORYPOOL_HPP_
+#define SCHNEK_MEMORYPOOL_HPP_
+
+#include "singleton.hpp"
+
+#include <vector>
+#include <cstddef>
+#include <pthread.h>
+
+namespace schnek {
+
+/** A process wide pool of memory blocks
+ *
+ *  Up to fineClassThreshold bytes the pool hands out blocks whose sizes are
+ *  powers of two. Above it, every interval between two powers of two is
+ *  split into fineClassCount size classes, so that a block is at most 12.5%
+ *  larger than the request. Blocks that are released are kept in a free
+ *  list for their size class, as long as the free lists hold no more than
+ *  getCacheLimit() bytes, and are returned to the system otherwise. A later
+ *  request of the same size class is served from the free list without
+ *  calling the system allocator.
+ *
+ *  All blocks are aligned to 64 bytes. The pool is thread safe.
+ */
+class MemoryPool : public Singleton<MemoryPool>
+{
+  public:
+    /** Usage statistics of the pool */
+    struct Statistics
+    {
+        /// The number of calls to allocate()
+        std::size_t requests;
+        /// The number of requests that were served from a free list
+        std::size_t hits;
+        /// The number of bytes currently handed out
+        std::size_t bytesInUse;
+        /// The maximum of bytesInUse since the last reset
+        std::size_t peakBytesInUse;
+        /// The number of bytes held in the free lists
+        std::size_t bytesCached;
+
+        /// The fraction of requests that were served from a free list
+        double getHitRate() const
+        {
+          return (requests > 0) ? double(hits)/double(requests) : 0.0;
+        }
+    };
+
+    /// The alignment of all blocks in bytes
+    static const std::size_t alignment = 64;
+    /// The size of the smallest block in bytes
+    static const std::size_t minBlockSize = 64;
+    /// The base 2 logarithm of the largest block size that is a power of two
+    static const int fineClassBits = 20;
+    /// The block size above which the finer size classes are used
+    static const std::size_t fineClassThreshold = std::size_t(1) << fineClassBits;
+    /// The number of size classes between two powers of two above fineClassThreshold
+    static const int fineClassCount = 8;
+    /// The default of the maximum number of bytes held in the free lists
+    static const std::size_t defaultCacheLimit = std::size_t(1) << 30;
+
+  private:
+    friend class Singleton<MemoryPool>;
+    friend class CreateUsingNew<MemoryPool>;
+
+    /// The free lists, indexed by the size class
+    std::vector<std::vector<void*> > freeLists;
+    Statistics stats;
+    std::size_t cacheLimit;
+    pthread_mutex_t mutex;
+
+    MemoryPool();
+    ~MemoryPool();
+
+    static int getSizeClass(std::size_t bytes);
+    static std::size_t getClassSize(int sizeClass);
+  public:
+    /** The size of the block that would be returned for a request
+     *  of the given number of bytes
+     */
+    static std::size_t getBlockSize(std::size_t bytes);
+
+    /** Allocate a block of at least the given number of bytes
+     *
+     *  The actual size of the block is returned in blockSize. It has to
+     *  be passed to release() when the block is returned to the pool.
+     *  Throws std::bad_alloc if the memory can not be allocated.
+     */
+    void *allocate(std::size_t bytes, std::size_t &blockSize);
+
+    /** Return a block to the pool
+     *
+     *  The block is freed if keeping it would exceed the cache limit.
+     */
+    void release(void *block, std::size_t blockSize);
+
+    /** The maximum number of bytes held in the free lists */
+    std::size_t getCacheLimit();
+
+    /** Set the maximum number of bytes held in the free lists
+     *
+     *  Cached blocks are freed until the free lists fit into the new limit.
+     */
+    void setCacheLimit(std::size_t limit);
+
+    /** Return all blocks in the free lists to the system */
+    void trim();
+
+    /** Get the usage statistics */
+    Statistics getStatistics();
+
+    /** Reset the request counters and the peak usage */
+    void resetStatistics();
+};
+
+} // namespace schnek
+
+#endif // SCHNEK_MEMORYPOOL_HPP_
@@ -0,0 +1,278 @@
+/*
+ * threadpool.cpp
+ *
+ * Created on: 16 Oct 2026
+ * Author: Holger Schmitz
+ * Email: holger@notjustphysics.com
+ *
+ * Copyright 2026 Holger Schmitz
+ *
+ * This file is part of Schnek.
+ *
+ * Schnek is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Schnek is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Schnek.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "threadpool.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <sched.h>
+#include <unistd.h>
+
+#include "exceptions.hpp"
+
+using namespace schnek;
+
+namespace {
+
+/** Locks a mutex for the lifetime of the object */
+class ThreadLock
+{
+  private:
+    pthread_mutex_t &mutex;
+  public:
+    ThreadLock(pthread_mutex_t &mutex_) : mutex(mutex_)
+    {
+      pthread_mutex_lock(&mutex);
+    }
+    ~ThreadLock()
+    {
+      pthread_mutex_unlock(&mutex);
+    }
+};
+
+} // namespace
+
+bool schnek::isStartedByMpiLauncher()
+{
+  const char *vars[] = {"OMPI_COMM_WORLD_SIZE", "PMI_SIZE", "PMIX_RANK",
+                        "MPI_LOCALNRANKS", "MV2_COMM_WORLD_SIZE"};
+  for (std::size_t i=0; i<sizeof(vars)/sizeof(vars[0]); ++i)
+    if (getenv(vars[i]) != NULL) return true;
+  return false;
+}
+
+int schnek::getDefaultThreadCount()
+{
+  const char *env = getenv("SCHNEK_NUM_THREADS");
+  if (env != NULL)
+  {
+    int n = atoi(env);
+    if (n > 0) return n;
+  }
+  if (isStartedByMpiLauncher()) return 1;
+#ifdef CPU_COUNT
+  cpu_set_t cpus;
+  if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0)
+  {
+    int n = CPU_COUNT(&cpus);
+    if (n > 0) return n;
+  }
+#endif
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return (n > 0) ? int(n) : 1;
+}
+
+bool schnek::getDefaultThreadBinding()
+{
+  const char *env = getenv("SCHNEK_BIND_THREADS");
+  return (env != NULL) && (atoi(env) != 0);
+}
+
+ThreadPool::ThreadPool()
+  : threadCount(1), binding(false), job(NULL), generation(0), pending(0), shutdown(false), failures(0)
+{
+  pthread_mutex_init(&mutex, NULL);
+  pthread_cond_init(&jobReady, NULL);
+  pthread_cond_init(&jobDone, NULL);
+  pthread_mutex_init(&runMutex, NULL);
+
+#ifdef CPU_COUNT
+  cpu_set_t cpus;
+  if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0)
+  {
+    for (int c=0; c<CPU_SETSIZE; ++c)
+      if (CPU_ISSET(c, &cpus)) processors.push_back(c);
+  }
+#endif
+
+  binding = getDefaultThreadBinding();
+  if (binding) setAffinity(pthread_self(), 0);
+  startWorkers(getDefaultThreadCount());
+}
+
+ThreadPool::~ThreadPool()
+{
+  stopWorkers();
+  pthread_mutex_destroy(&runMutex);
+  pthread_cond_destroy(&jobDone);
+  pthread_cond_destroy(&jobReady);
+  pthread_mutex_destroy(&mutex);
+}
+
+void ThreadPool::startWorkers(int count)
+{
+  shutdown = false;
+  threadCount = 1;
+  for (int t=1; t<count; ++t)
+  {
+    Worker *worker = new Worker;
+    worker->pool = this;
+    worker->index = t;
+    worker->generation = generation;
+    if (pthread_create(&worker->thread, NULL, workerMain, worker) != 0)
+    {
+      // continue with the threads that could be created
+      delete worker;
+      break;
+    }
+    if (binding) setAffinity(worker->thread, t);
+    workers.push_back(worker);
+    ++threadCount;
+  }
+}
+
+void ThreadPool::stopWorkers()
+{
+  {
+    ThreadLock lock(mutex);
+    shutdown = true;
+    pthread_cond_broadcast(&jobReady);
+  }
+  for (std::size_t i=0; i<workers.size(); ++i)
+  {
+    pthread_join(workers[i]->thread, NULL);
+    delete workers[i];
+  }
+  workers.clear();
+  threadCount = 1;
+}
+
+void ThreadPool::setThreadCount(int count)
+{
+  ThreadLock runLock(runMutex);
+  stopWorkers();
+  startWorkers(count);
+}
+
+void ThreadPool::setThreadBinding(bool bind)
+{
+  ThreadLock runLock(runMutex);
+  binding = bind;
+  setAffinity(pthread_self(), bind ? 0 : -1);
+  for (std::size_t i=0; i<workers.size(); ++i)
+    setAffinity(workers[i]->thread, bind ? workers[i]->index : -1);
+}
+
+void ThreadPool::setAffinity(pthread_t thread, int index)
+{
+#ifdef CPU_COUNT
+  if (processors.empty()) return;
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  if (index < 0)
+  {
+    for (std::size_t i=0; i<processors.size(); ++i) CPU_SET(processors[i], &cpus);
+  }
+  else
+    CPU_SET(processors[index % processors.size()], &cpus);
+  pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+#else
+  (void)thread;
+  (void)index;
+#endif
+}
+
+void *ThreadPool::workerMain(void *arg)
+{
+  Worker *worker = static_cast<Worker*>(arg);
+  ThreadPool &pool = *worker->pool;
+  unsigned long seen = worker->generation;
+
+  while (true)
+  {
+    Job *current;
+    int count;
+    {
+      ThreadLock lock(pool.mutex);
+      while (!pool.shutdown && (pool.generation == seen))
+        pthread_cond_wait(&pool.jobReady, &pool.mutex);
+      if (pool.shutdown) return NULL;
+      seen = pool.generation;
+      current = pool.job;
+      count = pool.threadCount;
+    }
+
+    bool failed = false;
+    try
+    {
+      current->execute(worker->index, count);
+    }
+    catch (...)
+    {
+      failed = true;
+    }
+
+    {
+      ThreadLock lock(pool.mutex);
+      if (failed) ++pool.failures;
+      if (--pool.pending == 0) pthread_cond_signal(&pool.jobDone);
+    }
+  }
+  return NULL;
+}
+
+void ThreadPool::run(Job &job_)
+{
+  if (pthread_mutex_trylock(&runMutex) != 0)
+  {
+    job_.execute(0, 1);
+    return;
+  }
+
+  {
+    ThreadLock lock(mutex);
+    job = &job_;
+    pending = threadCount - 1;
+    failures = 0;
+    ++generation;
+    pthread_cond_broadcast(&jobReady);
+  }
+
+  bool failed = false;
+  try
+  {
+    job_.execute(0, threadCount);
+  }
+  catch (...)
+  {
+    failed = true;
+  }
+
+  int workerFailures;
+  {
+    ThreadLock lock(mutex);
+    while (pending > 0)
+      pthread_cond_wait(&jobDone, &mutex);
+    job = NULL;
+    workerFailures = failures;
+  }
+  pthread_mutex_unlock(&runMutex);
+
+  if (failed || (workerFailures > 0))
+    SCHNECK_FAIL("ThreadPool: the job failed on " << (workerFailures + (failed ? 1 : 0)) << " threads");
+}
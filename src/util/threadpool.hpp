@@ -0,0 +1,171 @@
+/*
+ * threadpool.hpp
+ *
+ * Created on: 16 Oct 2026
+ * Author: Holger Schmitz
+ * Email: holger@notjustphysics.com
+ *
+ * Copyright 2026 Holger Schmitz
+ *
+ * This file is part of Schnek.
+ *
+ * Schnek is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Schnek is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Schnek.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SCHNEK_THREADPOOL_HPP_
+#define SCHNEK_THREADPOOL_HPP_
+
+#include "singleton.hpp"
+
+#include <vector>
+#include <pthread.h>
+
+namespace schnek {
+
+/** Returns true if the process was started by an MPI launcher
+ *
+ *  The launchers of Open MPI, MPICH and Intel MPI, and the PMI and PMIx
+ *  process managers, set environment variables in every process they start.
+ */
+bool isStartedByMpiLauncher();
+
+/** The default number of threads used by Schnek
+ *
+ *  The number is taken from the environment variable SCHNEK_NUM_THREADS.
+ *  If the variable is not set, a process started by an MPI launcher uses
+ *  a single thread, so that one rank per core does not oversubscribe the
+ *  machine. Otherwise the number of processors that the process may run
+ *  on is returned.
+ */
+int getDefaultThreadCount();
+
+/** Returns true if the environment variable SCHNEK_BIND_THREADS is set to a non-zero value */
+bool getDefaultThreadBinding();
+
+/** A process wide pool of worker threads
+ *
+ *  The workers are started once and wait for jobs. run() hands a job to
+ *  all workers and executes it on the calling thread as well. It returns
+ *  when every thread has finished the job.
+ *
+ *  The number of threads is initialised with getDefaultThreadCount(), which
+ *  reads the environment variable SCHNEK_NUM_THREADS. Without it, processes
+ *  started by an MPI launcher use a single thread and other processes use
+ *  all processors they may run on. With MPI, set SCHNEK_NUM_THREADS to the
+ *  number of cores available to each rank.
+ *
+ *  By default the operating system may move the threads between processors.
+ *  Memory that has been placed by a first-touch initialisation then stays
+ *  on the memory node of the processor that the thread ran on at the time.
+ *  With setThreadBinding(true), or SCHNEK_BIND_THREADS=1, thread t is bound
+ *  to the t-th processor that the process may run on, so that the threads
+ *  keep working on local memory.
+ */
+class ThreadPool : public Singleton<ThreadPool>
+{
+  public:
+    /** A job that is executed by all threads of the pool */
+    class Job
+    {
+      public:
+        virtual ~Job() {}
+
+        /** Called once by every thread
+         *
+         *  thread runs from 0 to threadCount-1. Thread 0 is the thread that
+         *  called run().
+         */
+        virtual void execute(int thread, int threadCount) = 0;
+    };
+
+  private:
+    friend class Singleton<ThreadPool>;
+    friend class CreateUsingNew<ThreadPool>;
+
+    struct Worker
+    {
+        ThreadPool *pool;
+        int index;
+        /// The last job generation before the worker was started
+        unsigned long generation;
+        pthread_t thread;
+    };
+
+    std::vector<Worker*> workers;
+    int threadCount;
+    /// True if the threads are bound to processors
+    bool binding;
+    /// The processors that the process may run on when the pool was created
+    std::vector<int> processors;
+    Job *job;
+    /// Incremented for every job so that workers can recognise a new job
+    unsigned long generation;
+    /// The number of workers that have not yet finished the current job
+    int pending;
+    bool shutdown;
+    /// The number of workers that failed with an exception in the current job
+    int failures;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t jobReady;
+    pthread_cond_t jobDone;
+    /// Held while a job is running, nested calls execute serially
+    pthread_mutex_t runMutex;
+
+    ThreadPool();
+    ~ThreadPool();
+
+    void startWorkers(int count);
+    void stopWorkers();
+
+    /** Bind a thread to the processor for thread index, or allow all processors if index is negative */
+    void setAffinity(pthread_t thread, int index);
+
+    static void *workerMain(void *arg);
+  public:
+    /** The number of threads that execute a job, including the calling thread */
+    int getThreadCount() const { return threadCount; }
+
+    /** Change the number of threads
+     *
+     *  Must not be called while a job is running.
+     */
+    void setThreadCount(int count);
+
+    /** Returns true if the threads are bound to processors */
+    bool getThreadBinding() const { return binding; }
+
+    /** Bind the threads to processors, or release them
+     *
+     *  Thread t is bound to the t-th processor that the process was allowed
+     *  to run on when the pool was created. The calling thread is bound as
+     *  thread 0, so it should be the thread that calls run(). The binding
+     *  only has an effect on systems that support thread affinities.
+     *  Must not be called while a job is running.
+     */
+    void setThreadBinding(bool bind);
+
+    /** Execute a job on all threads and wait for it to finish
+     *
+     *  If a job is already running, for example when run() is called from
+     *  inside a job, the job is executed by the calling thread alone.
+     *  Throws a ScheckException if the job throws on any thread.
+     */
+    void run(Job &job);
+};
+
+} // namespace schnek
+
+#endif // SCHNEK_THREADPOOL_HPP_
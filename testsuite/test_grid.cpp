@@ -6,6 +6,14 @@
  */
 
 #include <grid/grid.hpp>
+#include <grid/field.hpp>
+#include <grid/multicomponentgrid.hpp>
+#include <grid/domainsubdivision.hpp>
+#include <grid/reducedprecision.hpp>
+#include <grid/parallelfor.hpp>
+#include <grid/gridexpression.hpp>
+#include <grid/stencil.hpp>
+#include <grid/gridreduction.hpp>
 
 #include "utility.hpp"
 
@@ -17,6 +25,10 @@
 #include <boost/progress.hpp>
 
 #include <limits>
+#include <cmath>
+#include <stdexcept>
+#include <sched.h>
+#include <unistd.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -807,4 +819,1758 @@ BOOST_FIXTURE_TEST_CASE( grid_10d_Fortran_model, GridTest )
   }
 }
 
+BOOST_FIXTURE_TEST_CASE( grid_1d_aligned_model, GridTest )
+{
+  typedef schnek::Grid<double, 1, GridBoostTestCheck, schnek::AlignedArrayGridStorage> GridType;
+  GridType::IndexType lo, hi;
+  for (int n=0; n<3; ++n)
+  {
+    random_extent<1>(lo, hi);
+    GridType g(lo,hi);
+    test_access_1d(g);
+    for (int m=0; m<3; ++m)
+    {
+      random_extent<1>(lo, hi);
+      g.resize(lo,hi);
+      test_access_1d(g);
+    }
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_2d_aligned_model, GridTest )
+{
+  typedef schnek::Grid<double, 2, GridBoostTestCheck, schnek::AlignedArrayGridStorage> GridType;
+  GridType::IndexType lo, hi;
+  for (int n=0; n<3; ++n)
+  {
+    random_extent<2>(lo, hi);
+    GridType g(lo,hi);
+    test_access_2d(g);
+    for (int m=0; m<3; ++m)
+    {
+      random_extent<2>(lo, hi);
+      g.resize(lo,hi);
+      test_access_2d(g);
+    }
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_3d_aligned_model, GridTest )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::AlignedArrayGridStorage> GridType;
+  GridType::IndexType lo, hi;
+  for (int n=0; n<3; ++n)
+  {
+    random_extent<3>(lo, hi);
+    GridType g(lo,hi);
+    test_access_3d(g);
+    for (int m=0; m<3; ++m)
+    {
+      random_extent<3>(lo, hi);
+      g.resize(lo,hi);
+      test_access_3d(g);
+    }
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_3d_aligned_layout, GridTest )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::AlignedArrayGridStorage> GridType;
+  GridType::IndexType lo, hi;
+  for (int n=0; n<3; ++n)
+  {
+    random_extent<3>(lo, hi);
+    GridType g(lo,hi);
+
+    GridType::IndexType padded = g.getPaddedDims();
+    BOOST_CHECK_EQUAL(padded[2]*sizeof(double) % 64, 0);
+    BOOST_CHECK_GE(padded[2], g.getDims(2));
+
+    // every row starts on a cache line
+    for (int i=lo[0]; i<=hi[0]; ++i)
+      for (int j=lo[1]; j<=hi[1]; ++j)
+        BOOST_CHECK_EQUAL((size_t)(&g(i,j,lo[2])) % 64, 0);
+
+    // the storage iterators only visit the grid elements
+    g = 1.0;
+    int count = 0;
+    double sum_grid = 0.0;
+    GridType::storage_iterator it = g.begin();
+    GridType::storage_iterator end = g.end();
+    while (it != end)
+    {
+      sum_grid += *it;
+      ++count;
+      ++it;
+    }
+    BOOST_CHECK_EQUAL(count, g.getSize());
+    BOOST_CHECK(is_equal(sum_grid, g.getSize()));
+
+    GridType h(g);
+    BOOST_CHECK(is_equal(h(lo[0],lo[1],lo[2]), 1.0));
+    BOOST_CHECK(is_equal(h(hi[0],hi[1],hi[2]), 1.0));
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_3d_lazy_model, GridTest )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::LazyArrayGridStorage> GridType;
+  GridType::IndexType lo, hi;
+  for (int n=0; n<3; ++n)
+  {
+    random_extent<3>(lo, hi);
+    GridType g(lo,hi);
+    test_access_3d(g);
+    for (int m=0; m<3; ++m)
+    {
+      random_extent<3>(lo, hi);
+      g.resize(lo,hi);
+      test_access_3d(g);
+    }
+  }
+}
+
+template<class GridType>
+void test_large_offset()
+{
+  // the linear offset of the origin does not fit into an int
+  typename GridType::IndexType lo(-2000000, 0, 0), hi(-1999999, 1999, 1999);
+  GridType g(lo,hi);
+
+  BOOST_CHECK_EQUAL(g.getSize(), std::ptrdiff_t(8000000));
+  BOOST_CHECK(&g(lo[0],lo[1],lo[2]) == g.getRawData());
+  BOOST_CHECK(&g(hi[0],hi[1],hi[2]) == g.getRawData() + g.getSize() - 1);
+
+  g(lo[0],lo[1],lo[2]) = 1;
+  g(hi[0],hi[1],hi[2]) = 2;
+  BOOST_CHECK_EQUAL(int(g.getRawData()[0]), 1);
+  BOOST_CHECK_EQUAL(int(g.getRawData()[g.getSize() - 1]), 2);
+}
+
+BOOST_AUTO_TEST_CASE( grid_large_offset )
+{
+  test_large_offset<schnek::Grid<char, 3, GridBoostTestCheck> >();
+  test_large_offset<schnek::Grid<char, 3, GridBoostTestCheck, schnek::LazyArrayGridStorage> >();
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_3d_first_touch_model, GridTest )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::FirstTouchArrayGridStorage> GridType;
+  GridType::IndexType lo, hi;
+  for (int n=0; n<3; ++n)
+  {
+    random_extent<3>(lo, hi);
+    GridType g(lo,hi);
+    test_access_3d(g);
+    for (int m=0; m<3; ++m)
+    {
+      random_extent<3>(lo, hi);
+      g.resize(lo,hi);
+      test_access_3d(g);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( static_partition )
+{
+  for (int count=1; count<=9; ++count)
+  {
+    schnek::StaticPartition partition(-3, 13, count);
+    BOOST_CHECK_EQUAL(partition.getCount(), std::min(count, 17));
+    BOOST_CHECK_EQUAL(partition.getLo(0), -3);
+    BOOST_CHECK_EQUAL(partition.getHi(partition.getCount()-1), 13);
+    for (int t=1; t<partition.getCount(); ++t)
+    {
+      BOOST_CHECK_EQUAL(partition.getLo(t), partition.getHi(t-1) + 1);
+      int diff = (partition.getHi(t) - partition.getLo(t)) - (partition.getHi(0) - partition.getLo(0));
+      BOOST_CHECK(diff == 0 || diff == -1);
+    }
+  }
+  BOOST_CHECK_EQUAL(schnek::StaticPartition(0, 2, 8).getCount(), 3);
+}
+
+BOOST_AUTO_TEST_CASE( grid_first_touch_initialised )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::FirstTouchArrayGridStorage> GridType;
+  GridType g;
+  g.setNumThreads(4);
+  g.resize(GridType::IndexType(-5,0,3), GridType::IndexType(17,20,40));
+  BOOST_CHECK_EQUAL(g.getPartition().getCount(), 4);
+
+  int nonZero = 0;
+  for (GridType::storage_iterator it = g.begin(); it != g.end(); ++it)
+    if (*it != 0.0) ++nonZero;
+  BOOST_CHECK_EQUAL(nonZero, 0);
+}
+
+BOOST_AUTO_TEST_CASE( grid_first_touch_empty )
+{
+  typedef schnek::Grid<double, 2, GridBoostTestCheck, schnek::FirstTouchArrayGridStorage> GridType;
+  GridType g(GridType::IndexType(0,0), GridType::IndexType(-1,5));
+  BOOST_CHECK_EQUAL(g.getSize(), 0);
+  BOOST_CHECK(g.begin() == g.end());
+
+  g.resize(GridType::IndexType(0,0), GridType::IndexType(3,5));
+  g = 1.0;
+  BOOST_CHECK_EQUAL(g(3,5), 1.0);
+}
+
+BOOST_AUTO_TEST_CASE( grid_aligned_empty )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::AlignedArrayGridStorage> GridType;
+  GridType g(GridType::IndexType(0,0,0), GridType::IndexType(3,3,-1));
+  BOOST_CHECK_EQUAL(g.getSize(), 0);
+  BOOST_CHECK(g.begin() == g.end());
+
+  g.resize(GridType::IndexType(0,0,0), GridType::IndexType(3,3,5));
+  g = 1.0;
+  BOOST_CHECK_EQUAL(g(3,3,5), 1.0);
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_3d_huge_page_model, GridTest )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::HugePageArrayGridStorage> GridType;
+  GridType::IndexType lo, hi;
+  for (int n=0; n<3; ++n)
+  {
+    random_extent<3>(lo, hi);
+    GridType g(lo,hi);
+    test_access_3d(g);
+    for (int m=0; m<3; ++m)
+    {
+      random_extent<3>(lo, hi);
+      g.resize(lo,hi);
+      test_access_3d(g);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( grid_huge_page_mapping )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::HugePageArrayGridStorage> GridType;
+  const std::size_t hugePageSize = GridType::hugePageSize;
+
+  GridType g(GridType::IndexType(-10,0,5), GridType::IndexType(90,100,105));
+  BOOST_CHECK_EQUAL((size_t)g.getRawData() % hugePageSize, 0);
+  BOOST_CHECK(g.getPageSize() == hugePageSize || g.getPageSize() == (size_t)sysconf(_SC_PAGESIZE));
+
+  double sum = 0.0;
+  for (GridType::storage_iterator it = g.begin(); it != g.end(); ++it) sum += *it;
+  BOOST_CHECK_EQUAL(sum, 0.0);
+
+  g.resize(GridType::IndexType(0,0,0), GridType::IndexType(1,1,1));
+  BOOST_CHECK_EQUAL((size_t)g.getRawData() % hugePageSize, 0);
+  g = 2.0;
+  BOOST_CHECK_EQUAL(g(1,1,1), 2.0);
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_3d_mapped_model, GridTest )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::MappedGridStorage> GridType;
+  GridType::IndexType lo, hi;
+  for (int n=0; n<3; ++n)
+  {
+    random_extent<3>(lo, hi);
+    GridType g(lo,hi);
+    test_access_3d(g);
+    for (int m=0; m<3; ++m)
+    {
+      random_extent<3>(lo, hi);
+      g.resize(lo,hi);
+      test_access_3d(g);
+    }
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_mapped_file, GridTest )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::MappedGridStorage> GridType;
+  char fileName[] = "/tmp/schnek_test_gridXXXXXX";
+  int fd = mkstemp(fileName);
+  BOOST_REQUIRE(fd >= 0);
+  close(fd);
+
+  GridType::IndexType lo(-3,2,-7), hi(12,20,9);
+  {
+    GridType g;
+    g.mapFile(fileName, lo, hi);
+    BOOST_CHECK(g.isMapped());
+    BOOST_CHECK_EQUAL(g(lo[0],lo[1],lo[2]), 0.0);
+    for (int i=lo[0]; i<=hi[0]; ++i)
+      for (int j=lo[1]; j<=hi[1]; ++j)
+        for (int k=lo[2]; k<=hi[2]; ++k)
+          g(i,j,k) = i + 100*j + 10000*k;
+    g.sync();
+  }
+
+  GridType h;
+  h.mapFile(fileName);
+  BOOST_CHECK(h.getLo() == lo);
+  BOOST_CHECK(h.getHi() == hi);
+  bool equal = true;
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+        if (h(i,j,k) != i + 100*j + 10000*k) equal = false;
+  BOOST_CHECK(equal);
+  h.unmap();
+  BOOST_CHECK(!h.isMapped());
+  BOOST_CHECK_EQUAL(h.getSize(), 0);
+
+  schnek::Grid<float, 3, GridBoostTestCheck, schnek::MappedGridStorage> wrongType;
+  BOOST_CHECK_THROW(wrongType.mapFile(fileName), schnek::ScheckException);
+  schnek::Grid<double, 2, GridBoostTestCheck, schnek::MappedGridStorage> wrongRank;
+  BOOST_CHECK_THROW(wrongRank.mapFile(fileName), schnek::ScheckException);
+
+  unlink(fileName);
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_2d_tiled_model, GridTest )
+{
+  typedef schnek::Grid<double, 2, GridBoostTestCheck, schnek::TiledArrayGridStorage> GridType;
+  GridType::IndexType lo, hi;
+  for (int n=0; n<3; ++n)
+  {
+    random_extent<2>(lo, hi);
+    GridType g(lo,hi);
+    test_access_2d(g);
+    for (int m=0; m<3; ++m)
+    {
+      random_extent<2>(lo, hi);
+      g.resize(lo,hi);
+      test_access_2d(g);
+    }
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_3d_tiled_model, GridTest )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::TiledArrayGridStorage> GridType;
+  GridType::IndexType lo, hi;
+  for (int n=0; n<3; ++n)
+  {
+    random_extent<3>(lo, hi);
+    GridType g(lo,hi);
+    test_access_3d(g);
+    for (int m=0; m<3; ++m)
+    {
+      random_extent<3>(lo, hi);
+      g.resize(lo,hi);
+      test_access_3d(g);
+    }
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_4d_tiled_bricks, GridTest )
+{
+  typedef schnek::Grid<int, 4, GridBoostTestCheck, schnek::TiledArrayGridStorage> GridType;
+  typedef GridType::RangeType RangeType;
+  GridType::IndexType lo(-1,3,-9,0), hi(1,21,4,17);
+  GridType g(lo,hi);
+  g = 0;
+
+  // every cell is covered by exactly one brick
+  std::ptrdiff_t cells = 0;
+  for (std::ptrdiff_t b=0; b<g.getBrickCount(); ++b)
+  {
+    RangeType range = g.getBrickRange(b);
+    int *brickData = g.getBrickData(b);
+    RangeType::iterator end = range.end();
+    for (RangeType::iterator it = range.begin(); it != end; ++it)
+    {
+      RangeType::LimitType pos = *it;
+      int offset = ((pos[1] - range.getLo()[1])*GridType::brickEdge
+          + (pos[2] - range.getLo()[2]))*GridType::brickEdge + (pos[3] - range.getLo()[3]);
+      BOOST_CHECK_EQUAL(&g[pos], brickData + offset);
+      g[pos] += 1;
+      ++cells;
+    }
+  }
+  BOOST_CHECK_EQUAL(cells, g.getSize());
+
+  // the storage iterators visit every cell once and skip the padding
+  int count = 0;
+  bool allOne = true;
+  for (GridType::storage_iterator it = g.begin(); it != g.end(); ++it)
+  {
+    if (*it != 1) allOne = false;
+    ++count;
+  }
+  BOOST_CHECK(allOne);
+  BOOST_CHECK_EQUAL(count, g.getSize());
+}
+
+template<class GridType>
+void test_swap_move()
+{
+  typename GridType::IndexType loA(-2,0,3), hiA(5,7,9), loB(0,0,0), hiB(3,3,3);
+  GridType a(loA, hiA), b(loB, hiB);
+  a = 1.0;
+  b = 2.0;
+  double *dataA = &a(loA[0],loA[1],loA[2]);
+  double *dataB = &b(loB[0],loB[1],loB[2]);
+
+  a.swap(b);
+  BOOST_CHECK(a.getLo() == loB);
+  BOOST_CHECK(a.getHi() == hiB);
+  BOOST_CHECK(b.getLo() == loA);
+  BOOST_CHECK(b.getHi() == hiA);
+  BOOST_CHECK_EQUAL(&a(loB[0],loB[1],loB[2]), dataB);
+  BOOST_CHECK_EQUAL(&b(loA[0],loA[1],loA[2]), dataA);
+  BOOST_CHECK_EQUAL(a(hiB[0],hiB[1],hiB[2]), 2.0);
+  BOOST_CHECK_EQUAL(b(hiA[0],hiA[1],hiA[2]), 1.0);
+
+#if __cplusplus >= 201103L
+  GridType c(std::move(b));
+  BOOST_CHECK(c.getLo() == loA);
+  BOOST_CHECK_EQUAL(&c(loA[0],loA[1],loA[2]), dataA);
+  BOOST_CHECK_EQUAL(b.getSize(), 0);
+
+  b = std::move(c);
+  BOOST_CHECK(b.getHi() == hiA);
+  BOOST_CHECK_EQUAL(&b(loA[0],loA[1],loA[2]), dataA);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE( grid_swap_move )
+{
+  test_swap_move<schnek::Grid<double, 3, GridBoostTestCheck> >();
+  test_swap_move<schnek::Grid<double, 3, GridBoostTestCheck, schnek::LazyArrayGridStorage> >();
+  test_swap_move<schnek::Grid<double, 3, GridBoostTestCheck, schnek::PooledArrayGridStorage> >();
+  test_swap_move<schnek::Grid<double, 3, GridBoostTestCheck, schnek::AlignedArrayGridStorage> >();
+  test_swap_move<schnek::Grid<double, 3, GridBoostTestCheck, schnek::TiledArrayGridStorage> >();
+  test_swap_move<schnek::Grid<double, 3, GridBoostTestCheck, schnek::MappedGridStorage> >();
+  test_swap_move<schnek::Grid<double, 3, GridBoostTestCheck, schnek::SparseTiledGridStorage> >();
+}
+
+BOOST_AUTO_TEST_CASE( field_swap_move )
+{
+  typedef schnek::Field<double, 2, GridBoostTestCheck> FieldType;
+  FieldType::IndexType lo(0,0), hi(9,9);
+  FieldType::RangeType rangeA(FieldType::RangeLimit(0.0,0.0), FieldType::RangeLimit(1.0,1.0));
+  FieldType::RangeType rangeB(FieldType::RangeLimit(0.0,0.0), FieldType::RangeLimit(2.0,2.0));
+  FieldType::Stagger staggerA(false,false), staggerB(true,false);
+
+  FieldType a(lo, hi, rangeA, staggerA, 1), b(lo, hi, rangeB, staggerB, 2);
+  a = 1.0;
+  b = 2.0;
+  a.swap(b);
+  BOOST_CHECK_EQUAL(a(3,3), 2.0);
+  BOOST_CHECK_EQUAL(b(3,3), 1.0);
+  BOOST_CHECK(a.getStagger(0));
+  BOOST_CHECK(!b.getStagger(0));
+  BOOST_CHECK_EQUAL(a.positionToIndex(0, 1.0), 4);
+  BOOST_CHECK_EQUAL(b.positionToIndex(0, 1.0), 10);
+
+#if __cplusplus >= 201103L
+  FieldType c(std::move(a));
+  BOOST_CHECK_EQUAL(c(3,3), 2.0);
+  BOOST_CHECK(c.getStagger(0));
+  BOOST_CHECK_EQUAL(c.positionToIndex(0, 1.0), 4);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE( grid_ring_rotate )
+{
+  typedef schnek::Grid<double, 1, GridBoostTestCheck> GridType;
+  GridType::IndexType lo(0), hi(9);
+  GridType g0(lo, hi), g1(lo, hi), g2(lo, hi);
+  g0 = 0.0;
+  g1 = 1.0;
+  g2 = 2.0;
+  double *data0 = g0.getRawData();
+  double *data1 = g1.getRawData();
+  double *data2 = g2.getRawData();
+
+  schnek::GridRing<GridType> ring;
+  ring.add(g0);
+  ring.add(g1);
+  ring.add(g2);
+  BOOST_CHECK_EQUAL(ring.getSize(), 3);
+
+  ring.rotate();
+  BOOST_CHECK_EQUAL(g0.getRawData(), data1);
+  BOOST_CHECK_EQUAL(g1.getRawData(), data2);
+  BOOST_CHECK_EQUAL(g2.getRawData(), data0);
+  BOOST_CHECK_EQUAL(g0(5), 1.0);
+  BOOST_CHECK_EQUAL(g1(5), 2.0);
+  BOOST_CHECK_EQUAL(ring[2](5), 0.0);
+}
+
+template<class GridType>
+void test_shift_translate()
+{
+  typedef typename GridType::IndexType IndexType;
+  IndexType lo(-3,2,-1), hi(6,9,11);
+  GridType g(lo,hi);
+  const int distances[] = {1, -2, 4, -11, 15};
+
+  for (int dim=0; dim<3; ++dim)
+    for (int n=0; n<5; ++n)
+    {
+      int distance = distances[n];
+      for (int i=lo[0]; i<=hi[0]; ++i)
+        for (int j=lo[1]; j<=hi[1]; ++j)
+          for (int k=lo[2]; k<=hi[2]; ++k)
+            g(i,j,k) = 1 + i + 100*j + 10000*k;
+
+      g.shift(dim, distance);
+
+      bool correct = true;
+      for (int i=lo[0]; i<=hi[0]; ++i)
+        for (int j=lo[1]; j<=hi[1]; ++j)
+          for (int k=lo[2]; k<=hi[2]; ++k)
+          {
+            IndexType src(i,j,k);
+            src[dim] += distance;
+            double expected = 0.0;
+            if ((src[dim] >= lo[dim]) && (src[dim] <= hi[dim]))
+              expected = 1 + src[0] + 100*src[1] + 10000*src[2];
+            if (g(i,j,k) != expected) correct = false;
+          }
+      BOOST_CHECK(correct);
+    }
+
+  g(lo[0],lo[1],lo[2]) = 1.0;
+  g(hi[0],hi[1],hi[2]) = 2.0;
+  IndexType offset(5,-7,100);
+  g.translate(offset);
+  BOOST_CHECK_EQUAL(g.getLo()[0], lo[0]+5);
+  BOOST_CHECK_EQUAL(g.getHi()[2], hi[2]+100);
+  BOOST_CHECK_EQUAL(g(lo[0]+5,lo[1]-7,lo[2]+100), 1.0);
+  BOOST_CHECK_EQUAL(g(hi[0]+5,hi[1]-7,hi[2]+100), 2.0);
+}
+
+BOOST_AUTO_TEST_CASE( grid_shift_translate )
+{
+  test_shift_translate<schnek::Grid<double, 3, GridBoostTestCheck> >();
+  test_shift_translate<schnek::Grid<double, 3, GridBoostTestCheck, schnek::SingleArrayGridStorageFortran> >();
+  test_shift_translate<schnek::Grid<double, 3, GridBoostTestCheck, schnek::LazyArrayGridStorage> >();
+  test_shift_translate<schnek::Grid<double, 3, GridBoostTestCheck, schnek::PooledArrayGridStorage> >();
+  test_shift_translate<schnek::Grid<double, 3, GridBoostTestCheck, schnek::AlignedArrayGridStorage> >();
+  test_shift_translate<schnek::Grid<double, 3, GridBoostTestCheck, schnek::TiledArrayGridStorage> >();
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_3d_pooled_model, GridTest )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::PooledArrayGridStorage> GridType;
+  GridType::IndexType lo, hi;
+  for (int n=0; n<3; ++n)
+  {
+    random_extent<3>(lo, hi);
+    GridType g(lo,hi);
+    test_access_3d(g);
+    for (int m=0; m<3; ++m)
+    {
+      random_extent<3>(lo, hi);
+      g.resize(lo,hi);
+      test_access_3d(g);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( memory_pool_reuse )
+{
+  typedef schnek::Grid<double, 2, GridBoostTestCheck, schnek::PooledArrayGridStorage> GridType;
+  schnek::MemoryPool &pool = schnek::MemoryPool::instance();
+
+  BOOST_CHECK_EQUAL(schnek::MemoryPool::getBlockSize(1), schnek::MemoryPool::minBlockSize);
+  BOOST_CHECK_EQUAL(schnek::MemoryPool::getBlockSize(1000), (size_t)1024);
+  BOOST_CHECK_EQUAL(schnek::MemoryPool::getBlockSize(1024), (size_t)1024);
+
+  // large blocks are at most one eighth larger than the request
+  const size_t threshold = schnek::MemoryPool::fineClassThreshold;
+  BOOST_CHECK_EQUAL(schnek::MemoryPool::getBlockSize(threshold), threshold);
+  BOOST_CHECK_EQUAL(schnek::MemoryPool::getBlockSize(threshold + 1), threshold + threshold/8);
+  BOOST_CHECK_EQUAL(schnek::MemoryPool::getBlockSize(2*threshold), 2*threshold);
+  BOOST_CHECK_EQUAL(schnek::MemoryPool::getBlockSize(2*threshold + 1), 2*threshold + threshold/4);
+  for (size_t bytes = threshold + 12345; bytes < 4000*threshold; bytes = 3*bytes + 7)
+  {
+    size_t blockSize = schnek::MemoryPool::getBlockSize(bytes);
+    BOOST_CHECK(blockSize >= bytes);
+    BOOST_CHECK(8*blockSize <= 9*bytes);
+    BOOST_CHECK_EQUAL(schnek::MemoryPool::getBlockSize(blockSize), blockSize);
+  }
+
+  pool.trim();
+  pool.resetStatistics();
+  schnek::MemoryPool::Statistics before = pool.getStatistics();
+
+  {
+    GridType a(GridType::IndexType(0,0), GridType::IndexType(99,99));
+    BOOST_CHECK_EQUAL((size_t)a.getRawData() % schnek::MemoryPool::alignment, 0);
+  }
+  schnek::MemoryPool::Statistics stats = pool.getStatistics();
+  BOOST_CHECK_EQUAL(stats.requests, (size_t)1);
+  BOOST_CHECK_EQUAL(stats.hits, (size_t)0);
+  BOOST_CHECK_EQUAL(stats.bytesInUse, before.bytesInUse);
+  BOOST_CHECK(stats.bytesCached >= 10000*sizeof(double));
+  BOOST_CHECK(stats.peakBytesInUse >= before.bytesInUse + stats.bytesCached);
+
+  // every further grid of the same size is served from the free list
+  for (int n=0; n<10; ++n)
+  {
+    GridType b(GridType::IndexType(0,0), GridType::IndexType(99,99));
+    b(50,50) = n;
+  }
+  stats = pool.getStatistics();
+  BOOST_CHECK_EQUAL(stats.requests, (size_t)11);
+  BOOST_CHECK_EQUAL(stats.hits, (size_t)10);
+  BOOST_CHECK_CLOSE(stats.getHitRate(), 10.0/11.0, 1e-9);
+
+  // blocks that do not fit into the cache limit are freed
+  size_t limit = pool.getCacheLimit();
+  pool.setCacheLimit(0);
+  BOOST_CHECK_EQUAL(pool.getStatistics().bytesCached, (size_t)0);
+  {
+    GridType c(GridType::IndexType(0,0), GridType::IndexType(99,99));
+    c(50,50) = 1.0;
+  }
+  BOOST_CHECK_EQUAL(pool.getStatistics().bytesCached, (size_t)0);
+  BOOST_CHECK_EQUAL(pool.getStatistics().bytesInUse, before.bytesInUse);
+  pool.setCacheLimit(limit);
+
+  {
+    GridType c(GridType::IndexType(0,0), GridType::IndexType(99,99));
+    c(50,50) = 1.0;
+  }
+  BOOST_CHECK(pool.getStatistics().bytesCached > 0);
+  pool.trim();
+  BOOST_CHECK_EQUAL(pool.getStatistics().bytesCached, (size_t)0);
+}
+
+template<class GridType>
+void test_multi_component(std::ptrdiff_t componentStride)
+{
+  typedef typename GridType::SpatialIndexType IndexType;
+  IndexType lo(-2,3), hi(5,9);
+  GridType g(lo, hi);
+
+  for (int c=0; c<3; ++c)
+    for (int i=lo[0]; i<=hi[0]; ++i)
+      for (int j=lo[1]; j<=hi[1]; ++j)
+        g(c, IndexType(i,j)) = c + 10*i + 1000*j;
+
+  bool correct = true;
+  for (int c=0; c<3; ++c)
+  {
+    BOOST_CHECK_EQUAL(g.component(c).getLo()[0], lo[0]);
+    BOOST_CHECK_EQUAL(g.component(c).getHi()[1], hi[1]);
+    for (int i=lo[0]; i<=hi[0]; ++i)
+      for (int j=lo[1]; j<=hi[1]; ++j)
+        if (g.component(c)(i,j) != c + 10*i + 1000*j) correct = false;
+  }
+  BOOST_CHECK(correct);
+  BOOST_CHECK_EQUAL(&g(1, lo) - &g(0, lo), componentStride);
+
+  // writing through a view changes the grid
+  g.component(2) = 7.0;
+  BOOST_CHECK_EQUAL(g(2, hi), 7.0);
+  BOOST_CHECK_EQUAL(g(1, hi), 1 + 10*hi[0] + 1000*hi[1]);
+
+  // the views of a copy refer to the copied data
+  GridType h(g);
+  h.component(0)(lo[0], lo[1]) = -1.0;
+  BOOST_CHECK_EQUAL(h(0, lo), -1.0);
+  BOOST_CHECK_EQUAL(g(0, lo), 10*lo[0] + 1000*lo[1]);
+}
+
+BOOST_AUTO_TEST_CASE( multi_component_layout )
+{
+  test_multi_component<schnek::MultiComponentGrid<double, 2, 3, schnek::ComponentMajor, GridBoostTestCheck> >(8*7);
+  test_multi_component<schnek::MultiComponentGrid<double, 2, 3, schnek::ComponentInterleaved, GridBoostTestCheck> >(1);
+
+  // the views follow the strides of the storage
+  test_multi_component<schnek::MultiComponentGrid<double, 2, 3, schnek::ComponentMajor, GridBoostTestCheck,
+                                                  schnek::AlignedArrayGridStorage> >(8*8);
+  test_multi_component<schnek::MultiComponentGrid<double, 2, 3, schnek::ComponentInterleaved, GridBoostTestCheck,
+                                                  schnek::AlignedArrayGridStorage> >(1);
+  test_multi_component<schnek::MultiComponentGrid<double, 2, 3, schnek::ComponentMajor, GridBoostTestCheck,
+                                                  schnek::SingleArrayGridStorageFortran> >(1);
+  test_multi_component<schnek::MultiComponentGrid<double, 2, 3, schnek::ComponentInterleaved, GridBoostTestCheck,
+                                                  schnek::SingleArrayGridStorageFortran> >(8*7);
+}
+
+template<class GridType>
+void test_multi_component_exchange()
+{
+  typedef schnek::Grid<double, 2> ComponentGridType;
+  typedef typename GridType::SpatialIndexType IndexType;
+  schnek::SerialSubdivision<ComponentGridType> sub;
+  sub.init(IndexType(-2,-2), IndexType(9,12), 2);
+
+  GridType g(sub.getLo(), sub.getHi());
+  ComponentGridType reference[3];
+  for (int c=0; c<3; ++c)
+  {
+    reference[c].resize(sub.getLo(), sub.getHi());
+    for (int i=sub.getLo()[0]; i<=sub.getHi()[0]; ++i)
+      for (int j=sub.getLo()[1]; j<=sub.getHi()[1]; ++j)
+        reference[c](i,j) = g(c, IndexType(i,j)) = c + 10*i + 1000*j;
+    sub.exchange(reference[c]);
+  }
+  schnek::HaloExchangeBatch<2> batch;
+  batch.addComponents(g);
+  sub.exchange(batch);
+
+  bool correct = true;
+  for (int c=0; c<3; ++c)
+    for (int i=sub.getLo()[0]; i<=sub.getHi()[0]; ++i)
+      for (int j=sub.getLo()[1]; j<=sub.getHi()[1]; ++j)
+        if (g(c, IndexType(i,j)) != reference[c](i,j)) correct = false;
+  BOOST_CHECK(correct);
+  BOOST_CHECK_EQUAL(g(1, IndexType(-2,0)), reference[1](6,0));
+}
+
+BOOST_AUTO_TEST_CASE( multi_component_exchange )
+{
+  test_multi_component_exchange<schnek::MultiComponentGrid<double, 2, 3, schnek::ComponentMajor> >();
+  test_multi_component_exchange<schnek::MultiComponentGrid<double, 2, 3, schnek::ComponentInterleaved> >();
+}
+
+BOOST_FIXTURE_TEST_CASE( grid_3d_sparse_model, GridTest )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::SparseTiledGridStorage> GridType;
+  GridType::IndexType lo, hi;
+  for (int n=0; n<3; ++n)
+  {
+    random_extent<3>(lo, hi);
+    GridType g(lo,hi);
+    test_access_3d(g);
+    for (int m=0; m<3; ++m)
+    {
+      random_extent<3>(lo, hi);
+      g.resize(lo,hi);
+      test_access_3d(g);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( grid_sparse_tiles )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::SparseTiledGridStorage> GridType;
+  typedef GridType::RangeType RangeType;
+  GridType::IndexType lo(-4,0,3), hi(35,20,30);
+  GridType g(lo,hi);
+  g.setFillValue(-1.0);
+  const GridType &cg = g;
+
+  // 5 x 3 x 4 tiles, none of them allocated
+  BOOST_CHECK_EQUAL(g.getTileCount(), 60);
+  BOOST_CHECK_EQUAL(cg(10,10,10), -1.0);
+  BOOST_CHECK_EQUAL(g.getAllocatedTileCount(), 0);
+
+  g(10,10,10) = 2.0;
+  g(11,11,10) = 3.0;
+  g(35,20,30) = 4.0;
+  BOOST_CHECK_EQUAL(g.getAllocatedTileCount(), 2);
+  BOOST_CHECK_EQUAL(cg(10,10,10), 2.0);
+  BOOST_CHECK_EQUAL(cg(12,10,10), -1.0);
+  BOOST_CHECK_EQUAL(cg(34,20,30), -1.0);
+
+  // the allocated tiles cover the written cells
+  double sum = 0.0;
+  int cells = 0;
+  for (std::ptrdiff_t t=0; t<g.getTileCount(); ++t)
+  {
+    if (!g.isTileAllocated(t)) continue;
+    RangeType range = g.getTileRange(t);
+    RangeType::iterator end = range.end();
+    for (RangeType::iterator it = range.begin(); it != end; ++it)
+    {
+      if (cg[*it] > 0.0) sum += cg[*it];
+      ++cells;
+    }
+  }
+  BOOST_CHECK_EQUAL(sum, 9.0);
+  BOOST_CHECK_EQUAL(cells, 8*8*8 + 8*5*4);
+
+  // the const iterators visit every cell without allocating
+  int count = 0;
+  sum = 0.0;
+  for (GridType::const_storage_iterator it = cg.cbegin(); it != cg.cend(); ++it)
+  {
+    sum += *it;
+    ++count;
+  }
+  BOOST_CHECK_EQUAL(count, g.getSize());
+  BOOST_CHECK_EQUAL(sum, 9.0 - (g.getSize() - 3));
+  BOOST_CHECK_EQUAL(g.getAllocatedTileCount(), 2);
+
+  g(35,20,30) = -1.0;
+  g.releaseUniformTiles();
+  BOOST_CHECK_EQUAL(g.getAllocatedTileCount(), 1);
+  BOOST_CHECK_EQUAL(cg(10,10,10), 2.0);
+
+  g.clear();
+  BOOST_CHECK_EQUAL(g.getAllocatedTileCount(), 0);
+  BOOST_CHECK_EQUAL(cg(10,10,10), -1.0);
+}
+
+BOOST_AUTO_TEST_CASE( grid_external_storage )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::ExternalArrayGridStorageFortran> FortranGrid;
+  typedef FortranGrid::IndexType IndexType;
+  IndexType lo(-1,2,0), hi(4,5,2);
+  std::vector<double> buffer(6*4*3, 0.0);
+
+  FortranGrid f;
+  f.adopt(&buffer[0], lo, hi);
+  BOOST_CHECK(f.isAttached());
+  BOOST_CHECK_EQUAL(f.getRawData(), &buffer[0]);
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+        f(i,j,k) = i + 10*j + 100*k;
+  BOOST_CHECK_EQUAL(buffer[(3+1) + 6*((4-2) + 4*1)], 3 + 40 + 100);
+
+  // a sub grid writes directly into the external array
+  schnek::SubGrid<FortranGrid> sub(IndexType(0,3,1), IndexType(1,4,1), f);
+  for (int i=0; i<=1; ++i)
+    for (int j=3; j<=4; ++j)
+      sub(i,j,1) = -1.0;
+  BOOST_CHECK_EQUAL(buffer[(1+1) + 6*((4-2) + 4*1)], -1.0);
+  BOOST_CHECK_EQUAL(buffer[(2+1) + 6*((4-2) + 4*1)], 2 + 40 + 100);
+
+  // the grid can be resized within the external array
+  f.resize(IndexType(0,0,0), IndexType(3,3,3));
+  BOOST_CHECK_EQUAL(&f(3,3,3), &buffer[63]);
+  BOOST_CHECK_THROW(f.resize(IndexType(0,0,0), IndexType(7,7,7)), schnek::ScheckException);
+
+  // boundary exchange works on the external array
+  typedef schnek::Grid<double, 2, GridBoostTestCheck, schnek::ExternalArrayGridStorage> CGrid;
+  typedef CGrid::IndexType CIndexType;
+  schnek::SerialSubdivision<CGrid> subdivision;
+  subdivision.init(CIndexType(0,0), CIndexType(7,5), 1);
+  std::vector<double> cbuffer(8*6);
+  CGrid c(subdivision.getLo(), subdivision.getHi());
+  BOOST_CHECK(!c.isAttached());
+  c.adopt(&cbuffer[0]);
+  for (int i=0; i<=7; ++i)
+    for (int j=0; j<=5; ++j)
+      c(i,j) = i + 10*j;
+  subdivision.exchange(c);
+  BOOST_CHECK_EQUAL(cbuffer[0*6 + 2], 6 + 20);
+  BOOST_CHECK_EQUAL(cbuffer[7*6 + 5], 1 + 10);
+
+  c.release();
+  BOOST_CHECK(!c.isAttached());
+  BOOST_CHECK_EQUAL(cbuffer[3*6 + 3], 3 + 30);
+}
+
+BOOST_AUTO_TEST_CASE( grid_reduced_precision )
+{
+  using schnek::Half;
+  using schnek::BFloat16;
+  BOOST_CHECK_EQUAL(sizeof(Half), 2);
+  BOOST_CHECK_EQUAL(sizeof(BFloat16), 2);
+
+  // exact values, rounding to nearest even, overflow and subnormals
+  BOOST_CHECK_EQUAL(Half(1.0).getBits(), 0x3c00);
+  BOOST_CHECK_EQUAL(Half(-2.5).getBits(), 0xc100);
+  BOOST_CHECK_EQUAL(Half(65504.0).getBits(), 0x7bff);
+  BOOST_CHECK_EQUAL(Half(65520.0).getBits(), 0x7c00);
+  BOOST_CHECK_EQUAL(Half(1.0 + 1.0/2048.0).getBits(), 0x3c00);
+  BOOST_CHECK_EQUAL(Half(1.0 + 3.0/2048.0).getBits(), 0x3c02);
+  BOOST_CHECK_EQUAL(Half(std::ldexp(1.0, -24)).getBits(), 0x0001);
+  BOOST_CHECK_EQUAL(Half(std::ldexp(1.0, -25)).getBits(), 0x0000);
+  BOOST_CHECK_EQUAL(float(Half::fromBits(0x0001)), std::ldexp(1.0f, -24));
+  BOOST_CHECK_EQUAL(float(Half::fromBits(0x03ff)), std::ldexp(1023.0f, -24));
+  BOOST_CHECK(float(Half(std::numeric_limits<float>::quiet_NaN())) != float(Half(0.0)));
+  BOOST_CHECK_EQUAL(BFloat16(1.0).getBits(), 0x3f80);
+  BOOST_CHECK_EQUAL(BFloat16(1.0 + 1.0/256.0).getBits(), 0x3f80);
+  BOOST_CHECK_EQUAL(BFloat16(1.0 + 3.0/256.0).getBits(), 0x3f82);
+  BOOST_CHECK_EQUAL(float(BFloat16(1e30)), float(BFloat16::fromBits(BFloat16(1e30).getBits())));
+
+  // doubles just above a tie are rounded once, not through float to the tie
+  double aboveTie = std::ldexp(1.0, -40);
+  BOOST_CHECK_EQUAL(Half(1.0 + 1.0/2048.0 + aboveTie).getBits(), 0x3c01);
+  BOOST_CHECK_EQUAL(Half(-1.0 - 1.0/2048.0 - aboveTie).getBits(), 0xbc01);
+  BOOST_CHECK_EQUAL(BFloat16(1.0 + 1.0/256.0 + aboveTie).getBits(), 0x3f81);
+  BOOST_CHECK_EQUAL(BFloat16((1 << 24) + (1 << 16) + 1).getBits(), 0x4b81);
+  BOOST_CHECK_EQUAL(Half(1e300).getBits(), 0x7c00);
+  BOOST_CHECK_EQUAL(BFloat16(-1e300).getBits(), 0xff80);
+
+  // every half precision number survives the round trip through float
+  for (int b=0; b<0x10000; ++b)
+  {
+    Half h = Half::fromBits(b);
+    if ((b & 0x7c00) == 0x7c00 && (b & 0x3ff) != 0) continue;
+    BOOST_REQUIRE_EQUAL(Half(float(h)).getBits(), b);
+  }
+
+  // grids of compact values convert on access
+  typedef schnek::Grid<Half, 3, GridBoostTestCheck> HalfGrid;
+  typedef schnek::Grid<double, 3, GridBoostTestCheck> DoubleGrid;
+  HalfGrid::IndexType lo(-2,0,1), hi(7,5,6);
+  HalfGrid h(lo, hi);
+  DoubleGrid d(lo, hi), e(lo, hi);
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+      {
+        d(i,j,k) = 0.25*i - 0.5*j + k;
+        h(i,j,k) = d(i,j,k);
+      }
+  h(0,0,1) += 1.0;
+  double v = h(0,0,1);
+  BOOST_CHECK_EQUAL(v, 2.0);
+  h(0,0,1) = d(0,0,1);
+
+  // bulk conversion of whole grids
+  schnek::loadCompact(h, e);
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+        BOOST_REQUIRE_EQUAL(e(i,j,k), d(i,j,k));
+
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+        e(i,j,k) *= 0.5;
+  HalfGrid g(lo, hi);
+  schnek::storeCompact(e, g);
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+        BOOST_REQUIRE_EQUAL(g(i,j,k).getBits(), Half(0.5*d(i,j,k)).getBits());
+
+  HalfGrid small(lo, HalfGrid::IndexType(7,5,5));
+  BOOST_CHECK_THROW(schnek::storeCompact(e, small), schnek::ScheckException);
+
+  // grids with different storage layouts, the vector conversion rounds once
+  typedef schnek::Grid<Half, 3, GridBoostTestCheck, schnek::SingleArrayGridStorageFortran> FortranHalfGrid;
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::AlignedArrayGridStorage> AlignedDoubleGrid;
+  FortranHalfGrid f(lo, hi);
+  AlignedDoubleGrid a(lo, hi);
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+        a(i,j,k) = d(i,j,k) + ((k%2 == 0) ? 1.0/2048.0 + aboveTie : 0.0);
+  schnek::storeCompact(a, f);
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+        BOOST_REQUIRE_EQUAL(f(i,j,k).getBits(), Half(a(i,j,k)).getBits());
+  schnek::loadCompact(f, a);
+  schnek::storeCompact(a, g);
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+      {
+        BOOST_REQUIRE_EQUAL(a(i,j,k), float(f(i,j,k)));
+        BOOST_REQUIRE_EQUAL(g(i,j,k).getBits(), f(i,j,k).getBits());
+      }
+
+  std::vector<double> row(19);
+  std::vector<Half> compact(19);
+  for (int n=0; n<19; ++n) row[n] = (n%2 == 0) ? 1.0 + 1.0/2048.0 + aboveTie : 1.0 + 1.0/2048.0;
+  schnek::storeCompact(&row[0], &compact[0], 19);
+  for (int n=0; n<19; ++n) BOOST_REQUIRE_EQUAL(compact[n].getBits(), Half(row[n]).getBits());
+
+  // boundary exchange and accumulation on compact grids
+  typedef schnek::Grid<BFloat16, 2, GridBoostTestCheck> BGrid;
+  typedef BGrid::IndexType BIndexType;
+  schnek::SerialSubdivision<BGrid> subdivision;
+  subdivision.init(BIndexType(0,0), BIndexType(7,5), 1);
+  BGrid b(subdivision.getLo(), subdivision.getHi());
+  for (int i=0; i<=7; ++i)
+    for (int j=0; j<=5; ++j)
+      b(i,j) = i + 10*j;
+  subdivision.exchange(b);
+  BOOST_CHECK_EQUAL(float(b(0,2)), 6 + 20);
+  BOOST_CHECK_EQUAL(float(b(7,5)), 1 + 10);
+  subdivision.accumulate(b, 0);
+  BOOST_CHECK_EQUAL(float(b(1,3)), 2*(1 + 30));
+}
+
+struct RangeLineCounter
+{
+    int lines;
+    int positions;
+    RangeLineCounter() : lines(0), positions(0) {}
+    void operator()(const schnek::Array<int,3> &, int length)
+    {
+      ++lines;
+      positions += length;
+    }
+};
+
+template<class GridType>
+struct SpanCheckKernel
+{
+    const GridType *grid;
+    int dim;
+    std::ptrdiff_t count;
+    std::ptrdiff_t maxLength;
+    double sum;
+    bool contiguous;
+
+    SpanCheckKernel(const GridType &grid_)
+      : grid(&grid_), dim(grid_.getSpanDim()), count(0), maxLength(0), sum(0.0), contiguous(true) {}
+
+    void operator()(const double *data, std::ptrdiff_t length, const schnek::Array<int,3> &start)
+    {
+      schnek::Array<int,3> pos(start);
+      for (std::ptrdiff_t i=0; i<length; ++i)
+      {
+        if (&grid->get(pos) != data + i) contiguous = false;
+        sum += data[i];
+        ++pos[dim];
+      }
+      count += length;
+      maxLength = std::max(maxLength, length);
+    }
+};
+
+struct SpanScaleKernel
+{
+    double factor;
+    SpanScaleKernel(double factor_) : factor(factor_) {}
+    void operator()(double *data, std::ptrdiff_t length, const schnek::Array<int,3> &)
+    {
+      for (std::ptrdiff_t i=0; i<length; ++i) data[i] *= factor;
+    }
+};
+
+struct ElementSumKernel
+{
+    double sum;
+    ElementSumKernel() : sum(0.0) {}
+    void operator()(double v) { sum += v; }
+};
+
+template<class GridType>
+void test_span_traversal(std::ptrdiff_t expectedMaxLength)
+{
+  typedef typename GridType::IndexType IndexType;
+  typedef schnek::Range<int,3> RangeType;
+  IndexType lo(-3,2,-1), hi(6,9,20);
+  GridType g(lo,hi);
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+        g(i,j,k) = 1 + i + 100*j + 10000*k;
+
+  IndexType rlo(-1,3,0), rhi(4,9,18);
+  RangeType range(rlo, rhi);
+  double expectedSum = 0.0;
+  for (int i=rlo[0]; i<=rhi[0]; ++i)
+    for (int j=rlo[1]; j<=rhi[1]; ++j)
+      for (int k=rlo[2]; k<=rhi[2]; ++k)
+        expectedSum += g(i,j,k);
+
+  const GridType &cg = g;
+  SpanCheckKernel<GridType> check = cg.forEachSpan(range, SpanCheckKernel<GridType>(g));
+  BOOST_CHECK(check.contiguous);
+  BOOST_CHECK_EQUAL(check.count, 6*7*19);
+  BOOST_CHECK_EQUAL(check.sum, expectedSum);
+  BOOST_CHECK_EQUAL(check.maxLength, expectedMaxLength);
+  BOOST_CHECK_EQUAL(cg.forEach(range, ElementSumKernel()).sum, expectedSum);
+
+  g.forEachSpan(range, SpanScaleKernel(2.0));
+  BOOST_CHECK_EQUAL(g(rlo[0],rlo[1],rlo[2]), 2*(1 + rlo[0] + 100*rlo[1] + 10000*rlo[2]));
+  BOOST_CHECK_EQUAL(g(rhi[0],rhi[1],rhi[2]), 2*(1 + rhi[0] + 100*rhi[1] + 10000*rhi[2]));
+  BOOST_CHECK_EQUAL(g(lo[0],lo[1],lo[2]), 1 + lo[0] + 100*lo[1] + 10000*lo[2]);
+
+  // pack and unpack move the range to another part of the grid
+  std::vector<double> buffer(6*7*19 + 1, -1.0);
+  BOOST_CHECK_EQUAL(g.pack(range, &buffer[0]), 6*7*19);
+  BOOST_CHECK_EQUAL(buffer[6*7*19], -1.0);
+  RangeType target(IndexType(-3,2,-1), IndexType(2,8,17));
+  BOOST_CHECK_EQUAL(g.unpack(target, &buffer[0]), 6*7*19);
+  bool correct = true;
+  for (int i=0; i<6; ++i)
+    for (int j=0; j<7; ++j)
+      for (int k=0; k<19; ++k)
+        if (g(-3+i,2+j,-1+k) != 2*(1 + (rlo[0]+i) + 100*(rlo[1]+j) + 10000*(rlo[2]+k)))
+          correct = false;
+  BOOST_CHECK(correct);
+}
+
+BOOST_AUTO_TEST_CASE( grid_span_traversal )
+{
+  test_span_traversal<schnek::Grid<double, 3, GridBoostTestCheck> >(19);
+  test_span_traversal<schnek::Grid<double, 3, GridBoostTestCheck, schnek::SingleArrayGridStorageFortran> >(6);
+  test_span_traversal<schnek::Grid<double, 3, GridBoostTestCheck, schnek::AlignedArrayGridStorage> >(19);
+  test_span_traversal<schnek::Grid<double, 3, GridBoostTestCheck, schnek::TiledArrayGridStorage> >(8);
+  test_span_traversal<schnek::Grid<double, 3, GridBoostTestCheck, schnek::SparseTiledGridStorage> >(8);
+
+  // lines of a range
+  schnek::Range<int,3> range(schnek::Array<int,3>(0,1,2), schnek::Array<int,3>(3,4,9));
+  RangeLineCounter lines = range.forEachLine(1, RangeLineCounter());
+  BOOST_CHECK_EQUAL(lines.lines, 4*8);
+  BOOST_CHECK_EQUAL(lines.positions, 4*4*8);
+
+  // sub grids and component views
+  typedef schnek::Grid<double, 3, GridBoostTestCheck> GridType;
+  GridType g(GridType::IndexType(0,0,0), GridType::IndexType(9,9,9));
+  g = 1.0;
+  schnek::SubGrid<GridType> sub(GridType::IndexType(2,2,2), GridType::IndexType(7,7,5), g);
+  SpanCheckKernel<schnek::SubGrid<GridType> > subCheck
+    = sub.forEachSpan(schnek::Range<int,3>(sub.getLo(), sub.getHi()), SpanCheckKernel<schnek::SubGrid<GridType> >(sub));
+  BOOST_CHECK(subCheck.contiguous);
+  BOOST_CHECK_EQUAL(subCheck.maxLength, 4);
+  BOOST_CHECK_EQUAL(subCheck.sum, 6*6*4);
+
+  typedef schnek::MultiComponentGrid<double, 3, 2, schnek::ComponentInterleaved> InterleavedGrid;
+  InterleavedGrid m(InterleavedGrid::SpatialIndexType(0,0,0), InterleavedGrid::SpatialIndexType(3,3,3));
+  m = 1.0;
+  SpanCheckKernel<InterleavedGrid::ComponentType> viewCheck = m.component(1).forEachSpan(
+      schnek::Range<int,3>(m.getSpatialLo(), m.getSpatialHi()), SpanCheckKernel<InterleavedGrid::ComponentType>(m.component(1)));
+  BOOST_CHECK(viewCheck.contiguous);
+  BOOST_CHECK_EQUAL(viewCheck.maxLength, 1);
+  BOOST_CHECK_EQUAL(viewCheck.sum, 64.0);
+}
+
+BOOST_AUTO_TEST_CASE( grid_sparse_const_access )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::SparseTiledGridStorage> GridType;
+  typedef GridType::RangeType RangeType;
+  GridType::IndexType lo(-4,0,3), hi(35,20,30);
+  GridType g(lo,hi);
+  g.setFillValue(-1.0);
+  const GridType &cg = g;
+
+  // reading spans and packing do not allocate, spans run to the end of a tile
+  g(10,10,10) = 2.0;
+  RangeType range(GridType::IndexType(0,5,5), GridType::IndexType(20,15,25));
+  SpanCheckKernel<GridType> check = cg.forEachSpan(range, SpanCheckKernel<GridType>(cg));
+  BOOST_CHECK(check.contiguous);
+  BOOST_CHECK_EQUAL(check.maxLength, 8);
+  BOOST_CHECK_EQUAL(check.sum, 2.0 - (21*11*21 - 1));
+  std::vector<double> buffer(21*11*21);
+  BOOST_CHECK_EQUAL(cg.pack(range, &buffer[0]), 21*11*21);
+  BOOST_CHECK_EQUAL(g.getAllocatedTileCount(), 1);
+  BOOST_CHECK_EQUAL(cg.getSpanLength(GridType::IndexType(0,0,5)), 6);
+
+  // the exchange of the boundaries only allocates the ghost cells
+  g.clear();
+  g(10,10,10) = 2.0;
+  schnek::SerialSubdivision<GridType> subdivision;
+  subdivision.init(lo, hi, 2);
+  subdivision.exchange(g);
+  BOOST_CHECK(g.getAllocatedTileCount() < g.getTileCount());
+  BOOST_CHECK_EQUAL(cg(10,10,10), 2.0);
+}
+
+struct TileCountKernel
+{
+    schnek::Grid<int, 3> &count;
+    TileCountKernel(schnek::Grid<int, 3> &count_) : count(count_) {}
+    void operator()(const schnek::Range<int,3> &tile) const
+    {
+      schnek::Range<int,3> r(tile);
+      for (schnek::Range<int,3>::iterator it = r.begin(); it != r.end(); ++it)
+        ++count[*it];
+    }
+};
+
+struct NestedTileKernel
+{
+    schnek::Grid<int, 3> &count;
+    NestedTileKernel(schnek::Grid<int, 3> &count_) : count(count_) {}
+    void operator()(const schnek::Range<int,3> &tile) const
+    {
+      schnek::parallelFor(tile, schnek::Array<int,3>(1,1,4), TileCountKernel(count), schnek::DynamicSchedule);
+    }
+};
+
+struct ThrowingTileKernel
+{
+    void operator()(const schnek::Range<int,3> &tile) const
+    {
+      if (tile.getLo()[0] == 3) throw std::runtime_error("tile failed");
+    }
+};
+
+BOOST_AUTO_TEST_CASE( grid_parallel_for )
+{
+  typedef schnek::Array<int,3> IndexType;
+  typedef schnek::Range<int,3> RangeType;
+
+  schnek::ThreadPool &pool = schnek::ThreadPool::instance();
+  int threads = pool.getThreadCount();
+  pool.setThreadCount(4);
+  BOOST_CHECK_EQUAL(pool.getThreadCount(), 4);
+
+  RangeType range(IndexType(-2,0,1), IndexType(13,9,22));
+  schnek::RangeTiling<3> tiling(range, IndexType(4,4,8));
+  BOOST_CHECK_EQUAL(tiling.getTileCount(), 4*3*3);
+  BOOST_CHECK(tiling.getTile(0).getHi() == IndexType(1,3,8));
+  BOOST_CHECK(tiling.getTile(35).getLo() == IndexType(10,8,17));
+  BOOST_CHECK(tiling.getTile(35).getHi() == IndexType(13,9,22));
+
+  const schnek::Schedule schedules[] = {
+      schnek::StaticSchedule, schnek::DynamicSchedule, schnek::WorkStealingSchedule };
+  const IndexType tileSizes[] = { IndexType(1,10,22), IndexType(3,4,5), IndexType(1,1,1) };
+
+  for (int s=0; s<3; ++s)
+    for (int n=0; n<3; ++n)
+    {
+      schnek::Grid<int, 3> count(IndexType(-3,-1,0), IndexType(14,10,23));
+      count = 0;
+      schnek::parallelFor(range, tileSizes[n], TileCountKernel(count), schedules[s]);
+
+      int inside = 0, outside = 0;
+      for (int i=-3; i<=14; ++i)
+        for (int j=-1; j<=10; ++j)
+          for (int k=0; k<=23; ++k)
+          {
+            bool in = (i>=-2) && (i<=13) && (j>=0) && (j<=9) && (k>=1) && (k<=22);
+            if (in && (count(i,j,k) == 1)) ++inside;
+            if (!in && (count(i,j,k) != 0)) ++outside;
+          }
+      BOOST_CHECK_EQUAL(inside, 16*10*22);
+      BOOST_CHECK_EQUAL(outside, 0);
+    }
+
+  // slabs along the first dimension, nested loops run on the calling thread
+  schnek::Grid<int, 3> count(range.getLo(), range.getHi());
+  count = 0;
+  schnek::parallelFor(range, NestedTileKernel(count), schnek::WorkStealingSchedule);
+  int sum = 0;
+  for (int i=-2; i<=13; ++i)
+    for (int j=0; j<=9; ++j)
+      for (int k=1; k<=22; ++k) sum += count(i,j,k);
+  BOOST_CHECK_EQUAL(sum, 16*10*22);
+
+  // exceptions on any thread are reported to the caller
+  BOOST_CHECK_THROW(schnek::parallelFor(range, ThrowingTileKernel()), schnek::ScheckException);
+
+  // spans of a grid in parallel
+  schnek::Grid<double, 3> g(range.getLo(), range.getHi());
+  g = 1.5;
+  schnek::parallelForEachSpan(g, RangeType(IndexType(0,0,1), IndexType(13,9,22)), SpanScaleKernel(2.0),
+      schnek::DynamicSchedule);
+  BOOST_CHECK_EQUAL(g(-1,5,5), 1.5);
+  BOOST_CHECK_EQUAL(g(0,0,1), 3.0);
+  BOOST_CHECK_EQUAL(g(13,9,22), 3.0);
+
+  pool.setThreadCount(threads);
+}
+
+#ifdef CPU_COUNT
+/** Records the number of processors that each thread may run on */
+class AffinityJob : public schnek::ThreadPool::Job
+{
+  public:
+    std::vector<int> processors;
+    AffinityJob(int threadCount) : processors(threadCount, 0) {}
+    void execute(int thread, int)
+    {
+      cpu_set_t cpus;
+      if (pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0)
+        processors[thread] = CPU_COUNT(&cpus);
+    }
+};
+
+BOOST_AUTO_TEST_CASE( grid_thread_binding )
+{
+  schnek::ThreadPool &pool = schnek::ThreadPool::instance();
+  int threads = pool.getThreadCount();
+  bool binding = pool.getThreadBinding();
+  pool.setThreadCount(3);
+
+  cpu_set_t cpus;
+  BOOST_REQUIRE_EQUAL(sched_getaffinity(0, sizeof(cpus), &cpus), 0);
+  int available = CPU_COUNT(&cpus);
+
+  pool.setThreadBinding(true);
+  BOOST_CHECK(pool.getThreadBinding());
+  AffinityJob bound(3);
+  pool.run(bound);
+  for (int t=0; t<3; ++t) BOOST_CHECK_EQUAL(bound.processors[t], 1);
+
+  // threads started while the binding is active are bound as well
+  pool.setThreadCount(2);
+  AffinityJob restarted(2);
+  pool.run(restarted);
+  for (int t=0; t<2; ++t) BOOST_CHECK_EQUAL(restarted.processors[t], 1);
+
+  pool.setThreadBinding(false);
+  AffinityJob released(2);
+  pool.run(released);
+  for (int t=0; t<2; ++t) BOOST_CHECK_EQUAL(released.processors[t], available);
+
+  pool.setThreadBinding(binding);
+  pool.setThreadCount(threads);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE( grid_expression )
+{
+  typedef schnek::Array<int,3> IndexType;
+  typedef schnek::Grid<double, 3, GridBoostTestCheck> CGrid;
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::SingleArrayGridStorageFortran> FGrid;
+  typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::TiledArrayGridStorage> TGrid;
+
+  IndexType lo(-2,0,1), hi(5,7,12);
+  CGrid a(lo, hi), e(lo, hi);
+  FGrid b(lo, hi);
+  TGrid t(lo, hi);
+
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+      {
+        a(i,j,k) = i + 0.5*j - 0.25*k;
+        b(i,j,k) = 1.0 + i*j + k;
+        e(i,j,k) = 2.0;
+        t(i,j,k) = -k;
+      }
+
+  // contiguous operands of the same storage
+  CGrid r(lo, hi);
+  r = 2.0*a + a/4.0 - (-a);
+  // mixed storages are evaluated element by element
+  e = e + 0.5*(b - a)*e;
+  t -= a*t;
+  // a Field with one ghost cell that covers the same indices, and a sub-range
+  schnek::Field<double, 3, GridBoostTestCheck> f(IndexType(-1,1,2), IndexType(4,6,11),
+      schnek::Range<double,3>(schnek::Array<double,3>(0.0,0.0,0.0), schnek::Array<double,3>(1.0,1.0,1.0)),
+      schnek::Array<bool,3>(false,false,false), 1);
+  f = 1.0;
+  f.assign(schnek::Range<int,3>(f.getInnerLo(), f.getInnerHi()), f*a + 3);
+  f += a;
+  BOOST_CHECK(f.getLo() == lo);
+  BOOST_CHECK(f.getHi() == hi);
+
+  int errors = 0;
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+      {
+        double va = i + 0.5*j - 0.25*k;
+        double vb = 1.0 + i*j + k;
+        double vt = -k;
+        bool inner = (i>lo[0]) && (i<hi[0]) && (j>lo[1]) && (j<hi[1]) && (k>lo[2]) && (k<hi[2]);
+        if (!is_equal(r(i,j,k), 2.0*va + va/4.0 + va)) ++errors;
+        if (!is_equal(e(i,j,k), 2.0 + (vb - va))) ++errors;
+        if (!is_equal(t(i,j,k), vt - va*vt)) ++errors;
+        if (!is_equal(f(i,j,k), (inner ? va + 3 : 1.0) + va)) ++errors;
+      }
+  BOOST_CHECK_EQUAL(errors, 0);
+}
+
+template<class GridType>
+void test_stencil()
+{
+  typedef schnek::Array<int,3> IndexType;
+  IndexType lo(-1,0,-2), hi(9,6,17);
+  GridType u(lo, hi), v(lo, hi);
+  schnek::Grid<double, 3, GridBoostTestCheck> lap(lo, hi), curl(lo, hi);
+
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+      {
+        u(i,j,k) = i*i + 2.0*j*k - 0.5*k*k*k;
+        v(i,j,k) = std::sin(0.3*i) + std::cos(0.2*j*k);
+      }
+  lap = -1.0;
+  curl = -1.0;
+
+  schnek::Range<int,3> inner(IndexType(lo[0]+1, lo[1]+1, lo[2]+1), IndexType(hi[0]-1, hi[1]-1, hi[2]-1));
+  const double dx = 0.5;
+  lap.assign(inner, (schnek::shift<1,0,0>(u) + schnek::shift<-1,0,0>(u)
+                   + schnek::shift<0,1,0>(u) + schnek::shift<0,-1,0>(u)
+                   + schnek::shift<0,0,1>(u) + schnek::shift<0,0,-1>(u) - 6.0*u)/(dx*dx));
+  curl.assign(inner, (schnek::shift<0,1,0>(v) - v)/dx - (schnek::shift<0,0,1>(u) - u)/dx);
+
+  int errors = 0;
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+      {
+        bool in = (i>lo[0]) && (i<hi[0]) && (j>lo[1]) && (j<hi[1]) && (k>lo[2]) && (k<hi[2]);
+        double l = -1.0, c = -1.0;
+        if (in)
+        {
+          l = (u(i+1,j,k) + u(i-1,j,k) + u(i,j+1,k) + u(i,j-1,k) + u(i,j,k+1) + u(i,j,k-1) - 6.0*u(i,j,k))/(dx*dx);
+          c = (v(i,j+1,k) - v(i,j,k))/dx - (u(i,j,k+1) - u(i,j,k))/dx;
+        }
+        if (!is_equal(lap(i,j,k), l)) ++errors;
+        if (!is_equal(curl(i,j,k), c)) ++errors;
+      }
+  BOOST_CHECK_EQUAL(errors, 0);
+}
+
+BOOST_AUTO_TEST_CASE( grid_stencil )
+{
+  test_stencil<schnek::Grid<double, 3, GridBoostTestCheck> >();
+  test_stencil<schnek::Grid<double, 3, GridBoostTestCheck, schnek::SingleArrayGridStorageFortran> >();
+  test_stencil<schnek::Grid<double, 3, GridBoostTestCheck, schnek::TiledArrayGridStorage> >();
+  test_stencil<schnek::Grid<double, 3, GridBoostTestCheck, schnek::AlignedArrayGridStorage> >();
+
+  // one and two dimensional shifts
+  schnek::Grid<double, 1> a(schnek::Array<int,1>(0), schnek::Array<int,1>(9)), da(a);
+  schnek::Grid<double, 2> b(schnek::Array<int,2>(0,0), schnek::Array<int,2>(4,5)), db(b);
+  for (int i=0; i<10; ++i) a(i) = i*i;
+  for (int i=0; i<5; ++i)
+    for (int j=0; j<6; ++j) b(i,j) = i + 10*j;
+  da = 0.0;
+  db = 0.0;
+  da.assign(schnek::Range<int,1>(schnek::Array<int,1>(0), schnek::Array<int,1>(8)), schnek::shift<1>(a) - a);
+  db.assign(schnek::Range<int,2>(schnek::Array<int,2>(1,0), schnek::Array<int,2>(4,4)),
+      schnek::shift<-1,1>(b) - b);
+  BOOST_CHECK_EQUAL(da(3), 7.0);
+  BOOST_CHECK_EQUAL(da(9), 0.0);
+  BOOST_CHECK_EQUAL(db(2,3), 9.0);
+  BOOST_CHECK_EQUAL(db(0,3), 0.0);
+}
+
+template<class GridType>
+void test_reduction(int threads)
+{
+  typedef schnek::Array<int,3> IndexType;
+  typedef schnek::Range<int,3> RangeType;
+
+  schnek::ThreadPool &pool = schnek::ThreadPool::instance();
+  int oldThreads = pool.getThreadCount();
+  pool.setThreadCount(threads);
+
+  IndexType lo(-2,-1,0), hi(17,22,40);
+  GridType a(lo, hi), b(lo, hi);
+  schnek::Grid<double, 3, GridBoostTestCheck> w(lo, hi);
+  boost::random::mt19937 rng;
+  boost::random::uniform_real_distribution<> dist(-1.0, 1.0);
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+      {
+        a(i,j,k) = dist(rng);
+        b(i,j,k) = dist(rng);
+        w(i,j,k) = 0.5 + 0.1*k;
+      }
+  a(3,4,5) = 7.0;
+  a(10,2,33) = -9.0;
+  // a tie, the lower index wins
+  b(1,1,1) = 5.0;
+  b(12,0,3) = 5.0;
+
+  RangeType inner(IndexType(0,0,1), IndexType(15,20,39));
+  schnek::GridReduction<3> reduction;
+  int iSum = reduction.addSum(a);
+  int iSq = reduction.addSumSquares(a);
+  int iMin = reduction.addMin(a);
+  int iMax = reduction.addMax(b);
+  int iMinLoc = reduction.addMinLoc(a);
+  int iMaxLoc = reduction.addMaxLoc(b);
+  int iEnergy = reduction.addSum(a*a + b*b);
+  int iWeighted = reduction.addWeightedSum(a, w);
+  int iExpMax = reduction.addMax(2.0*a - b);
+  BOOST_CHECK_EQUAL(reduction.getCount(), 9);
+
+  schnek::SerialSubdivision<schnek::Grid<double, 3, GridBoostTestCheck> > subdivision;
+  reduction.execute(inner, subdivision);
+
+  double sum = 0.0, sq = 0.0, energy = 0.0, weighted = 0.0;
+  double mn = 1e10, mx = -1e10, expMax = -1e10;
+  for (int i=0; i<=15; ++i)
+    for (int j=0; j<=20; ++j)
+      for (int k=1; k<=39; ++k)
+      {
+        double va = a(i,j,k), vb = b(i,j,k);
+        sum += va;
+        sq += va*va;
+        energy += va*va + vb*vb;
+        weighted += va*w(i,j,k);
+        mn = std::min(mn, va);
+        mx = std::max(mx, vb);
+        expMax = std::max(expMax, 2.0*va - vb);
+      }
+
+  // sums of random numbers with both signs are compared with an absolute tolerance
+  BOOST_CHECK_SMALL(reduction.getValue(iSum) - sum, 1e-10);
+  BOOST_CHECK(is_equal(reduction.getValue(iSq), sq));
+  BOOST_CHECK(is_equal(reduction.getValue(iEnergy), energy));
+  BOOST_CHECK_SMALL(reduction.getValue(iWeighted) - weighted, 1e-10);
+  BOOST_CHECK_EQUAL(reduction.getValue(iMin), -9.0);
+  BOOST_CHECK_EQUAL(reduction.getValue(iMax), 5.0);
+  BOOST_CHECK_EQUAL(reduction.getValue(iExpMax), expMax);
+  BOOST_CHECK_EQUAL(reduction.getValue(iMinLoc), -9.0);
+  BOOST_CHECK(reduction.getPosition(iMinLoc) == IndexType(10,2,33));
+  BOOST_CHECK_EQUAL(reduction.getValue(iMaxLoc), 5.0);
+  BOOST_CHECK(reduction.getPosition(iMaxLoc) == IndexType(1,1,1));
+
+  // the result does not depend on earlier executions
+  double first = reduction.getValue(iSum);
+  reduction.execute(inner);
+  BOOST_CHECK_EQUAL(reduction.getValue(iSum), first);
+
+  // an empty range gives the neutral values
+  reduction.execute(RangeType(IndexType(1,1,1), IndexType(0,1,1)));
+  BOOST_CHECK_EQUAL(reduction.getValue(iSum), 0.0);
+  BOOST_CHECK(reduction.getValue(iMax) < -1e300);
+
+  pool.setThreadCount(oldThreads);
+}
+
+BOOST_AUTO_TEST_CASE( grid_reduction )
+{
+  test_reduction<schnek::Grid<double, 3, GridBoostTestCheck> >(1);
+  test_reduction<schnek::Grid<double, 3, GridBoostTestCheck> >(4);
+  test_reduction<schnek::Grid<double, 3, GridBoostTestCheck, schnek::SingleArrayGridStorageFortran> >(3);
+  test_reduction<schnek::Grid<double, 3, GridBoostTestCheck, schnek::TiledArrayGridStorage> >(4);
+
+  // combining entries is independent of the order
+  double e1[] = {schnek::ReduceMaxLoc, 2.0, 4.0, 1.0, schnek::ReduceSum, 1.5, 0.0, 0.0};
+  double e2[] = {schnek::ReduceMaxLoc, 2.0, 3.0, 7.0, schnek::ReduceSum, 2.0, 0.0, 0.0};
+  double r1[8], r2[8];
+  std::copy(e1, e1+8, r1);
+  std::copy(e2, e2+8, r2);
+  schnek::combineReductionEntries(e2, r1, 2, 4);
+  schnek::combineReductionEntries(e1, r2, 2, 4);
+  for (int i=0; i<8; ++i) BOOST_CHECK_EQUAL(r1[i], r2[i]);
+  BOOST_CHECK_EQUAL(r1[2], 3.0);
+  BOOST_CHECK_EQUAL(r1[5], 3.5);
+}
+
+
+template<class TargetType, class SourceType>
+void check_copy(const TargetType &target, const SourceType &source)
+{
+  typedef typename TargetType::value_type T;
+  typename SourceType::IndexType lo = source.getLo(), hi = source.getHi();
+  BOOST_CHECK(target.getLo() == lo);
+  BOOST_CHECK(target.getHi() == hi);
+  bool equal = true;
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+        equal = equal && (target(i,j,k) == static_cast<T>(source(i,j,k)));
+  BOOST_CHECK(equal);
+}
+
+BOOST_AUTO_TEST_CASE( grid_bulk_copy )
+{
+  typedef schnek::Array<int,3> IndexType;
+  typedef schnek::Grid<double, 3, GridBoostTestCheck> GridType;
+
+  IndexType lo(-2,1,0), hi(9,14,20);
+  GridType a(lo, hi);
+  boost::random::mt19937 rng;
+  boost::random::uniform_real_distribution<> dist(-1.0, 1.0);
+  for (int i=lo[0]; i<=hi[0]; ++i)
+    for (int j=lo[1]; j<=hi[1]; ++j)
+      for (int k=lo[2]; k<=hi[2]; ++k)
+        a(i,j,k) = dist(rng);
+
+  // identical layouts
+  GridType b(a);
+  check_copy(b, a);
+  GridType c(IndexType(0,0,0), IndexType(3,3,3));
+  c = a;
+  check_copy(c, a);
+
+  // conversion and different layouts
+  schnek::Grid<float, 3, GridBoostTestCheck> f;
+  f = a;
+  check_copy(f, a);
+  schnek::Grid<double, 3, GridBoostTestCheck, schnek::SingleArrayGridStorageFortran> fortran;
+  fortran = a;
+  check_copy(fortran, a);
+  schnek::Grid<double, 3, GridBoostTestCheck, schnek::TiledArrayGridStorage> tiled;
+  tiled = a;
+  check_copy(tiled, a);
+  schnek::Grid<float, 3, GridBoostTestCheck, schnek::SparseTiledGridStorage> sparse;
+  sparse = tiled;
+  check_copy(sparse, tiled);
+  GridType d;
+  d = fortran;
+  check_copy(d, a);
+
+  // sub grids are copied row by row into the base grid
+  GridType big(IndexType(-5,-5,-5), IndexType(20,20,30));
+  big = 3.0;
+  schnek::SubGrid<GridType> sub(lo, hi, big);
+  sub = a;
+  check_copy(sub, a);
+  BOOST_CHECK_EQUAL(big(1,2,3), a(1,2,3));
+  BOOST_CHECK_EQUAL(big(-3,2,3), 3.0);
+  BOOST_CHECK_EQUAL(big(1,2,21), 3.0);
+  schnek::Grid<float, 3, GridBoostTestCheck> e;
+  e = sub;
+  check_copy(e, a);
+
+  // fields
+  schnek::Field<double, 3, GridBoostTestCheck> field(lo, hi, schnek::Range<double,3>(schnek::Array<double,3>(0.0,0.0,0.0), schnek::Array<double,3>(1.0,1.0,1.0)), schnek::Array<bool,3>(false,false,false), 2);
+  field = a;
+  check_copy(field, a);
+  schnek::Field<float, 3, GridBoostTestCheck> fieldCopy;
+  fieldCopy = field;
+  check_copy(fieldCopy, field);
+}
+
+template<class GridType>
+void test_strided_access()
+{
+  typedef schnek::Array<int,3> IndexType;
+
+  GridType a(IndexType(-2,1,3), IndexType(5,4,10));
+  GridType b(IndexType(0,0,0), IndexType(2,6,1));
+  const GridType &ca = a;
+
+  bool match = true;
+  for (int i=-2; i<=5; ++i)
+    for (int j=1; j<=4; ++j)
+      for (int k=3; k<=10; ++k)
+      {
+        match = match && (&a.at(i,j,k) == &a(i,j,k)) && (&ca.at(i,j,k) == &a.get(IndexType(i,j,k)));
+        a.at(i,j,k) = i + 10*j + 100*k;
+      }
+  BOOST_CHECK(match);
+  BOOST_CHECK_EQUAL(a(3,2,7), 723.0);
+
+  // the strides follow the bounds when the grid is resized or swapped
+  a.swap(b);
+  BOOST_CHECK_EQUAL(b.at(3,2,7), 723.0);
+  BOOST_CHECK_EQUAL(&a.at(1,5,1), &a(1,5,1));
+  a.resize(IndexType(-1,-1,-1), IndexType(3,3,3));
+  BOOST_CHECK_EQUAL(&a.at(2,-1,3) - &a.at(1,-1,3), a.getStrides()[0]);
+  BOOST_CHECK_EQUAL(&a.at(2,3,-1), &a(2,3,-1));
+}
+
+BOOST_AUTO_TEST_CASE( grid_strided_access )
+{
+  test_strided_access<schnek::Grid<double, 3, GridBoostTestCheck> >();
+  test_strided_access<schnek::Grid<double, 3, GridBoostTestCheck, schnek::SingleArrayGridStorageFortran> >();
+  test_strided_access<schnek::Grid<double, 3, GridBoostTestCheck, schnek::LazyArrayGridStorage> >();
+  test_strided_access<schnek::Grid<double, 3, GridBoostTestCheck, schnek::PooledArrayGridStorage> >();
+  test_strided_access<schnek::Grid<double, 3, GridBoostTestCheck, schnek::AlignedArrayGridStorage> >();
+
+  schnek::Grid<double, 3> c(schnek::Array<int,3>(0,0,0), schnek::Array<int,3>(3,4,5));
+  BOOST_CHECK_EQUAL(c.getStrides()[0], 30);
+  BOOST_CHECK_EQUAL(c.getStrides()[1], 6);
+  BOOST_CHECK_EQUAL(c.getStrides()[2], 1);
+  schnek::Grid<double, 3, schnek::GridNoArgCheck, schnek::SingleArrayGridStorageFortran>
+    f(schnek::Array<int,3>(0,0,0), schnek::Array<int,3>(3,4,5));
+  BOOST_CHECK_EQUAL(f.getStrides()[0], 1);
+  BOOST_CHECK_EQUAL(f.getStrides()[1], 4);
+  BOOST_CHECK_EQUAL(f.getStrides()[2], 20);
+
+  // lower dimensions
+  schnek::Grid<int, 1> g1(schnek::Array<int,1>(-3), schnek::Array<int,1>(3));
+  schnek::Grid<int, 2> g2(schnek::Array<int,2>(-3,2), schnek::Array<int,2>(3,7));
+  BOOST_CHECK_EQUAL(&g1.at(-2), &g1(-2));
+  BOOST_CHECK_EQUAL(&g2.at(1,5), &g2(1,5));
+}
+
+BOOST_AUTO_TEST_CASE( grid_split_exchange )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck> GridType;
+  typedef GridType::IndexType IndexType;
+
+  schnek::SerialSubdivision<GridType> subdivision;
+  subdivision.init(IndexType(0,0,0), IndexType(9,7,5), 2);
+  GridType a(subdivision.getLo(), subdivision.getHi());
+  GridType b(subdivision.getLo(), subdivision.getHi());
+  a = -1.0;
+  b = -1.0;
+  schnek::Range<int,3> inner(subdivision.getInnerLo(), subdivision.getInnerHi());
+  for (schnek::Range<int,3>::iterator it = inner.begin(); it != inner.end(); ++it)
+  {
+    IndexType p = *it;
+    a[p] = b[p] = p[0] + 10*p[1] + 100*p[2];
+  }
+
+  subdivision.exchange(a);
+  subdivision.beginExchange(b);
+  subdivision.finishExchange(b);
+
+  bool equal = true;
+  schnek::Range<int,3> all(subdivision.getLo(), subdivision.getHi());
+  for (schnek::Range<int,3>::iterator it = all.begin(); it != all.end(); ++it)
+    equal = equal && (a[*it] == b[*it]);
+  BOOST_CHECK(equal);
+  BOOST_CHECK_EQUAL(b(0,3,2), 6 + 10*3 + 100*2);
+}
+
+BOOST_AUTO_TEST_CASE( grid_batch_exchange )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck> GridType;
+  typedef schnek::Grid<float, 3, GridBoostTestCheck, schnek::SingleArrayGridStorageFortran> FloatGridType;
+  typedef schnek::Grid<int, 3, GridBoostTestCheck, schnek::TiledArrayGridStorage> IntGridType;
+  typedef GridType::IndexType IndexType;
+
+  schnek::SerialSubdivision<GridType> subdivision;
+  subdivision.init(IndexType(0,0,0), IndexType(9,7,5), 2);
+  GridType a(subdivision.getLo(), subdivision.getHi());
+  GridType b(subdivision.getLo(), subdivision.getHi());
+  FloatGridType f(subdivision.getLo(), subdivision.getHi());
+  IntGridType n(subdivision.getLo(), subdivision.getHi());
+  a = -1.0;
+  b = -1.0;
+  f = -1.0;
+  n = -1;
+  schnek::Range<int,3> inner(subdivision.getInnerLo(), subdivision.getInnerHi());
+  for (schnek::Range<int,3>::iterator it = inner.begin(); it != inner.end(); ++it)
+  {
+    IndexType p = *it;
+    a[p] = b[p] = f[p] = n[p] = p[0] + 10*p[1] + 100*p[2];
+  }
+  subdivision.exchange(a);
+
+  schnek::HaloExchangeBatch<3> batch;
+  batch.add(b);
+  batch.add(f);
+  batch.add(n, 1);
+  BOOST_CHECK_EQUAL(batch.getCount(), 3);
+  subdivision.exchange(batch);
+
+  bool equal = true;
+  schnek::Range<int,3> all(subdivision.getLo(), subdivision.getHi());
+  for (schnek::Range<int,3>::iterator it = all.begin(); it != all.end(); ++it)
+    equal = equal && (a[*it] == b[*it]) && (a[*it] == f[*it]);
+  BOOST_CHECK(equal);
+
+  // only one layer of ghost cells is exchanged for n
+  BOOST_CHECK_EQUAL(n(1,3,2), a(1,3,2));
+  BOOST_CHECK_EQUAL(n(8,3,3), a(8,3,3));
+  BOOST_CHECK_EQUAL(n(0,3,2), -1);
+  BOOST_CHECK_EQUAL(n(9,3,3), -1);
+  BOOST_CHECK_EQUAL(n(4,1,1), a(4,1,1));
+}
+
+BOOST_AUTO_TEST_CASE( grid_accumulate_ghosts )
+{
+  typedef schnek::Grid<double, 3, GridBoostTestCheck> GridType;
+  typedef GridType::IndexType IndexType;
+
+  schnek::SerialSubdivision<GridType> subdivision;
+  subdivision.init(IndexType(0,0,0), IndexType(13,11,9), 2);
+  GridType a(subdivision.getLo(), subdivision.getHi());
+  GridType b(subdivision.getLo(), subdivision.getHi());
+  GridType c(subdivision.getLo(), subdivision.getHi());
+  schnek::Range<int,3> all(subdivision.getLo(), subdivision.getHi());
+  for (schnek::Range<int,3>::iterator it = all.begin(); it != all.end(); ++it)
+  {
+    IndexType p = *it;
+    a[p] = b[p] = c[p] = (7*p[0] + 3*p[1] + 11*p[2]) % 13;
+  }
+
+  subdivision.accumulate(a);
+  subdivision.accumulateGhosts(b, true);
+  subdivision.beginAccumulate(c);
+  subdivision.finishAccumulate(c);
+
+  bool equal = true;
+  for (schnek::Range<int,3>::iterator it = all.begin(); it != all.end(); ++it)
+    equal = equal && (a[*it] == b[*it]);
+  BOOST_CHECK(equal);
+
+  equal = true;
+  schnek::Range<int,3> inner(subdivision.getInnerLo(), subdivision.getInnerHi());
+  for (schnek::Range<int,3>::iterator it = inner.begin(); it != inner.end(); ++it)
+    equal = equal && (a[*it] == c[*it]);
+  BOOST_CHECK(equal);
+
+  // the ghost cells are left at zero
+  double ghostSum = 0.0;
+  for (schnek::Range<int,3>::iterator it = all.begin(); it != all.end(); ++it)
+    if (!inner.inside(*it)) ghostSum += std::abs(c[*it]);
+  BOOST_CHECK_EQUAL(ghostSum, 0.0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,292 @@
+/*
+ * test_mpisubdivision.cpp
+ *
+ *  Created on: 16 Oct 2026
+ *      Author: Holger Schmitz
+ *
+ *  The tests can be run on any number of processes. With a single process
+ *  every neighbour is the process itself.
+ */
+
+#include <grid/mpisubdivision.hpp>
+
+#ifdef SCHNEK_HAVE_MPI
+
+#include "utility.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+/** Initialises MPI for the whole test run, unless it has been initialised already */
+struct MpiFixture
+{
+    bool ownsMpi;
+
+    MpiFixture() : ownsMpi(false)
+    {
+      int initialised;
+      MPI_Initialized(&initialised);
+      if (!initialised)
+      {
+        MPI_Init(NULL, NULL);
+        ownsMpi = true;
+      }
+    }
+
+    ~MpiFixture()
+    {
+      if (ownsMpi) MPI_Finalize();
+    }
+};
+
+BOOST_GLOBAL_FIXTURE( MpiFixture );
+
+/** The subdivisions and grids shared by the tests */
+struct MpiSubdivisionTest
+{
+    typedef schnek::Grid<double, 3, GridBoostTestCheck> GridType;
+    typedef schnek::Grid<double, 3, GridBoostTestCheck, schnek::SingleArrayGridStorageFortran> FortranGridType;
+    typedef GridType::IndexType IndexType;
+    typedef schnek::Range<int, 3> RangeType;
+
+    /// The highest index of the global domain
+    IndexType globalHi;
+
+    MpiSubdivisionTest() : globalHi(15,13,11) {}
+
+    /// The value of the cell at the global position pos, wrapped into the periodic domain
+    double value(IndexType pos) const
+    {
+      for (int d=0; d<3; ++d)
+      {
+        int n = globalHi[d] + 1;
+        pos[d] = ((pos[d] % n) + n) % n;
+      }
+      return 1 + pos[0] + 100*pos[1] + 10000*pos[2];
+    }
+
+    /// Set the inner cells to value() and the ghost cells to -1
+    template<class Grid, class Subdivision>
+    void fill(Grid &grid, const Subdivision &subdivision) const
+    {
+      grid = -1.0;
+      RangeType inner(subdivision.getInnerLo(), subdivision.getInnerHi());
+      for (RangeType::iterator it = inner.begin(); it != inner.end(); ++it)
+        grid[*it] = value(*it);
+    }
+
+    /// Count the cells that do not hold value()
+    template<class Grid, class Subdivision>
+    int countWrong(const Grid &grid, const Subdivision &subdivision) const
+    {
+      int wrong = 0;
+      RangeType all(subdivision.getLo(), subdivision.getHi());
+      for (RangeType::iterator it = all.begin(); it != all.end(); ++it)
+        if (grid[*it] != value(*it)) ++wrong;
+      return subdivision.sumReduce(wrong);
+    }
+
+    /// Count the ghost cells that are not zero
+    template<class Grid, class Subdivision>
+    int countNonZeroGhosts(const Grid &grid, const Subdivision &subdivision) const
+    {
+      int nonZero = 0;
+      RangeType all(subdivision.getLo(), subdivision.getHi());
+      RangeType inner(subdivision.getInnerLo(), subdivision.getInnerHi());
+      for (RangeType::iterator it = all.begin(); it != all.end(); ++it)
+        if (!inner.inside(*it) && (grid[*it] != 0.0)) ++nonZero;
+      return subdivision.sumReduce(nonZero);
+    }
+
+    /** Exchange a grid with packed buffers and with subarray datatypes, both
+     *  blocking and split, and count the cells in which the results differ
+     *  or do not hold value()
+     */
+    template<class Grid>
+    int checkSubarrayExchange() const
+    {
+      typedef schnek::MPICartSubdivision<Grid> Subdivision;
+      Subdivision subdivision;
+      subdivision.init(IndexType(0,0,0), globalHi, 2);
+      RangeType all(subdivision.getLo(), subdivision.getHi());
+
+      Grid packed(subdivision.getLo(), subdivision.getHi());
+      fill(packed, subdivision);
+      subdivision.setExchangeMode(Subdivision::PackedExchange);
+      subdivision.exchange(packed);
+
+      Grid subarray(subdivision.getLo(), subdivision.getHi());
+      fill(subarray, subdivision);
+      subdivision.setExchangeMode(Subdivision::SubarrayExchange);
+      subdivision.exchange(subarray);
+
+      Grid split(subdivision.getLo(), subdivision.getHi());
+      fill(split, subdivision);
+      subdivision.beginExchange(split);
+      subdivision.finishExchange(split);
+
+      return countWrong(packed, subdivision)
+          + countDifferent(packed, subarray, all, subdivision)
+          + countDifferent(packed, split, all, subdivision);
+    }
+
+    /// Count the cells in which two grids differ
+    template<class Grid1, class Grid2, class Subdivision>
+    int countDifferent(const Grid1 &a, const Grid2 &b, RangeType range, const Subdivision &subdivision) const
+    {
+      int different = 0;
+      for (RangeType::iterator it = range.begin(); it != range.end(); ++it)
+        if (a[*it] != b[*it]) ++different;
+      return subdivision.sumReduce(different);
+    }
+};
+
+BOOST_AUTO_TEST_SUITE( mpisubdivision )
+
+BOOST_FIXTURE_TEST_CASE( mpi_split_exchange, MpiSubdivisionTest )
+{
+  schnek::MPICartSubdivision<GridType> subdivision;
+  subdivision.init(IndexType(0,0,0), globalHi, 2);
+
+  GridType a(subdivision.getLo(), subdivision.getHi());
+  fill(a, subdivision);
+  subdivision.exchange(a);
+  BOOST_CHECK_EQUAL(countWrong(a, subdivision), 0);
+
+  GridType b(subdivision.getLo(), subdivision.getHi());
+  fill(b, subdivision);
+  subdivision.beginExchange(b);
+  subdivision.finishExchange(b);
+  BOOST_CHECK_EQUAL(countWrong(b, subdivision), 0);
+
+  // pipelined through the dimensions
+  GridType c(subdivision.getLo(), subdivision.getHi());
+  fill(c, subdivision);
+  subdivision.beginExchange(c, 0);
+  subdivision.continueExchange(c, 1);
+  subdivision.continueExchange(c, 2);
+  subdivision.finishExchange(c, 2);
+  BOOST_CHECK_EQUAL(countWrong(c, subdivision), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE( mpi_subarray_exchange, MpiSubdivisionTest )
+{
+  BOOST_CHECK_EQUAL(checkSubarrayExchange<GridType>(), 0);
+  BOOST_CHECK_EQUAL(checkSubarrayExchange<FortranGridType>(), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE( mpi_accumulate_ghosts, MpiSubdivisionTest )
+{
+  schnek::MPICartSubdivision<GridType> subdivision;
+  subdivision.init(IndexType(0,0,0), globalHi, 2);
+  RangeType all(subdivision.getLo(), subdivision.getHi());
+  RangeType inner(subdivision.getInnerLo(), subdivision.getInnerHi());
+
+  GridType reference(subdivision.getLo(), subdivision.getHi());
+  GridType ghosts(subdivision.getLo(), subdivision.getHi());
+  GridType refreshed(subdivision.getLo(), subdivision.getHi());
+  GridType split(subdivision.getLo(), subdivision.getHi());
+  for (RangeType::iterator it = all.begin(); it != all.end(); ++it)
+    reference[*it] = ghosts[*it] = refreshed[*it] = split[*it] = value(*it) + subdivision.procnum();
+
+  subdivision.accumulate(reference);
+  subdivision.accumulateGhosts(ghosts);
+  subdivision.accumulateGhosts(refreshed, true);
+  subdivision.beginAccumulate(split);
+  subdivision.finishAccumulate(split);
+
+  BOOST_CHECK_EQUAL(countDifferent(reference, ghosts, inner, subdivision), 0);
+  BOOST_CHECK_EQUAL(countNonZeroGhosts(ghosts, subdivision), 0);
+  BOOST_CHECK_EQUAL(countDifferent(reference, refreshed, all, subdivision), 0);
+  BOOST_CHECK_EQUAL(countDifferent(reference, split, inner, subdivision), 0);
+  BOOST_CHECK_EQUAL(countNonZeroGhosts(split, subdivision), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE( mpi_exchange_plan, MpiSubdivisionTest )
+{
+  schnek::MPICartSubdivision<GridType> subdivision;
+  subdivision.init(IndexType(0,0,0), globalHi, 2);
+  RangeType all(subdivision.getLo(), subdivision.getHi());
+
+  GridType reference(subdivision.getLo(), subdivision.getHi());
+  GridType planned(subdivision.getLo(), subdivision.getHi());
+  schnek::MPIExchangePlan<GridType> plan(subdivision, planned);
+
+  // the plan reuses its persistent requests in every step
+  for (int step=0; step<2; ++step)
+  {
+    fill(reference, subdivision);
+    fill(planned, subdivision);
+    subdivision.exchange(reference);
+    plan.exchange();
+    BOOST_CHECK_EQUAL(countWrong(planned, subdivision), 0);
+    BOOST_CHECK_EQUAL(countDifferent(reference, planned, all, subdivision), 0);
+
+    for (RangeType::iterator it = all.begin(); it != all.end(); ++it)
+      reference[*it] = planned[*it] = value(*it) + step + subdivision.procnum();
+    for (int d=0; d<3; ++d) subdivision.accumulate(reference, d);
+    plan.accumulate();
+    BOOST_CHECK_EQUAL(countDifferent(reference, planned, all, subdivision), 0);
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE( mpi_exchange_plan_empty, MpiSubdivisionTest )
+{
+  // without ghost cells the buffers of the plan are empty
+  schnek::MPICartSubdivision<GridType> subdivision;
+  subdivision.init(IndexType(0,0,0), globalHi, 0);
+
+  GridType grid(subdivision.getLo(), subdivision.getHi());
+  schnek::MPIExchangePlan<GridType> plan(subdivision, grid);
+  fill(grid, subdivision);
+  plan.exchange();
+  plan.accumulate();
+  BOOST_CHECK_EQUAL(countWrong(grid, subdivision), 0);
+}
+
+/** Reduction entries whose results depend on the number of processes */
+void fillReductionEntries(std::vector<double> &entries, int p)
+{
+  double values[] = {
+    schnek::ReduceSum, p + 1.0, 0, 0, 0,
+    schnek::ReduceMin, 10.0 - p, 0, 0, 0,
+    schnek::ReduceMaxLoc, p % 2, 5.0 - p, p, 1,
+    schnek::ReduceMinLoc, 3.0, p % 2, -p, 0
+  };
+  entries.assign(values, values + 20);
+}
+
+BOOST_FIXTURE_TEST_CASE( mpi_reduce_entries, MpiSubdivisionTest )
+{
+  schnek::MPICartSubdivision<GridType> subdivision;
+  subdivision.init(IndexType(0,0,0), globalHi, 1);
+  int n = subdivision.procCount();
+  int maxValue = (n > 1) ? 1 : 0;
+  int lastWithMax = ((n - 1) % 2 == maxValue) ? n - 1 : n - 2;
+  int lastEven = ((n - 1) % 2 == 0) ? n - 1 : n - 2;
+
+  // the single collective operation and the default implementation agree
+  for (int impl=0; impl<2; ++impl)
+  {
+    std::vector<double> entries;
+    fillReductionEntries(entries, subdivision.procnum());
+    if (impl == 0)
+      subdivision.reduceEntries(entries, 5);
+    else
+      subdivision.schnek::DomainSubdivision<GridType>::reduceEntries(entries, 5);
+
+    BOOST_CHECK_EQUAL(entries[1], n*(n + 1)/2);
+    BOOST_CHECK_EQUAL(entries[6], 11 - n);
+    BOOST_CHECK_EQUAL(entries[11], maxValue);
+    BOOST_CHECK_EQUAL(entries[12], 5 - lastWithMax);
+    BOOST_CHECK_EQUAL(entries[13], lastWithMax);
+    BOOST_CHECK_EQUAL(entries[16], 3.0);
+    BOOST_CHECK_EQUAL(entries[17], 0);
+    BOOST_CHECK_EQUAL(entries[18], -lastEven);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif // SCHNEK_HAVE_MPI